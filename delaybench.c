@@ -0,0 +1,228 @@
+/*
+  A C program to benchmark the delay functions in mmTime.c against plain nanosleep.
+  For each requested delay it prints the distribution of the actual delays.
+
+$ gcc -c -o mmTime.o mmTime.c
+$ gcc -c -o delaybench.o delaybench.c
+$ gcc -o delaybench delaybench.o mmTime.o mmHist.o mmRt.o
+$ ./delaybench [-n <iterations>] [-t] [-j [-p <priority>] [-a <cpu>] [-l <load>]]
+
+  With -t (needs root) the BCM system timer is mapped and used as spin clock.
+  With -j it measures timer wakeup latency instead: how late a thread sleeping
+  until an absolute time on a 1ms period wakes up, first as it is, then in the
+  real-time mode of mmRt.c (SCHED_FIFO at -p, pinned to -a, memory locked),
+  optionally with -l processes spinning to load the CPUs. Without root the
+  real-time steps that are not allowed are reported and skipped.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <unistd.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <time.h>
+#include <signal.h>
+#include <sys/mman.h>
+#include <sys/prctl.h>
+#include <sys/wait.h>
+
+#include "mmTime.h"
+#include "mmHist.h"
+#include "mmRt.h"
+
+#define BLOCK_SIZE (4*1024)
+
+/* requested delays, in us */
+static const unsigned int requests[] = { 1, 5, 10, 50, 100, 200, 500, 1000, 2000, 5000 };
+#define NREQ (sizeof(requests)/sizeof(requests[0]))
+
+/* wakeup latency (-j): period of the sleeps, in us, and default number of wakeups */
+#define JITTER_PERIOD  1000
+#define JITTER_WAKEUPS 5000
+#define LOAD_MAX       64
+
+static int cmpUint64(const void *a, const void *b)
+{
+  uint64_t x = *(const uint64_t *)a, y = *(const uint64_t *)b;
+
+  return (x > y) - (x < y);
+}
+
+static void plainSleep(unsigned int us)
+{
+  struct timespec sleeper;
+
+  sleeper.tv_sec  = us / 1000000;
+  sleeper.tv_nsec = (long)(us % 1000000) * 1000L;
+  nanosleep(&sleeper, NULL);
+}
+
+/* time @n@ calls of @fct@ and print min/median/p90/p99/max of the actual delay in us */
+static void measure(const char *name, void (*fct)(unsigned int), unsigned int us, int n, uint64_t *samples)
+{
+  uint64_t t0;
+  int i;
+
+  for (i = 0; i < n; i++) {
+    t0 = delayNowNs();
+    fct(us);
+    samples[i] = delayNowNs() - t0;
+  }
+  qsort(samples, n, sizeof(uint64_t), cmpUint64);
+  fprintf(stdout, "%-18s %8u %10.1f %10.1f %10.1f %10.1f %10.1f\n", name, us,
+	  samples[0] / 1000.0, samples[n / 2] / 1000.0, samples[(n * 9) / 10] / 1000.0,
+	  samples[(n * 99) / 100] / 1000.0, samples[n - 1] / 1000.0);
+}
+
+/* sleep until each multiple of JITTER_PERIOD in turn, and record how late the wakeup is */
+static void wakeups(struct mmHist *h, int n)
+{
+  struct timespec next, now;
+  uint64_t due;
+  int i;
+
+  /* the clock slept on, not the clock in use: the wake-up latency of the kernel */
+  clock_gettime(CLOCK_MONOTONIC, &next);
+  for (i = 0; i < n; i++) {
+    next.tv_nsec += JITTER_PERIOD * 1000L;
+    if (next.tv_nsec >= 1000000000L) {
+      next.tv_nsec -= 1000000000L;
+      next.tv_sec++;
+    }
+    while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &next, NULL) == EINTR)
+      ;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    due = (uint64_t)next.tv_sec * 1000000000ULL + (uint64_t)next.tv_nsec;
+    histRecord(h, (uint64_t)now.tv_sec * 1000000000ULL + (uint64_t)now.tv_nsec - due);
+  }
+}
+
+static void printJitter(const struct mmHist *h)
+{
+  fprintf(stdout, "%-50s %6llu %9.1f %9.1f %9.1f %9.1f %9.1f\n", h->name, (unsigned long long)h->count,
+	  histPercentile(h, 50) / 1e3, histPercentile(h, 90) / 1e3, histPercentile(h, 99) / 1e3,
+	  histPercentile(h, 99.9) / 1e3, h->max / 1e3);
+}
+
+/* -j: wakeup latency without, then with the real-time mode, under @load@ spinning processes */
+static void jitter(int n, int load, int priority, int cpu)
+{
+  pid_t pids[LOAD_MAX];
+  struct mmHist plain, rt;
+  char mode[64], name[80];
+  int i, got;
+
+  for (i = 0; i < load; i++)
+    if ((pids[i] = fork()) == 0) {
+      prctl(PR_SET_PDEATHSIG, SIGKILL);	// no spinning orphans
+      for (;;)
+	;
+    }
+
+  fprintf(stdout, "Timer wakeup latency in us, %d wakeups every %dus, %d processes of load\n",
+	  n, JITTER_PERIOD, load);
+  fprintf(stdout, "%-50s %6s %9s %9s %9s %9s %9s\n", "mode", "n", "p50", "p90", "p99", "p99.9", "max");
+  histInit(&plain, "normal");
+  wakeups(&plain, n);
+  printJitter(&plain);
+
+  got = rtEnter(priority, cpu, stderr);
+  rtDescribe(got, priority, cpu, mode, sizeof(mode));
+  snprintf(name, sizeof(name), "real-time (%s)", mode);
+  histInit(&rt, name);
+  wakeups(&rt, n);
+  printJitter(&rt);
+
+  for (i = 0; i < load; i++)
+    if (pids[i] > 0) {
+      kill(pids[i], SIGKILL);
+      waitpid(pids[i], NULL, 0);
+    }
+}
+
+int main (int argc, char **argv) {
+  int n = 0, use_timer = 0, fd = -1;
+  int jitterMode = 0, load = 0, priority = RT_PRIO_DEFAULT, cpu = -1;
+  uint32_t *timer = NULL;
+  uint64_t *samples;
+  unsigned int r;
+
+  {
+    int opt;
+    while ((opt = getopt(argc, argv, "hn:tjp:a:l:")) != -1) {
+      switch (opt) {
+      case 'n':
+	n = atoi(optarg);
+	break;
+      case 't':
+	use_timer = 1;
+	break;
+      case 'j':
+	jitterMode = 1;
+	break;
+      case 'p':
+	priority = atoi(optarg);
+	break;
+      case 'a':
+	cpu = atoi(optarg);
+	break;
+      case 'l':
+	load = atoi(optarg);
+	break;
+      default: /* '?' */
+	fprintf(stderr, "Usage: %s [-h] [-n <iterations>] [-t] [-j [-p <priority>] [-a <cpu>] [-l <load>]]\n", argv[0]);
+	exit(opt == 'h' ? EXIT_SUCCESS : EXIT_FAILURE);
+      }
+    }
+  }
+  if (n < 1)
+    n = (jitterMode ? JITTER_WAKEUPS : 200);
+
+  if (jitterMode) {
+    if (priority < 1 || priority > 99 || load < 0 || load > LOAD_MAX) {
+      fprintf(stderr, "Priority must be 1 to 99, and load 0 to %d\n", LOAD_MAX);
+      exit(EXIT_FAILURE);
+    }
+    jitter(n, load, priority, cpu);
+    return 0;
+  }
+
+  if (use_timer) {
+    if ((fd = open("/dev/mem", O_RDONLY | O_SYNC | O_CLOEXEC)) < 0) {
+      fprintf(stderr, "Unable to open /dev/mem: %s\n", strerror(errno));
+      exit(EXIT_FAILURE);
+    }
+    timer = (uint32_t *)mmap(0, BLOCK_SIZE, PROT_READ, MAP_SHARED, fd, SYSTIMER_BASE);
+    if (timer == MAP_FAILED) {
+      fprintf(stderr, "mmap (system timer) failed: %s\n", strerror(errno));
+      exit(EXIT_FAILURE);
+    }
+  }
+
+  samples = (uint64_t *)malloc(n * sizeof(uint64_t));
+  if (samples == NULL) {
+    fprintf(stderr, "Memory allocation failed\n");
+    exit(EXIT_FAILURE);
+  }
+
+  delayInit(timer);
+  fprintf(stdout, "Calibrated nanosleep overshoot: %uus; spin clock: %s; %d iterations\n",
+	  delaySlack(), (timer != NULL ? "system timer" : "CLOCK_MONOTONIC_RAW"), n);
+  fprintf(stdout, "%-18s %8s %10s %10s %10s %10s %10s\n",
+	  "function", "req(us)", "min", "p50", "p90", "p99", "max");
+
+  for (r = 0; r < NREQ; r++) {
+    measure("nanosleep", plainSleep, requests[r], n, samples);
+    measure("delayMicroseconds", delayMicroseconds, requests[r], n, samples);
+  }
+
+  free(samples);
+  if (timer != NULL)
+    munmap(timer, BLOCK_SIZE);
+  if (fd >= 0)
+    close(fd);
+
+  return 0;
+}
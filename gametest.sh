@@ -0,0 +1,81 @@
+#!/bin/bash
+# End-to-end tests of whole games: master-mind on simulated hardware and the
+# virtual clock (-V), with the button pressed by a scripted player
+
+# function to check output from running $cmd against expected output
+check () {
+    echo "Cmd: $cmd"
+    echo "Output: \n$out"
+    echo "Expected: \n$exp"
+    if [ "$out" = "$exp" ]
+    then echo ".. OK"
+	 ok=$(( $ok + 1))
+    else echo "** WRONG"
+	 ret=1
+    fi
+    n=$(( $n + 1))
+}
+
+# name of the application to run
+cw=master-mind
+# return code; 0 = ok, anything else is an error
+ret=0
+ok=0
+n=0
+dir=`mktemp -d`
+trap 'rm -rf $dir' EXIT
+
+# -------------------------------------------------------
+# a fixed secret, found by the third guess of the script, in every game
+
+cat > $dir/win.mms <<EOS
+games 1000
+guess 123
+guess 321
+guess 231
+EOS
+cmd="./${cw} -F -s 231 -V $dir/win.mms -L $dir/win.log"
+$cmd < /dev/null > /dev/null
+out="`./mmlogsum $dir/win.log | head -5`"
+exp=$(cat <<EOS
+1000 games: 1000 won, 0 lost, 0 abandoned
+Guesses needed by the games won:
+  1:         0    0.0%
+  2:         0    0.0%
+  3:      1000  100.0%
+EOS
+)
+check
+
+# -------------------------------------------------------
+# random secrets, with the full start-up and a start prompt per game: the same
+# games, with the same output and the same log (stamped in virtual time), every time
+
+cat > $dir/play.mms <<EOS
+games 2000
+guess 1122
+guess 3344
+guess 5566
+guess 1234
+guess 4321
+EOS
+cmd="./${cw} -l 4 -c 6 -V $dir/play.mms -L $dir/play1.log"
+$cmd < /dev/null > $dir/play1.out
+./${cw} -l 4 -c 6 -V $dir/play.mms -L $dir/play2.log < /dev/null > $dir/play2.out 2> /dev/null
+out="`./mmlogsum $dir/play1.log | head -1 | cut -d: -f1 ; cmp $dir/play1.out $dir/play2.out && echo same output ; cmp $dir/play1.log $dir/play2.log && echo same log`"
+exp=$(cat <<EOS
+2000 games
+same output
+same log
+EOS
+)
+check
+
+cmd="./mmlogsum $dir/play1.log $dir/play2.log"
+out="`./mmlogsum $dir/play1.log | tail -n +2`"
+exp="`./mmlogsum $dir/play2.log | tail -n +2`"
+check
+
+# return status code (0 for ok, 1 for not)
+echo "$ok of $n tests are OK"
+exit $ret
@@ -1,10 +1,100 @@
 /* ***************************************************************************** */
 /* Low-level hardware control functions for Raspberry Pi                         */
 /* Implements GPIO control for LEDs, buttons and LCD devices                     */
-/* Uses inline ARM assembly for direct hardware access                           */
+/* Uses inline ARM assembly for direct hardware access; plain C versions are     */
+/* used on other hosts, where the registers can only be simulated                */
 /* ***************************************************************************** */
 
 #include "lcdBinary.h"
+#include "mmTrace.h"
+
+/* called after every pin write, if set; see gpioSetWriteHook() */
+static gpioWriteHook writeHook = NULL;
+
+void gpioSetWriteHook(gpioWriteHook hook) {
+    writeHook = hook;
+}
+
+/* called after every masked write, if set; see gpioSetMaskHook() */
+static gpioMaskHook maskHook = NULL;
+
+void gpioSetMaskHook(gpioMaskHook hook) {
+    maskHook = hook;
+}
+
+/* called every polling period while waiting for the button, and from idleDelay() */
+static idleHookFn idleHook = NULL;
+
+void setIdleHook(idleHookFn hook) {
+    idleHook = hook;
+}
+
+/* latency from a button edge to the recognised (debounced) press */
+static struct mmHist *pressHist = NULL;
+static uint64_t lastPress = 0;
+
+void buttonSetLatencyHist(struct mmHist *edgeToPress) {
+    pressHist = edgeToPress;
+}
+
+uint64_t buttonLastPress(void) {
+    return lastPress;
+}
+
+/* replaces the GPLEV read, if set; see buttonSetReadHook() */
+static buttonReadHook readHook = NULL;
+
+void buttonSetReadHook(buttonReadHook hook) {
+    readHook = hook;
+}
+
+/* time spent in the input functions, counted in requested sleeps: it only */
+/* depends on the levels read, so a replayed recording sees the same times  */
+static uint64_t inputMs = 0;
+
+uint64_t buttonInputMs(void) {
+    return inputMs;
+}
+
+/* sleep for @ms@ while waiting for the button, and count it as input time; */
+/* on the clock in use, so no time passes on a virtual one (see mmTime.h)  */
+static void inputSleep(unsigned int ms) {
+    delaySleepNs((uint64_t)ms * 1000000ULL);
+    inputMs += ms;
+}
+
+/* the input functions return early while this is set; see buttonSetAbort() */
+static volatile sig_atomic_t *abortFlag = NULL;
+
+void buttonSetAbort(volatile sig_atomic_t *flag) {
+    abortFlag = flag;
+}
+
+int buttonAborted(void) {
+    return abortFlag != NULL && *abortFlag;
+}
+
+static void runIdle(void) {
+    if (idleHook != NULL)
+        idleHook();
+}
+
+/* Delay for @howLong@ ms, running the idle hook every IDLE_PERIOD ms */
+void idleDelay(unsigned int howLong) {
+    uint64_t end = delayNowNs() + (uint64_t)howLong * 1000000ULL;
+    uint64_t now;
+    
+    for (;;) {
+        runIdle();
+        now = delayNowNs();
+        if (now >= end || buttonAborted())
+            break;
+        if (end - now > IDLE_PERIOD * 1000000ULL)
+            delay(IDLE_PERIOD);
+        else
+            delayMicroseconds((unsigned int)((end - now) / 1000));
+    }
+}
 
 // -----------------------------------------------------------------------------
 // GPIO control functions
@@ -14,6 +104,8 @@ void digitalWrite(uint32_t *gpio, int pin, int value) {
     int offset = pin / 32;
     int shift = pin % 32;
     
+    TRACE_INSTANT(value == LOW ? "gpio clr" : "gpio set", pin);
+#if defined(__arm__)
     if (value == LOW) {
         /* Use GPCLR register to clear the pin */
         asm volatile (
@@ -35,6 +127,34 @@ void digitalWrite(uint32_t *gpio, int pin, int value) {
             : "r3"
         );
     }
+#else
+    /* GPCLR0 is word 10, GPSET0 is word 7 */
+    ((volatile uint32_t *)gpio)[offset + (value == LOW ? 10 : 7)] = 1u << shift;
+#endif
+    
+    if (writeHook != NULL)
+        writeHook(gpio, pin, value);
+}
+
+/* Set the pins in @set@ and clear those in @clr@, all in bank 0 (GPIO 0-31), */
+/* e.g. all data lines of the LCD, with one store to each register            */
+void digitalWriteMask(uint32_t *gpio, uint32_t set, uint32_t clr) {
+    TRACE_INSTANT("gpio mask", set);
+#if defined(__arm__)
+    asm volatile (
+        "str %[set], [%[gpio], #28] \n\t"    /* GPSET0 */
+        "str %[clr], [%[gpio], #40] \n\t"    /* GPCLR0 */
+        :
+        : [gpio] "r" (gpio), [set] "r" (set), [clr] "r" (clr)
+        : "memory"
+    );
+#else
+    ((volatile uint32_t *)gpio)[7] = set;
+    ((volatile uint32_t *)gpio)[10] = clr;
+#endif
+
+    if (maskHook != NULL)
+        maskHook(gpio, set, clr);
 }
 
 // adapted from setPinMode
@@ -42,6 +162,7 @@ void pinMode(uint32_t *gpio, int pin, int mode) {
     int fSel = pin / 10;
     int shift = (pin % 10) * 3;
     
+#if defined(__arm__)
     asm volatile (
         /* Read current value of the GPFSEL register */
         "ldr r3, [%[gpio], %[fSel], lsl #2] \n\t"
@@ -62,6 +183,11 @@ void pinMode(uint32_t *gpio, int pin, int mode) {
         : [gpio] "r" (gpio), [fSel] "r" (fSel), [shift] "r" (shift), [mode] "r" (mode)
         : "r2", "r3", "cc"
     );
+#else
+    volatile uint32_t *fsel = (volatile uint32_t *)gpio + fSel;
+    
+    *fsel = (*fsel & ~(7u << shift)) | ((uint32_t)mode << shift);
+#endif
 }
 
 void writeLED(uint32_t *gpio, int led, int value) {
@@ -73,14 +199,21 @@ void writeLED(uint32_t *gpio, int led, int value) {
 }
 
 int readButton(uint32_t *gpio, int button) {
+    /* Set the pin as INPUT */
+    pinMode(gpio, button, INPUT);
+    
+    if (readHook != NULL)
+        return readHook(gpio, button);
+    return readButtonLevel(gpio, button);
+}
+
+int readButtonLevel(uint32_t *gpio, int button) {
     int result;
     int offset = button / 32;
     int shift = button % 32;
     
-    /* Set the pin as INPUT */
-    pinMode(gpio, button, INPUT);
-    
     /* Read the pin value from GPLEV register */
+#if defined(__arm__)
     asm volatile (
         "mov r3, #1 \n\t"
         "lsl r3, r3, %[shift] \n\t"
@@ -93,6 +226,10 @@ int readButton(uint32_t *gpio, int button) {
         : [gpio] "r" (gpio + offset), [shift] "r" (shift)
         : "r2", "r3", "cc"
     );
+#else
+    /* GPLEV0 is word 13 */
+    result = (((volatile uint32_t *)gpio)[offset + 13] >> shift) & 1;
+#endif
     
     return result;
 }
@@ -104,23 +241,28 @@ int readButton(uint32_t *gpio, int button) {
 int detectButtonPress(uint32_t *gpio, int button) {
     static int prevState = LOW;
     int currState = readButton(gpio, button);
-    struct timespec sleeper, dummy;
     
     /* If button state changed from not pressed to pressed */
     if (currState == HIGH && prevState == LOW) {
+        uint64_t edge = histNowNs();
+        
+        TRACE_INSTANT("button edge", HIGH);
         /* Debounce delay */
-        sleeper.tv_sec = 0;
-        sleeper.tv_nsec = 50 * 1000000; /* 50ms */
-        nanosleep(&sleeper, &dummy);
+        inputSleep(50);
         
         /* Check if button is still pressed */
         currState = readButton(gpio, button);
         if (currState == HIGH) {
+            TRACE_INSTANT("button press", button);
+            lastPress = histNowNs();
+            if (pressHist != NULL)
+                histRecord(pressHist, lastPress - edge);
             prevState = HIGH;
             return 1; /* Button press detected */
         }
     } else if (currState == LOW && prevState == HIGH) {
         /* Button was released */
+        TRACE_INSTANT("button edge", LOW);
         prevState = LOW;
     }
     
@@ -131,14 +273,11 @@ int detectButtonPress(uint32_t *gpio, int button) {
 int detectButtonRelease(uint32_t *gpio, int button) {
     static int prevState = HIGH;
     int currState = readButton(gpio, button);
-    struct timespec sleeper, dummy;
     
     /* If button state changed from pressed to not pressed */
     if (currState == LOW && prevState == HIGH) {
         /* Debounce delay */
-        sleeper.tv_sec = 0;
-        sleeper.tv_nsec = 50 * 1000000; /* 50ms */
-        nanosleep(&sleeper, &dummy);
+        inputSleep(50);
         
         /* Check if button is still released */
         currState = readButton(gpio, button);
@@ -158,25 +297,23 @@ int detectButtonRelease(uint32_t *gpio, int button) {
 int getButtonInput(uint32_t *gpio, int button, int maxValue, int timeoutSec, int confirmMethod) {
     int value = 1; /* Start with value 1 */
     int confirmed = 0;
-    time_t startTime = time(NULL);
-    time_t currentTime;
-    time_t lastPressTime = 0;
+    uint64_t startTime = inputMs; /* all times in input time (ms), see buttonInputMs() */
+    uint64_t currentTime;
+    uint64_t lastPressTime = 0;
     int pressCount = 0;
     int longPressDetected = 0;
-    struct timespec sleeper, dummy;
     
     /* Reset button state */
-    while (readButton(gpio, button) == HIGH) {
-        sleeper.tv_sec = 0;
-        sleeper.tv_nsec = 10 * 1000000;
-        nanosleep(&sleeper, &dummy);
+    while (readButton(gpio, button) == HIGH && !buttonAborted()) {
+        inputSleep(10);
+        runIdle();
     }
     
-    while (!confirmed) {
-        currentTime = time(NULL);
+    while (!confirmed && !buttonAborted()) {
+        currentTime = inputMs;
         
         /* Check for timeout */
-        if (timeoutSec > 0 && (currentTime - startTime) >= timeoutSec) {
+        if (timeoutSec > 0 && (currentTime - startTime) >= (uint64_t)timeoutSec * 1000) {
             return value; /* Return current value on timeout */
         }
         
@@ -186,11 +323,11 @@ int getButtonInput(uint32_t *gpio, int button, int maxValue, int timeoutSec, int
             value = (value % maxValue) + 1;
             
             /* Reset timeout on button press */
-            startTime = time(NULL);
+            startTime = inputMs;
             
             /* For double-press detection */
             if (confirmMethod == 2) {
-                if (pressCount == 0 || (currentTime - lastPressTime) > 1) {
+                if (pressCount == 0 || (currentTime - lastPressTime) > 1000) {
                     /* First press or too much time passed */
                     pressCount = 1;
                 } else {
@@ -201,16 +338,15 @@ int getButtonInput(uint32_t *gpio, int button, int maxValue, int timeoutSec, int
             }
             
             /* Wait for button release with long-press detection */
-            time_t pressStartTime = time(NULL);
-            while (readButton(gpio, button) == HIGH) {
+            uint64_t pressStartTime = inputMs;
+            while (readButton(gpio, button) == HIGH && !buttonAborted()) {
                 /* For long-press detection */
-                if (confirmMethod == 1 && (time(NULL) - pressStartTime) >= 1) {
+                if (confirmMethod == 1 && (inputMs - pressStartTime) >= 1000) {
                     longPressDetected = 1;
                 }
                 
-                sleeper.tv_sec = 0;
-                sleeper.tv_nsec = 10 * 1000000;
-                nanosleep(&sleeper, &dummy);
+                inputSleep(10);
+                runIdle();
             }
             
             /* Handle confirmation methods */
@@ -222,9 +358,8 @@ int getButtonInput(uint32_t *gpio, int button, int maxValue, int timeoutSec, int
         }
         
         /* Small delay to prevent CPU hogging */
-        sleeper.tv_sec = 0;
-        sleeper.tv_nsec = 10 * 1000000;
-        nanosleep(&sleeper, &dummy);
+        inputSleep(10);
+        runIdle();
     }
     
     return value;
@@ -235,26 +370,27 @@ void waitForButton(uint32_t *gpio, int button) {
     int prevState = 0;
     int currState;
     int debounceTime = 50; /* milliseconds */
-    struct timespec sleeper, dummy;
     
-    while (1) {
+    while (!buttonAborted()) {
         currState = readButton(gpio, button);
         
         /* If button state changed from not pressed to pressed */
         if (currState == HIGH && prevState == LOW) {
+            uint64_t edge = histNowNs();
+            
             /* Debounce delay */
-            sleeper.tv_sec = 0;
-            sleeper.tv_nsec = debounceTime * 1000000;
-            nanosleep(&sleeper, &dummy);
+            inputSleep(debounceTime);
             
             /* Check if button is still pressed */
             currState = readButton(gpio, button);
             if (currState == HIGH) {
+                lastPress = histNowNs();
+                if (pressHist != NULL)
+                    histRecord(pressHist, lastPress - edge);
                 /* Wait for button release */
-                while (readButton(gpio, button) == HIGH) {
-                    sleeper.tv_sec = 0;
-                    sleeper.tv_nsec = 10 * 1000000;
-                    nanosleep(&sleeper, &dummy);
+                while (readButton(gpio, button) == HIGH && !buttonAborted()) {
+                    inputSleep(10);
+                    runIdle();
                 }
                 break;
             }
@@ -263,8 +399,7 @@ void waitForButton(uint32_t *gpio, int button) {
         prevState = currState;
         
         /* Small polling delay */
-        sleeper.tv_sec = 0;
-        sleeper.tv_nsec = 10 * 1000000;
-        nanosleep(&sleeper, &dummy);
+        inputSleep(10);
+        runIdle();
     }
 }
\ No newline at end of file
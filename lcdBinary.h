@@ -11,6 +11,9 @@
  #include <stdint.h>   /* Integer types */
  #include <sys/types.h> /* System types */
  #include <time.h>     /* Time functions */
+ #include <signal.h>   /* sig_atomic_t */
+ #include "mmTime.h"   /* Calibrated delays */
+ #include "mmHist.h"   /* Latency histograms */
  
  /* Boolean constants */
  #ifndef TRUE
@@ -38,9 +41,22 @@
  #define DATA2_PIN 27
  #define DATA3_PIN 22
  
+ /* Simulated GPIO: a hook called after every pin write (e.g. the LCD emulator) */
+ typedef void (*gpioWriteHook)(uint32_t *gpio, int pin, int value);
+ void gpioSetWriteHook(gpioWriteHook hook);  /* NULL (default) for real hardware */
+ typedef void (*gpioMaskHook)(uint32_t *gpio, uint32_t set, uint32_t clr);
+ void gpioSetMaskHook(gpioMaskHook hook);  /* Same, after every digitalWriteMask() */
+ 
+ /* Idle hook: run every IDLE_PERIOD ms while waiting for input, e.g. for animations */
+ #define IDLE_PERIOD 10
+ typedef void (*idleHookFn)(void);
+ void setIdleHook(idleHookFn hook);  /* NULL (default) for none */
+ void idleDelay(unsigned int howLong);  /* Delay in ms, running the idle hook */
+ 
  /* Basic hardware control functions */
  int failure(int fatal, const char *message, ...);  /* Report error condition */
  void digitalWrite(uint32_t *gpio, int pin, int value);  /* Set pin state */
+ void digitalWriteMask(uint32_t *gpio, uint32_t set, uint32_t clr);  /* Set and clear pins 0-31 at once: one GPSET0, one GPCLR0 store */
  void pinMode(uint32_t *gpio, int pin, int mode);  /* Set pin mode */
  void writeLED(uint32_t *gpio, int led, int value);  /* Control LED */
  int readButton(uint32_t *gpio, int button);  /* Read button state */
@@ -50,6 +66,20 @@
  int detectButtonPress(uint32_t *gpio, int button);  /* Detect new press */
  int detectButtonRelease(uint32_t *gpio, int button);  /* Detect release */
  int getButtonInput(uint32_t *gpio, int button, int maxValue, int timeoutSec, int confirmMethod);  /* Get input value */
- void delay(unsigned int howLong);  /* Delay in milliseconds */
+ 
+ /* Button input source: a hook called instead of reading GPLEV, e.g. to replay a recording */
+ typedef int (*buttonReadHook)(uint32_t *gpio, int button);
+ void buttonSetReadHook(buttonReadHook hook);  /* NULL (default) for the hardware */
+ int readButtonLevel(uint32_t *gpio, int button);  /* Read GPLEV, ignoring the hook */
+ uint64_t buttonInputMs(void);  /* Input time: ms slept while waiting for the button */
+ 
+ /* Abort: while *flag is set (e.g. by a signal handler), waits for input and idleDelay() */
+ /* return at once; getButtonInput() returns the value so far */
+ void buttonSetAbort(volatile sig_atomic_t *flag);  /* NULL (default) for none */
+ int buttonAborted(void);  /* Is the abort flag set? */
+ 
+ /* Input latency (button edge to recognised press, after debouncing) */
+ void buttonSetLatencyHist(struct mmHist *edgeToPress);  /* NULL (default) to stop recording */
+ uint64_t buttonLastPress(void);  /* histNowNs() of the last recognised press; 0 if none */
  
  #endif /* LCD_BINARY_H */
\ No newline at end of file
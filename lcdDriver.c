@@ -0,0 +1,561 @@
+/* ***************************************************************************** */
+/* HD44780U LCD driver: medium-level interface functions (all in C)              */
+/* INLINED fcts from wiringPi/devLib/lcd.c, on top of digitalWrite() from        */
+/* lcdBinary.c; moved here from master-mind.c                                    */
+/* ***************************************************************************** */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "lcdBinary.h"
+#include "lcdDriver.h"
+#include "mmTime.h"
+#include "mmTrace.h"
+
+static int lcdControl ;
+
+// =======================================================
+// char data for the CGRAM, i.e. defining new characters for the display
+
+static unsigned char newChar [GLYPH_COUNT][8] = 
+{
+  { 0b11111, 0b10001, 0b10001, 0b10101, 0b11111, 0b10001, 0b10001, 0b11111 },
+  { 0b00000, 0b01110, 0b11111, 0b11111, 0b11111, 0b01110, 0b00000, 0b00000 },
+  { 0b00000, 0b01110, 0b10001, 0b10001, 0b10001, 0b01110, 0b00000, 0b00000 },
+  { 0b10000, 0b10000, 0b10000, 0b10000, 0b10000, 0b10000, 0b10000, 0b10000 },
+  { 0b11000, 0b11000, 0b11000, 0b11000, 0b11000, 0b11000, 0b11000, 0b11000 },
+  { 0b11100, 0b11100, 0b11100, 0b11100, 0b11100, 0b11100, 0b11100, 0b11100 },
+  { 0b11110, 0b11110, 0b11110, 0b11110, 0b11110, 0b11110, 0b11110, 0b11110 },
+  { 0b11111, 0b11111, 0b11111, 0b11111, 0b11111, 0b11111, 0b11111, 0b11111 },
+} ;
+
+// which glyph is resident in each CGRAM slot (-1 if none), and when it was last used
+static int cgramGlyph [CGRAM_SLOTS] = { -1, -1, -1, -1, -1, -1, -1, -1 } ;
+static unsigned long cgramUsed [CGRAM_SLOTS] ;
+static unsigned long glyphClock ;
+// number of glyph uploads and of CGRAM bytes written
+static unsigned int cgramUploads, cgramWrites ;
+
+// state of the marquee (see lcdScrollStart); lcdClear and lcdHome stop it
+static struct {
+  struct lcdDataStruct *lcd ;
+  int active ;
+  uint64_t period, next ;	// in ns
+  unsigned long frames, commands ;
+} scroll ;
+
+/* from wiringPi:
+ * strobe:
+ *	Toggle the strobe (Really the "E") pin to the device.
+ *	According to the docs, data is latched on the falling edge.
+ *********************************************************************************
+ */
+
+ void strobe(const struct lcdDataStruct *lcd)
+ {
+     TRACE_BEGIN(t0);
+     digitalWrite(lcd->gpio, lcd->strbPin, 1);
+     delayMicroseconds(50);
+     digitalWrite(lcd->gpio, lcd->strbPin, 0);
+     delayMicroseconds(50);
+     TRACE_END(t0, "lcd strobe", lcd->strbPin);
+ }
+
+/*
+ * writeBus:
+ *	Put the low n bits of v on the first n data lines, all at once: one
+ *	GPSET0 and one GPCLR0 store instead of one store per line.
+ *********************************************************************************
+ */
+
+ static void writeBus(const struct lcdDataStruct *lcd, unsigned char v, int n)
+ {
+     uint32_t set = 0, lines = 0;
+     int i;
+
+     for (i = 0; i < n; ++i, v >>= 1) {
+         lines |= 1u << lcd->dataPins[i];
+         if (v & 1)
+             set |= 1u << lcd->dataPins[i];
+     }
+     digitalWriteMask(lcd->gpio, set, lines & ~set);
+ }
+
+/*
+ * sentDataCmd:
+ *	Send an data or command byte to the display.
+ *********************************************************************************
+ */
+
+ void sendDataCmd(const struct lcdDataStruct *lcd, unsigned char data)
+ {
+     if (lcd->bits == 4) {
+         writeBus(lcd, data >> 4, 4);
+         strobe(lcd);
+         writeBus(lcd, data, 4);
+     } else {
+         writeBus(lcd, data, 8);
+     }
+     strobe(lcd);
+ }
+
+/*
+ * lcdPutCommand:
+ *	Send a command byte to the display
+ *********************************************************************************
+ */
+
+ void lcdPutCommand(const struct lcdDataStruct *lcd, unsigned char command)
+ {
+ #ifdef DEBUG
+     fprintf(stderr, "lcdPutCommand: digitalWrite(%d,%d) and sendDataCmd(%d,%d)\n", lcd->rsPin, 0, lcd, command);
+ #endif
+     TRACE_BEGIN(t0);
+     digitalWrite(lcd->gpio, lcd->rsPin, 0);
+     sendDataCmd(lcd, command);
+     delay(2);
+     TRACE_END(t0, "lcd command", command);
+ }
+
+ void lcdPut4Command(const struct lcdDataStruct *lcd, unsigned char command)
+ {
+     digitalWrite(lcd->gpio, lcd->rsPin, 0);
+     writeBus(lcd, command, 4);
+     strobe(lcd);
+ }
+
+/*
+ * lcdPutReset:
+ *	Function set to 8-bit mode, as in the software reset of the datasheet:
+ *	one strobe, on the high nibble only with a 4-bit connection.
+ *********************************************************************************
+ */
+
+ static void lcdPutReset(const struct lcdDataStruct *lcd)
+ {
+     if (lcd->bits == 8) {
+         digitalWrite(lcd->gpio, lcd->rsPin, 0);
+         sendDataCmd(lcd, LCD_FUNC | LCD_FUNC_DL);
+     } else {
+         lcdPut4Command(lcd, (LCD_FUNC | LCD_FUNC_DL) >> 4);
+     }
+ }
+
+/*
+ * lcdHome: lcdClear:
+ *	Home the cursor or clear the screen.
+ *********************************************************************************
+ */
+
+ void lcdHome(struct lcdDataStruct *lcd)
+ {
+ #ifdef DEBUG
+     fprintf(stderr, "lcdHome: lcdPutCommand(%d,%d)\n", lcd, LCD_HOME);
+ #endif
+     lcdPutCommand(lcd, LCD_HOME);
+     lcd->cx = lcd->cy = 0;
+     scroll.active = 0;
+     delay(5);
+ }
+ 
+ void lcdClear(struct lcdDataStruct *lcd)
+ {
+ #ifdef DEBUG
+     fprintf(stderr, "lcdClear: lcdPutCommand(%d,%d) and lcdPutCommand(%d,%d)\n", lcd, LCD_CLEAR, lcd, LCD_HOME);
+ #endif
+     lcdPutCommand(lcd, LCD_CLEAR);
+     lcdPutCommand(lcd, LCD_HOME);
+     lcd->cx = lcd->cy = 0;
+     scroll.active = 0;
+     delay(5);
+ }
+
+/*
+ * lcdPosition:
+ *	Update the position of the cursor on the display.
+ *	Ignore invalid locations.
+ *********************************************************************************
+ */
+
+ void lcdPosition(struct lcdDataStruct *lcd, int x, int y)
+ {
+     if ((x > lcd->cols) || (x < 0))
+         return;
+     if ((y > lcd->rows) || (y < 0))
+         return;
+     
+     lcdPutCommand(lcd, x + (LCD_DGRAM | (y > 0 ? 0x40 : 0x00)));
+     
+     lcd->cx = x;
+     lcd->cy = y;
+ }
+
+
+/*
+ * lcdDisplay: lcdCursor: lcdCursorBlink:
+ *	Turn the display, cursor, cursor blinking on/off
+ *********************************************************************************
+ */
+
+ void lcdDisplay(struct lcdDataStruct *lcd, int state)
+ {
+     if (state)
+         lcdControl |= LCD_DISPLAY_CTRL;
+     else
+         lcdControl &= ~LCD_DISPLAY_CTRL;
+     
+     lcdPutCommand(lcd, LCD_CTRL | lcdControl);
+ }
+ 
+ void lcdCursor(struct lcdDataStruct *lcd, int state)
+ {
+     if (state)
+         lcdControl |= LCD_CURSOR_CTRL;
+     else
+         lcdControl &= ~LCD_CURSOR_CTRL;
+     
+     lcdPutCommand(lcd, LCD_CTRL | lcdControl);
+ }
+ 
+ void lcdCursorBlink(struct lcdDataStruct *lcd, int state)
+ {
+     if (state)
+         lcdControl |= LCD_BLINK_CTRL;
+     else
+         lcdControl &= ~LCD_BLINK_CTRL;
+     
+     lcdPutCommand(lcd, LCD_CTRL | lcdControl);
+ }
+
+/*
+ * lcdPutchar:
+ *	Send a data byte to be displayed on the display. We implement a very
+ *	simple terminal here - with line wrapping, but no scrolling. Yet.
+ *********************************************************************************
+ */
+
+ void lcdPutchar(struct lcdDataStruct *lcd, unsigned char data)
+ {
+     if (data >= GLYPH_FIRST && data < GLYPH_FIRST + GLYPH_COUNT)
+         data = lcdGlyph(lcd, data - GLYPH_FIRST);
+     
+     digitalWrite(lcd->gpio, lcd->rsPin, 1);
+     sendDataCmd(lcd, data);
+     
+     if (++lcd->cx == lcd->cols) {
+         lcd->cx = 0;
+         if (++lcd->cy == lcd->rows)
+             lcd->cy = 0;
+         
+         lcdPutCommand(lcd, lcd->cx + (LCD_DGRAM | (lcd->cy > 0 ? 0x40 : 0x00)));
+     }
+ }
+
+
+/*
+ * lcdPuts:
+ *	Send a string to be displayed on the display
+ *********************************************************************************
+ */
+
+ void lcdPuts(struct lcdDataStruct *lcd, const char *string)
+ {
+     while (*string)
+         lcdPutchar(lcd, *string++);
+ }
+
+/*
+ * lcdGlyph:
+ *	Make custom character @id@ resident in CGRAM and return its character code
+ *	(0-7). Resident glyphs cost nothing; otherwise the least recently used
+ *	slot is overwritten. Note that characters already on the display which
+ *	use an evicted slot change their shape as well.
+ *********************************************************************************
+ */
+
+ int lcdGlyph(struct lcdDataStruct *lcd, int id)
+ {
+     int slot, i;
+     
+     for (slot = 0; slot < CGRAM_SLOTS; slot++) {
+         if (cgramGlyph[slot] == id) {
+             cgramUsed[slot] = ++glyphClock;
+             return slot;
+         }
+     }
+     
+     /* not resident: take a free slot, or else the least recently used one */
+     slot = 0;
+     for (i = 0; i < CGRAM_SLOTS; i++) {
+         if (cgramGlyph[i] < 0) {
+             slot = i;
+             break;
+         }
+         if (cgramUsed[i] < cgramUsed[slot])
+             slot = i;
+     }
+     
+     lcdPutCommand(lcd, LCD_CGRAM | (slot << 3));
+     digitalWrite(lcd->gpio, lcd->rsPin, 1);
+     for (i = 0; i < 8; i++)
+         sendDataCmd(lcd, newChar[id][i]);
+     cgramWrites += 8;
+     cgramUploads++;
+     
+     /* the address counter now points into CGRAM: return to the cursor position */
+     lcdPutCommand(lcd, lcd->cx + (LCD_DGRAM | (lcd->cy > 0 ? 0x40 : 0x00)));
+     
+     cgramGlyph[slot] = id;
+     cgramUsed[slot] = ++glyphClock;
+     return slot;
+ }
+
+/*
+ * lcdBar:
+ *	Draw a horizontal bar graph of @value@ out of @max@, @width@ characters wide,
+ *	with a resolution of 5 pixel columns per character.
+ *********************************************************************************
+ */
+
+ void lcdBar(struct lcdDataStruct *lcd, int x, int y, int width, int value, int max)
+ {
+     int cols = (max > 0 ? (value * width * 5) / max : 0);
+     int i;
+     
+     lcdPosition(lcd, x, y);
+     for (i = 0; i < width; i++, cols -= 5) {
+         if (cols >= 5)
+             lcdPutchar(lcd, GLYPH_CHAR(GLYPH_BAR5));
+         else if (cols > 0)
+             lcdPutchar(lcd, GLYPH_CHAR(GLYPH_BAR1 + cols - 1));
+         else
+             lcdPutchar(lcd, ' ');
+     }
+ }
+
+ void lcdGlyphStats(unsigned int *uploads, unsigned int *bytes)
+ {
+     *uploads = cgramUploads;
+     *bytes = cgramWrites;
+ }
+
+/*
+ * lcdScrollStart: lcdScrollTick:
+ *	Show two lines of up to 40 characters each. Text wider than the display
+ *	is written once into the 40 character DDRAM lines, and each frame of the
+ *	marquee is then a single display shift command, sent by lcdScrollTick
+ *	every @periodMs@. Rewriting a line instead costs 1 + cols commands per frame.
+ *********************************************************************************
+ */
+
+ static void lcdWriteLine(struct lcdDataStruct *lcd, int y, const char *text)
+ {
+     unsigned char line[LCD_LINE_LEN];
+     int i, len = 0;
+     
+     /* resolve glyphs first: uploading them moves the address counter */
+     for (; text[len] != '\0' && len < LCD_LINE_LEN; len++) {
+         line[len] = text[len];
+         if (line[len] >= GLYPH_FIRST && line[len] < GLYPH_FIRST + GLYPH_COUNT)
+             line[len] = lcdGlyph(lcd, line[len] - GLYPH_FIRST);
+     }
+     
+     lcdPutCommand(lcd, LCD_DGRAM | (y > 0 ? 0x40 : 0x00));
+     digitalWrite(lcd->gpio, lcd->rsPin, 1);
+     for (i = 0; i < len; i++)
+         sendDataCmd(lcd, line[i]);
+ }
+
+ void lcdScrollStart(struct lcdDataStruct *lcd, const char *line0, const char *line1, unsigned int periodMs)
+ {
+     lcdClear(lcd);
+     lcdWriteLine(lcd, 0, line0);
+     if (lcd->rows > 1)
+         lcdWriteLine(lcd, 1, line1);
+     lcdPosition(lcd, 0, 0);
+     
+     scroll.lcd = lcd;
+     scroll.active = ((int)strlen(line0) > lcd->cols || (int)strlen(line1) > lcd->cols);
+     scroll.period = (uint64_t)periodMs * 1000000ULL;
+     scroll.next = delayNowNs() + scroll.period;
+ }
+
+ void lcdScrollTick(void)
+ {
+     uint64_t now;
+     
+     if (!scroll.active)
+         return;
+     now = delayNowNs();
+     if (now < scroll.next)
+         return;
+     
+     lcdPutCommand(scroll.lcd, LCD_CDSHIFT | LCD_CDSHIFT_SC);	// display one to the left
+     scroll.frames++;
+     scroll.commands++;
+     
+     scroll.next += scroll.period;
+     if (scroll.next < now)	// fell behind: skip frames rather than catch up
+         scroll.next = now + scroll.period;
+ }
+
+ void lcdScrollStats(unsigned long *frames, unsigned long *commands)
+ {
+     *frames = scroll.frames;
+     *commands = scroll.commands;
+ }
+
+/*
+ * lcdInitQuick:
+ *	Fast start-up (see lcdInitMode). LCD_INIT_QUICK runs the software reset
+ *	of the datasheet (Fig 24, p46) with its minimum waits; the display has
+ *	been powered since the Pi booted, so there is no power-on wait.
+ *	LCD_INIT_KEEP trusts that the controller is still in the interface mode
+ *	(and, in 4-bit mode, between two bytes) a clean exit left it in, and only
+ *	sets the modes and clears it.
+ *	Every strobe ends with 50us low, longer than most instructions take.
+ *********************************************************************************
+ */
+
+ static void lcdInitQuick(struct lcdDataStruct *lcd, int mode)
+ {
+   unsigned char func = LCD_FUNC | (lcd->bits == 8 ? LCD_FUNC_DL : 0) | (lcd->rows > 1 ? LCD_FUNC_N : 0) ;
+
+   if (mode == LCD_INIT_QUICK)
+   {
+     lcdPutReset (lcd) ;
+     delayMicroseconds (4100) ;
+     lcdPutReset (lcd) ;
+     delayMicroseconds (100) ;
+     lcdPutReset (lcd) ;
+     if (lcd->bits == 4)
+       lcdPut4Command (lcd, LCD_FUNC >> 4) ;
+   }
+
+   lcdControl = LCD_DISPLAY_CTRL ;
+   digitalWrite (lcd->gpio, lcd->rsPin, 0) ;
+   sendDataCmd (lcd, func) ;
+   sendDataCmd (lcd, LCD_CTRL | lcdControl) ;
+   sendDataCmd (lcd, LCD_ENTRY | LCD_ENTRY_ID) ;
+   sendDataCmd (lcd, LCD_CLEAR) ;
+   delayMicroseconds (1520) ;
+ }
+
+/*
+ * lcdInit: lcdInitMode:
+ *	Create an LCD on the given pins and run the HD44780U initialisation
+ *	sequence (can only deal with one LCD attached to the RPi).
+ *	Formerly inlined in main().
+ *********************************************************************************
+ */
+
+ struct lcdDataStruct *lcdInit(uint32_t *gpio, int rows, int cols, int bits,
+                               int rs, int strb, const int *dataPins)
+ {
+   return lcdInitMode (gpio, rows, cols, bits, rs, strb, dataPins, LCD_INIT_FULL) ;
+ }
+
+ struct lcdDataStruct *lcdInitMode(uint32_t *gpio, int rows, int cols, int bits,
+                                   int rs, int strb, const int *dataPins, int mode)
+ {
+   struct lcdDataStruct *lcd ;
+   unsigned char func ;
+   int i ;
+
+   if (bits != 4 && bits != 8)
+     return NULL ;
+   for (i = 0 ; i < bits ; ++i)
+     if (dataPins [i] < 0 || dataPins [i] > 31)	// written together, in bank 0 (see writeBus)
+       return NULL ;
+
+   lcd = (struct lcdDataStruct *)malloc (sizeof (struct lcdDataStruct)) ;
+   if (lcd == NULL)
+     return NULL ;
+
+   lcd->gpio    = gpio ;
+   lcd->rsPin   = rs ;
+   lcd->strbPin = strb ;
+   lcd->bits    = bits ;
+   lcd->rows    = rows ;  // # of rows on the display
+   lcd->cols    = cols ;  // # of cols on the display
+   lcd->cx      = 0 ;     // x-pos of cursor
+   lcd->cy      = 0 ;     // y-pos of curosr
+
+   for (i = 0 ; i < 8 ; ++i)
+     lcd->dataPins [i] = (i < bits ? dataPins [i] : 0) ;
+
+   digitalWrite (gpio, lcd->rsPin,   0) ; 
+   pinMode (gpio, lcd->rsPin,   OUTPUT) ;
+   digitalWrite (gpio, lcd->strbPin, 0) ; 
+   pinMode (gpio, lcd->strbPin, OUTPUT) ;
+
+   for (i = 0 ; i < bits ; ++i)
+   {
+     digitalWrite (gpio, lcd->dataPins [i], 0) ;
+     pinMode      (gpio, lcd->dataPins [i], OUTPUT) ;
+   }
+
+   // glyphs are only trusted to be resident in the CGRAM if the controller is kept
+   if (mode != LCD_INIT_KEEP)
+     for (i = 0 ; i < CGRAM_SLOTS ; ++i)
+       cgramGlyph [i] = -1 ;
+
+   if (mode != LCD_INIT_FULL)
+   {
+     lcdInitQuick (lcd, mode) ;
+     return lcd ;
+   }
+   delay (35) ; // mS
+
+// Gordon Henderson's explanation of this part of the init code (from wiringPi):
+// 4-bit mode?
+//	OK. This is a PIG and it's not at all obvious from the documentation I had,
+//	so I guess some others have worked through either with better documentation
+//	or more trial and error... Anyway here goes:
+//
+//	It seems that the controller needs to see the FUNC command at least 3 times
+//	consecutively - in 8-bit mode. If you're only using 8-bit mode, then it appears
+//	that you can get away with one func-set, however I'd not rely on it...
+//
+//	So to set 4-bit mode, you need to send the commands one nibble at a time,
+//	the same three times, but send the command to set it into 8-bit mode those
+//	three times, then send a final 4th command to set it into 4-bit mode, and only
+//	then can you flip the switch for the rest of the library to work in 4-bit
+//	mode which sends the commands as 2 x 4-bit values.
+
+// With an 8-bit connection the three resets are whole bytes, there is no 4th
+// set, and the final function set only keeps DL.
+
+   lcdPutReset (lcd) ;					// Set 8-bit mode 3 times
+   delay (35) ;
+   lcdPutReset (lcd) ;
+   delay (35) ;
+   lcdPutReset (lcd) ;
+   delay (35) ;
+   func = LCD_FUNC ;
+   if (bits == 4)
+   {
+     lcdPut4Command (lcd, func >> 4) ; 		// 4th set: 4-bit mode
+     delay (35) ;
+   }
+   else
+     func |= LCD_FUNC_DL ;
+
+   if (lcd->rows > 1 || bits == 8)
+   {
+     func |= (lcd->rows > 1 ? LCD_FUNC_N : 0) ;
+     lcdPutCommand (lcd, func) ; delay (35) ;
+   }
+
+   // Rest of the initialisation sequence
+   lcdDisplay     (lcd, TRUE) ;
+   lcdCursor      (lcd, FALSE) ;
+   lcdCursorBlink (lcd, FALSE) ;
+   lcdClear       (lcd) ;
+
+   lcdPutCommand (lcd, LCD_ENTRY   | LCD_ENTRY_ID) ;    // set entry mode to increment address counter after write
+   lcdPutCommand (lcd, LCD_CDSHIFT | LCD_CDSHIFT_RL) ;  // set display shift to right-to-left
+
+   return lcd ;
+ }
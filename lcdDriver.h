@@ -0,0 +1,108 @@
+/**
+ * lcdDriver.h - HD44780U LCD driver (medium-level interface, all in C)
+ * Based on wiringPi/devLib/lcd.c; uses digitalWrite() from lcdBinary.c, and
+ * digitalWriteMask() for the data lines, with a 4-bit or an 8-bit connection
+ */
+
+#ifndef LCD_DRIVER_H
+#define LCD_DRIVER_H
+
+#include <stdint.h>   /* Integer types */
+
+/* data structure holding data on the representation of the LCD */
+struct lcdDataStruct
+{
+  uint32_t *gpio ;    /* mapped (or simulated) GPIO registers */
+  int bits, rows, cols ;
+  int rsPin, strbPin ;
+  int dataPins [8] ;
+  int cx, cy ;
+} ;
+
+/* HD44780U Commands (see Fig 11, p28 of the Hitachi HD44780U datasheet) */
+#define	LCD_CLEAR	0x01
+#define	LCD_HOME	0x02
+#define	LCD_ENTRY	0x04
+#define	LCD_CTRL	0x08
+#define	LCD_CDSHIFT	0x10
+#define	LCD_FUNC	0x20
+#define	LCD_CGRAM	0x40
+#define	LCD_DGRAM	0x80
+
+/* Bits in the entry register */
+#define	LCD_ENTRY_SH		0x01
+#define	LCD_ENTRY_ID		0x02
+
+/* Bits in the control register */
+#define	LCD_BLINK_CTRL		0x01
+#define	LCD_CURSOR_CTRL		0x02
+#define	LCD_DISPLAY_CTRL	0x04
+
+/* Bits in the function register */
+#define	LCD_FUNC_F	0x04
+#define	LCD_FUNC_N	0x08
+#define	LCD_FUNC_DL	0x10
+
+#define	LCD_CDSHIFT_RL	0x04
+#define	LCD_CDSHIFT_SC	0x08	/* shift the display rather than move the cursor */
+
+/* Length of a DDRAM line; only the first cols characters are visible unshifted */
+#define	LCD_LINE_LEN	40
+
+/* Custom characters: the controller has 8 CGRAM slots; glyphs are uploaded on */
+/* demand (see lcdGlyph) and printed by putting GLYPH_CHAR(id) into a string   */
+#define CGRAM_SLOTS 8
+#define GLYPH_FIRST 0x10
+#define GLYPH_CHAR(id) ((char)(GLYPH_FIRST + (id)))
+
+enum glyphId {
+  GLYPH_BOX,            /* framed box */
+  GLYPH_PEG_EXACT,      /* filled peg: right colour, right position */
+  GLYPH_PEG_APPROX,     /* hollow peg: right colour, wrong position */
+  GLYPH_BAR1,           /* bar graph cells, 1 to 5 columns filled */
+  GLYPH_BAR2,
+  GLYPH_BAR3,
+  GLYPH_BAR4,
+  GLYPH_BAR5,
+  GLYPH_COUNT
+} ;
+
+/* Initialisation: the wiringPi sequence with generous waits, the datasheet's */
+/* minimum waits, or none for a controller left in 4-bit mode by a clean exit */
+#define LCD_INIT_FULL  0
+#define LCD_INIT_QUICK 1
+#define LCD_INIT_KEEP  2
+
+/* Set-up */
+struct lcdDataStruct *lcdInit(uint32_t *gpio, int rows, int cols, int bits,
+                              int rs, int strb, const int *dataPins);  /* Create and initialise an LCD; NULL on error */
+struct lcdDataStruct *lcdInitMode(uint32_t *gpio, int rows, int cols, int bits,
+                                  int rs, int strb, const int *dataPins, int mode);  /* Same, with an LCD_INIT_ mode */
+
+/* Bus level */
+void strobe(const struct lcdDataStruct *lcd);  /* Toggle the E pin */
+void sendDataCmd(const struct lcdDataStruct *lcd, unsigned char data);  /* Send a data or command byte */
+void lcdPutCommand(const struct lcdDataStruct *lcd, unsigned char command);  /* Send a command byte */
+void lcdPut4Command(const struct lcdDataStruct *lcd, unsigned char command);  /* Send a 4-bit command (init only) */
+
+/* Display control */
+void lcdHome(struct lcdDataStruct *lcd);  /* Cursor to home position */
+void lcdClear(struct lcdDataStruct *lcd);  /* Clear the display */
+void lcdPosition(struct lcdDataStruct *lcd, int x, int y);  /* Move the cursor */
+void lcdDisplay(struct lcdDataStruct *lcd, int state);  /* Display on/off */
+void lcdCursor(struct lcdDataStruct *lcd, int state);  /* Cursor on/off */
+void lcdCursorBlink(struct lcdDataStruct *lcd, int state);  /* Cursor blinking on/off */
+
+/* Output */
+void lcdPutchar(struct lcdDataStruct *lcd, unsigned char data);  /* Write one character */
+void lcdPuts(struct lcdDataStruct *lcd, const char *string);  /* Write a string */
+int lcdGlyph(struct lcdDataStruct *lcd, int id);  /* Make a glyph resident; returns its char code */
+void lcdBar(struct lcdDataStruct *lcd, int x, int y, int width, int value, int max);  /* Bar graph */
+void lcdGlyphStats(unsigned int *uploads, unsigned int *bytes);  /* CGRAM traffic so far */
+
+/* Scrolling (marquee) using the display shift; both lines move together */
+void lcdScrollStart(struct lcdDataStruct *lcd, const char *line0, const char *line1, unsigned int periodMs);  /* Write and start */
+void lcdScrollTick(void);  /* Shift by one if a frame is due; call regularly, e.g. as idle hook */
+void lcdScrollStats(unsigned long *frames, unsigned long *commands);  /* Frames shown, commands sent */
+
+#endif /* LCD_DRIVER_H */
@@ -0,0 +1,331 @@
+/* ***************************************************************************** */
+/* HD44780U emulator, sitting on a simulated GPIO register block                 */
+/* Every digitalWrite() and digitalWriteMask() on the block is reported through  */
+/* the GPIO write hooks of lcdBinary.c; transitions on RS, E and the data pins   */
+/* (all in bank 0) are decoded into instructions, which are executed on an       */
+/* emulated DDRAM/CGRAM, checked against the datasheet timing and accounted per  */
+/* operation                                                                     */
+/* ***************************************************************************** */
+
+#include <string.h>
+#include <stdarg.h>
+
+#include "lcdBinary.h"
+#include "lcdDriver.h"
+#include "lcdEmu.h"
+#include "mmTime.h"
+
+/* timing from the HD44780U datasheet (Table 6 and 7, Vcc = 4.5 to 5.5V), in ns */
+#define T_POWER_ON   15000000   /* wait after Vcc rises before the first instruction */
+#define T_CYCE       500        /* enable cycle time */
+#define T_PWEH       230        /* enable pulse width (high level) */
+#define T_AS         40         /* address (RS) set-up time */
+#define T_DSW        80         /* data set-up time */
+#define T_EXEC_LONG  1520000    /* clear display, return home */
+#define T_EXEC       37000      /* all other instructions */
+#define T_EXEC_DATA  41000      /* data write, including the address update */
+
+/* function sets during the software reset in the init sequence need longer */
+static const uint64_t funcSetWait [2] = { 4100000, 100000 } ;
+
+static const char *opNames [EMU_OP_COUNT] = {
+  "clear", "home", "entry mode", "display ctrl", "cursor/shift", "function set",
+  "CGRAM address", "DDRAM address", "write DDRAM", "write CGRAM"
+} ;
+
+static void violation(struct lcdEmu *emu, const char *message, ...)
+{
+  va_list argp ;
+
+  emu->violations++ ;
+  va_start (argp, message) ;
+  vsnprintf (emu->lastViolation, sizeof(emu->lastViolation), message, argp) ;
+  va_end (argp) ;
+}
+
+static int level(const struct lcdEmu *emu, int pin)
+{
+  return (emu->regs [13 + pin / 32] >> (pin % 32)) & 1 ;
+}
+
+/* value on the data bus as D7..D0; with 4-bit wiring D0-D3 are not connected */
+static unsigned char readBus(const struct lcdEmu *emu)
+{
+  unsigned char v = 0 ;
+  int i ;
+
+  for (i = 0 ; i < emu->bits ; i++)
+    v |= level(emu, emu->dataPins [i]) << i ;
+  return (emu->bits == 4 ? v << 4 : v) ;
+}
+
+// -----------------------------------------------------------------------------
+// Controller
+
+/* move the address counter by one, wrapping as the hardware does */
+static void stepAddress(struct lcdEmu *emu, int dir)
+{
+  if (emu->cgMode) {
+    emu->ac = (emu->ac + dir) & 0x3F ;
+  } else if (emu->lines2) {
+    int row = emu->ac & 0x40, col = (emu->ac & 0x3F) + dir ;
+
+    if (col >= 40) {
+      col = 0 ;
+      row ^= 0x40 ;
+    } else if (col < 0) {
+      col = 39 ;
+      row ^= 0x40 ;
+    }
+    emu->ac = row | col ;
+  } else {
+    emu->ac = (emu->ac + dir + 80) % 80 ;
+  }
+}
+
+static void shiftDisplay(struct lcdEmu *emu, int left)
+{
+  emu->shift = (emu->shift + (left ? 1 : 39)) % 40 ;
+}
+
+static int execute(struct lcdEmu *emu, int rs, unsigned char v)
+{
+  if (rs) {
+    if (emu->cgMode) {
+      emu->cgram [emu->ac & 0x3F] = v ;
+      stepAddress(emu, emu->incr ? 1 : -1) ;
+      return EMU_OP_WRITE_CGRAM ;
+    }
+    emu->ddram [emu->ac & 0x7F] = v ;
+    stepAddress(emu, emu->incr ? 1 : -1) ;
+    if (emu->shiftOnWrite)
+      shiftDisplay(emu, emu->incr) ;
+    return EMU_OP_WRITE_DDRAM ;
+  }
+
+  if (v & LCD_DGRAM) {
+    emu->ac = v & 0x7F ;
+    emu->cgMode = 0 ;
+    return EMU_OP_DDRAM_ADDR ;
+  }
+  if (v & LCD_CGRAM) {
+    emu->ac = v & 0x3F ;
+    emu->cgMode = 1 ;
+    return EMU_OP_CGRAM_ADDR ;
+  }
+  if (v & LCD_FUNC) {
+    emu->dl8    = (v & LCD_FUNC_DL) != 0 ;
+    emu->lines2 = (v & LCD_FUNC_N) != 0 ;
+    emu->font   = (v & LCD_FUNC_F) != 0 ;
+    return EMU_OP_FUNC ;
+  }
+  if (v & LCD_CDSHIFT) {
+    if (v & 0x08)
+      shiftDisplay(emu, !(v & LCD_CDSHIFT_RL)) ;
+    else
+      stepAddress(emu, (v & LCD_CDSHIFT_RL) ? 1 : -1) ;
+    return EMU_OP_SHIFT ;
+  }
+  if (v & LCD_CTRL) {
+    emu->displayOn = (v & LCD_DISPLAY_CTRL) != 0 ;
+    emu->cursorOn  = (v & LCD_CURSOR_CTRL) != 0 ;
+    emu->blinkOn   = (v & LCD_BLINK_CTRL) != 0 ;
+    return EMU_OP_CTRL ;
+  }
+  if (v & LCD_ENTRY) {
+    emu->incr         = (v & LCD_ENTRY_ID) != 0 ;
+    emu->shiftOnWrite = (v & LCD_ENTRY_SH) != 0 ;
+    return EMU_OP_ENTRY ;
+  }
+  if (v & LCD_HOME) {
+    emu->ac = emu->shift = emu->cgMode = 0 ;
+    return EMU_OP_HOME ;
+  }
+  if (v & LCD_CLEAR) {
+    memset(emu->ddram, ' ', sizeof(emu->ddram)) ;
+    emu->ac = emu->shift = emu->cgMode = 0 ;
+    emu->incr = 1 ;
+    return EMU_OP_CLEAR ;
+  }
+  return -1 ;	// 0x00 is not an instruction
+}
+
+static uint64_t execTime(struct lcdEmu *emu, int op)
+{
+  if (op == EMU_OP_CLEAR || op == EMU_OP_HOME)
+    return T_EXEC_LONG ;
+  if (op == EMU_OP_WRITE_DDRAM || op == EMU_OP_WRITE_CGRAM)
+    return T_EXEC_DATA ;
+  if (op == EMU_OP_FUNC && emu->funcSets < 2)
+    return funcSetWait [emu->funcSets] ;
+  return T_EXEC ;
+}
+
+// -----------------------------------------------------------------------------
+// Bus decoding
+
+/* data is latched on the falling edge of E */
+static void latch(struct lcdEmu *emu, uint64_t now)
+{
+  int rs = level(emu, emu->rsPin) ;
+  unsigned char v = readBus(emu) ;
+  int op ;
+
+  if (now - emu->eRise < T_PWEH)
+    violation(emu, "E pulse of %lluns, needs %dns", (unsigned long long)(now - emu->eRise), T_PWEH) ;
+  if (now - emu->dataChange < T_DSW)
+    violation(emu, "data set-up of %lluns, needs %dns", (unsigned long long)(now - emu->dataChange), T_DSW) ;
+
+  if (!emu->nibble && now < emu->busyUntil)
+    violation(emu, "%s 0x%02x sent %lluns before the controller was ready",
+	      (rs ? "data" : "command"), v, (unsigned long long)(emu->busyUntil - now)) ;
+
+  if (!emu->dl8) {	// 4-bit interface: high nibble first, then low nibble
+    if (!emu->nibble) {
+      emu->high = v & 0xF0 ;
+      emu->nibble = 1 ;
+      return ;
+    }
+    v = emu->high | (v >> 4) ;
+    emu->nibble = 0 ;
+  }
+
+  op = execute(emu, rs, v) ;
+  if (op < 0)
+    return ;
+
+  emu->busyUntil = now + execTime(emu, op) ;
+  if (op == EMU_OP_FUNC)
+    emu->funcSets++ ;
+
+  emu->ops [op].count++ ;
+  emu->ops [op].busNs += now - emu->opStart ;
+  if (now - emu->opStart > emu->ops [op].maxNs)
+    emu->ops [op].maxNs = now - emu->opStart ;
+  emu->inOp = 0 ;
+}
+
+/* one write to the GPIO block, setting and clearing pins of bank 0: a single */
+/* pin (digitalWrite), or several at once (digitalWriteMask) with @stores@ 2   */
+static void busWrite(struct lcdEmu *emu, uint32_t set, uint32_t clr, int stores)
+{
+  uint64_t now = delayNowNs() ;
+  uint32_t pins = set | clr, rs = 1u << emu->rsPin, e = 1u << emu->strbPin ;
+
+  /* a simulated block has no GPLEV logic: reflect the write there (GPCLR0 is written last) */
+  emu->regs [13] = (emu->regs [13] | set) & ~clr ;
+
+  if (!(pins & (rs | e | emu->dataMask)))
+    return ;	// not an LCD pin (LED, button)
+  emu->stores += stores ;
+
+  if (!emu->inOp) {
+    emu->inOp = 1 ;
+    emu->opStart = now ;
+  }
+
+  if (pins & rs) {
+    if (emu->e)
+      violation(emu, "RS changed while E is high") ;
+    emu->rsChange = now ;
+  }
+  if (pins & emu->dataMask)
+    emu->dataChange = now ;
+  if ((set & e) && !emu->e) {
+    if (emu->strobes == 0 && now - emu->powerOn < T_POWER_ON)
+      violation(emu, "first instruction %lluns after power on", (unsigned long long)(now - emu->powerOn)) ;
+    if (emu->strobes > 0 && now - emu->eRise < T_CYCE)
+      violation(emu, "E cycle of %lluns, needs %dns", (unsigned long long)(now - emu->eRise), T_CYCE) ;
+    if (now - emu->rsChange < T_AS)
+      violation(emu, "RS set-up of %lluns, needs %dns", (unsigned long long)(now - emu->rsChange), T_AS) ;
+    emu->e = 1 ;
+    emu->eRise = now ;
+    emu->strobes++ ;
+  } else if ((clr & e) && emu->e) {
+    emu->e = 0 ;
+    latch(emu, now) ;
+  }
+}
+
+static void emuWrite(uint32_t *gpio, int pin, int value)
+{
+  struct lcdEmu *emu = (struct lcdEmu *)gpio ;
+
+  if (pin >= 32) {	// bank 1 has no LCD pins
+    if (value == LOW)
+      emu->regs [14] &= ~(1u << (pin % 32)) ;
+    else
+      emu->regs [14] |= 1u << (pin % 32) ;
+    return ;
+  }
+  busWrite(emu, (value == LOW ? 0 : 1u << pin), (value == LOW ? 1u << pin : 0), 1) ;
+}
+
+static void emuMask(uint32_t *gpio, uint32_t set, uint32_t clr)
+{
+  busWrite((struct lcdEmu *)gpio, set, clr, 2) ;
+}
+
+// -----------------------------------------------------------------------------
+// Interface
+
+void lcdEmuInit(struct lcdEmu *emu, int bits, int rs, int strb, const int *dataPins)
+{
+  int i ;
+
+  memset(emu, 0, sizeof(*emu)) ;
+  emu->bits    = bits ;
+  emu->rsPin   = rs ;
+  emu->strbPin = strb ;
+  for (i = 0 ; i < bits ; i++) {
+    emu->dataPins [i] = dataPins [i] ;
+    emu->dataMask |= 1u << dataPins [i] ;
+  }
+
+  /* power-on reset state (datasheet, "Reset Function") */
+  emu->dl8 = 1 ;
+  emu->incr = 1 ;
+  memset(emu->ddram, ' ', sizeof(emu->ddram)) ;
+  emu->powerOn = delayNowNs() ;
+
+  gpioSetWriteHook(emuWrite) ;
+  gpioSetMaskHook(emuMask) ;
+}
+
+void lcdEmuStop(struct lcdEmu *emu)
+{
+  (void)emu ;
+  gpioSetWriteHook(NULL) ;
+  gpioSetMaskHook(NULL) ;
+}
+
+void lcdEmuLine(const struct lcdEmu *emu, int row, int cols, char *buf)
+{
+  int c ;
+
+  for (c = 0 ; c < cols ; c++)
+    buf [c] = emu->ddram [(row ? 0x40 : 0x00) + (c + emu->shift) % 40] ;
+  buf [cols] = '\0' ;
+}
+
+void lcdEmuReport(const struct lcdEmu *emu, FILE *out)
+{
+  uint64_t total = 0 ;
+  unsigned long n = 0 ;
+  int op ;
+
+  fprintf(out, "%-14s %8s %12s %10s %10s\n", "operation", "count", "bus(ms)", "avg(us)", "max(us)") ;
+  for (op = 0 ; op < EMU_OP_COUNT ; op++) {
+    const struct lcdEmuStats *s = &emu->ops [op] ;
+
+    if (s->count == 0)
+      continue ;
+    fprintf(out, "%-14s %8lu %12.3f %10.1f %10.1f\n", opNames [op], s->count,
+	    s->busNs / 1e6, s->busNs / 1e3 / s->count, s->maxNs / 1e3) ;
+    total += s->busNs ;
+    n += s->count ;
+  }
+  fprintf(out, "%-14s %8lu %12.3f   (%lu strobes, %lu GPIO stores)\n", "total", n, total / 1e6, emu->strobes, emu->stores) ;
+  fprintf(out, "timing violations: %lu%s%s\n", emu->violations,
+	  (emu->violations ? "; last: " : ""), emu->lastViolation) ;
+}
@@ -0,0 +1,68 @@
+/**
+ * lcdEmu.h - HD44780U emulator on a simulated GPIO register block
+ * Decodes the RS/E/data pin writes of lcdDriver.c, single or masked (all data
+ * lines at once), with a 4-bit or 8-bit connection, into controller instructions,
+ * keeps DDRAM/CGRAM state, checks datasheet timing and accounts bus time
+ */
+
+#ifndef LCD_EMU_H
+#define LCD_EMU_H
+
+#include <stdio.h>    /* Standard I/O */
+#include <stdint.h>   /* Integer types */
+
+/* Size of the simulated register block, in words (one page, as mapped by mmap) */
+#define EMU_REGS (4 * 1024 / 4)
+
+/* Classes of operations, for the bus time statistics */
+enum lcdEmuOp {
+  EMU_OP_CLEAR,
+  EMU_OP_HOME,
+  EMU_OP_ENTRY,
+  EMU_OP_CTRL,
+  EMU_OP_SHIFT,
+  EMU_OP_FUNC,
+  EMU_OP_CGRAM_ADDR,
+  EMU_OP_DDRAM_ADDR,
+  EMU_OP_WRITE_DDRAM,
+  EMU_OP_WRITE_CGRAM,
+  EMU_OP_COUNT
+};
+
+struct lcdEmuStats
+{
+  unsigned long count ;
+  uint64_t busNs, maxNs ;   /* from the first pin write of an operation to its last latch */
+} ;
+
+struct lcdEmu
+{
+  uint32_t regs [EMU_REGS] ;  /* simulated GPIO registers; must be the first member */
+
+  /* wiring, as passed to lcdInit() */
+  int bits, rsPin, strbPin ;
+  int dataPins [8] ;
+  uint32_t dataMask ;         /* data pins, as bits of GPIO bank 0 */
+
+  /* bus state */
+  int e, inOp, nibble, funcSets ;
+  unsigned char high ;
+  uint64_t powerOn, eRise, rsChange, dataChange, opStart, busyUntil ;
+
+  /* controller state */
+  int dl8, lines2, font, displayOn, cursorOn, blinkOn, incr, shiftOnWrite ;
+  int ac, cgMode, shift ;
+  unsigned char ddram [128], cgram [64] ;
+
+  /* statistics */
+  struct lcdEmuStats ops [EMU_OP_COUNT] ;
+  unsigned long strobes, stores, violations ;  /* stores: GPIO register writes on LCD pins */
+  char lastViolation [96] ;
+} ;
+
+void lcdEmuInit(struct lcdEmu *emu, int bits, int rs, int strb, const int *dataPins);  /* Power on; installs the GPIO write hooks */
+void lcdEmuStop(struct lcdEmu *emu);  /* Remove the GPIO write hooks */
+void lcdEmuLine(const struct lcdEmu *emu, int row, int cols, char *buf);  /* Visible text of a row, NUL terminated */
+void lcdEmuReport(const struct lcdEmu *emu, FILE *out);  /* Per-operation bus time and timing violations */
+
+#endif /* LCD_EMU_H */
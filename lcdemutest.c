@@ -0,0 +1,372 @@
+/*
+  A C program to test the LCD driver (lcdDriver.c) on the HD44780U emulator (lcdEmu.c).
+  It drives the display on a simulated GPIO block, checks its contents at each
+  stage and the absence of timing violations, and reports the bus time per
+  operation. It also records button input from a simulated player, and checks
+  that replaying it gives the same value. The same output is then sent over an
+  8-bit connection, whose bus time per character is compared with that of the
+  4-bit one. Finally the game itself (./master-mind, which must be built) plays
+  a scripted game on its own emulator (-V), over both connections, and the
+  screens its player reads, and the one it ends with, are checked.
+
+$ gcc -c lcdBinary.c lcdDriver.c lcdEmu.c mmTime.c lcdemutest.c
+$ gcc -o lcdemutest lcdemutest.o lcdBinary.o lcdDriver.o lcdEmu.o mmTime.o
+$ ./lcdemutest [-v]
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "lcdBinary.h"
+#include "lcdDriver.h"
+#include "lcdEmu.h"
+#include "mmTime.h"
+#include "mmReplay.h"
+
+/* same wiring as master-mind.c; with an 8-bit connection (-8), D0-D3 are added */
+#define STRB_PIN 24
+#define RS_PIN   25
+static const int dataPins [4] = { 23, 10, 27, 22 } ;
+static const int dataPins8 [8] = { 6, 12, 13, 16, 23, 10, 27, 22 } ;
+
+#define COLS 16
+#define ROWS 2
+
+/* button of master-mind.c, and the presses of the simulated player: */
+/* [start, end) in input time; the third press is the double press    */
+#define BUTTON 19
+static const unsigned int presses [3][2] = { { 100, 200 }, { 1500, 1600 }, { 1800, 1900 } } ;
+static uint64_t playerStart ;
+
+static struct lcdEmu emu ;
+static int ok = 0, n = 0, verbose = 0 ;
+
+/* compare both rows of the display with the expected text (padded with blanks) */
+static void check(const char *what, const char *exp0, const char *exp1)
+{
+  char row0 [COLS + 1], row1 [COLS + 1], pad0 [COLS + 1], pad1 [COLS + 1] ;
+
+  lcdEmuLine(&emu, 0, COLS, row0) ;
+  lcdEmuLine(&emu, 1, COLS, row1) ;
+  snprintf(pad0, sizeof(pad0), "%-16s", exp0) ;
+  snprintf(pad1, sizeof(pad1), "%-16s", exp1) ;
+
+  n++ ;
+  if (strcmp(row0, pad0) == 0 && strcmp(row1, pad1) == 0) {
+    ok++ ;
+    if (verbose)
+      fprintf(stdout, ".. OK     %s: [%s] [%s]\n", what, row0, row1) ;
+  } else {
+    fprintf(stdout, "** WRONG  %s: [%s] [%s], expected [%s] [%s]\n", what, row0, row1, pad0, pad1) ;
+  }
+}
+
+static void checkTrue(const char *what, int cond)
+{
+  n++ ;
+  if (cond) {
+    ok++ ;
+    if (verbose)
+      fprintf(stdout, ".. OK     %s\n", what) ;
+  } else {
+    fprintf(stdout, "** WRONG  %s\n", what) ;
+  }
+}
+
+/* idle hook: the simulated player, pressing the button on GPLEV0 */
+static void player(void)
+{
+  uint64_t t = buttonInputMs() - playerStart ;
+  int i, down = 0 ;
+
+  for (i = 0 ; i < 3 ; i++)
+    if (t >= presses [i][0] && t < presses [i][1])
+      down = 1 ;
+  if (down)
+    emu.regs [13] |= 1u << BUTTON ;
+  else
+    emu.regs [13] &= ~(1u << BUTTON) ;
+}
+
+/* a bar, then peg glyphs, drawn twice: custom characters are uploaded on first */
+/* use only. The bar takes CGRAM slot 0, which is NUL in a checked row           */
+static void pegs(struct lcdDataStruct *lcd)
+{
+  int i, k ;
+
+  for (k = 0 ; k < 2 ; k++) {
+    lcdClear(lcd) ;
+    lcdPuts(lcd, "Bar") ;
+    lcdBar(lcd, 11, 0, 5, 1, 5) ;
+    lcdClear(lcd) ;
+    lcdPuts(lcd, "Pegs") ;
+    lcdPosition(lcd, 10, 0) ;
+    lcdPutchar(lcd, GLYPH_CHAR(GLYPH_PEG_EXACT)) ;
+    for (i = 0 ; i < 2 ; i++)
+      lcdPutchar(lcd, GLYPH_CHAR(GLYPH_PEG_APPROX)) ;
+  }
+}
+
+/* scripted games of master-mind.c on its own emulator (-V): what its player reads */
+/* (-d), and the final screen. First the secret 321, with the guesses 123 and 321 */
+static const char *const gameScreens [] = {
+  "Screen: [Position 1      ] [Press button    ]",
+  "Screen: [Position 2      ] [Press button    ]",
+  "Screen: [Position 3      ] [Press button    ]",
+  "Screen: [Exact: 1  *     ] [Approx: 2 **    ]",
+  "Screen: [Exact 1 Appr 2  ] [Next?           ]",
+  "Screen: [Position 1      ] [Press button    ]",
+  "Screen: [Position 2      ] [Press button    ]",
+  "Screen: [Position 3      ] [Press button    ]",
+  "Screen: [Exact: 3  ***   ] [Approx: 0       ]",
+  "LCD: [SUCCESS!        ] [Solved in 2 try ]",
+  NULL
+} ;
+
+/* a code too long for the peg glyphs: 12345678, with the guesses 81234567 and 12345678 */
+static const char *const longScreens [] = {
+  "Screen: [Position 1      ] [Press button    ]",
+  "Screen: [Position 2      ] [Press button    ]",
+  "Screen: [Position 3      ] [Press button    ]",
+  "Screen: [Position 4      ] [Press button    ]",
+  "Screen: [Position 5      ] [Press button    ]",
+  "Screen: [Position 6      ] [Press button    ]",
+  "Screen: [Position 7      ] [Press button    ]",
+  "Screen: [Position 8      ] [Press button    ]",
+  "Screen: [Exact: 0        ] [Approx: 8       ]",
+  "Screen: [Exact 0 Appr 8  ] [Next?           ]",
+  "Screen: [Position 1      ] [Press button    ]",
+  "Screen: [Position 2      ] [Press button    ]",
+  "Screen: [Position 3      ] [Press button    ]",
+  "Screen: [Position 4      ] [Press button    ]",
+  "Screen: [Position 5      ] [Press button    ]",
+  "Screen: [Position 6      ] [Press button    ]",
+  "Screen: [Position 7      ] [Press button    ]",
+  "Screen: [Position 8      ] [Press button    ]",
+  "Screen: [Exact: 8        ] [Approx: 0       ]",
+  "LCD: [SUCCESS!        ] [Solved in 2 try ]",
+  NULL
+} ;
+
+/* play @guesses@ (script lines) in a game with options @opts@; the screens must be @exp@ */
+static void checkGame(const char *what, const char *opts, const char *guesses, const char *const *exp)
+{
+  char script [] = "/tmp/lcdemutest-XXXXXX", cmd [256], line [256] ;
+  int fd = mkstemp(script), k = 0, same = 1 ;
+  FILE *f, *p ;
+
+  if (fd < 0 || (f = fdopen(fd, "w")) == NULL) {
+    checkTrue(what, 0) ;
+    return ;
+  }
+  fprintf(f, "%s", guesses) ;
+  fclose(f) ;
+  snprintf(cmd, sizeof(cmd), "./master-mind -F -d %s -V %s < /dev/null 2> /dev/null", opts, script) ;
+  if ((p = popen(cmd, "r")) != NULL) {
+    while (fgets(line, sizeof(line), p) != NULL) {
+      if (strncmp(line, "Screen: ", 8) != 0 && strncmp(line, "LCD: ", 5) != 0)
+        continue ;
+      line [strcspn(line, "\n")] = '\0' ;
+      if (exp [k] == NULL || strcmp(line, exp [k]) != 0) {
+        if (same)
+          fprintf(stdout, "** %s: %s, expected %s\n", what, line, (exp [k] != NULL ? exp [k] : "the end")) ;
+        same = 0 ;
+      } else if (verbose) {
+        fprintf(stdout, "         %s\n", line) ;
+      }
+      if (exp [k] != NULL)
+        k++ ;
+    }
+    pclose(p) ;
+  }
+  unlink(script) ;
+  checkTrue(what, same && exp [k] == NULL) ;
+}
+
+int main (int argc, char **argv) {
+  static const unsigned char pegExact [8] = { 0b00000, 0b01110, 0b11111, 0b11111, 0b11111, 0b01110, 0b00000, 0b00000 } ;
+  struct lcdDataStruct *lcd ;
+  unsigned int uploads, bytes ;
+  unsigned long frames, commands, strobes ;
+  char exp0 [COLS + 1] ;
+  int opt, slot, slotA, i ;
+  uint64_t t0Full ;
+  double char4 ;
+
+  while ((opt = getopt(argc, argv, "v")) != -1) {
+    if (opt == 'v')
+      verbose = 1 ;
+    else {
+      fprintf(stderr, "Usage: %s [-v]\n", argv[0]) ;
+      exit(EXIT_FAILURE) ;
+    }
+  }
+
+  delayInit(NULL) ;
+
+  // fast boot from power-on (8-bit mode), with the datasheet's minimum waits
+  {
+    uint64_t t0 ;
+
+    lcdEmuInit(&emu, 4, RS_PIN, STRB_PIN, dataPins) ;
+    delay(20) ;	// power-on wait of the display
+    t0 = delayNowNs() ;
+    lcd = lcdInitMode(emu.regs, ROWS, COLS, 4, RS_PIN, STRB_PIN, dataPins, LCD_INIT_QUICK) ;
+    checkTrue("quick init: 4-bit interface, 2 lines, display on, no violations",
+	      lcd != NULL && !emu.dl8 && emu.lines2 && emu.displayOn && emu.violations == 0) ;
+    if (verbose)
+      fprintf(stdout, "LCD init from power-on: datasheet reset %.3f ms\n", (delayNowNs() - t0) / 1e6) ;
+    lcdEmuStop(&emu) ;
+    free(lcd) ;
+  }
+
+  lcdEmuInit(&emu, 4, RS_PIN, STRB_PIN, dataPins) ;
+  delay(20) ;	// power-on wait of the display
+
+  t0Full = delayNowNs() ;
+  lcd = lcdInit(emu.regs, ROWS, COLS, 4, RS_PIN, STRB_PIN, dataPins) ;
+  if (verbose)
+    fprintf(stdout, "LCD init from power-on: wiringPi sequence %.3f ms\n", (delayNowNs() - t0Full) / 1e6) ;
+  checkTrue("init: 4-bit interface, 2 lines, display on, no cursor",
+	    lcd != NULL && !emu.dl8 && emu.lines2 && emu.displayOn && !emu.cursorOn && !emu.blinkOn && emu.incr) ;
+  check("init", "", "") ;
+
+  lcdClear(lcd) ;
+  lcdPuts(lcd, "Welcome to") ;
+  lcdPosition(lcd, 1, 1) ;
+  lcdPuts(lcd, "MasterMind") ;
+  check("welcome", "Welcome to", " MasterMind") ;
+
+  // greeting is too long for the display: it scrolls, one shift command per frame
+  lcdScrollStart(lcd, "Hello Dsouza & Ahmed", "", 10) ;
+  check("greeting", "Hello Dsouza & A", "") ;
+  strobes = emu.strobes ;
+  for (i = 0 ; i < 6 ; i++) {
+    delay(10) ;
+    lcdScrollTick() ;
+  }
+  check("greeting, scrolled by 6", "Dsouza & Ahmed", "") ;
+  lcdScrollStats(&frames, &commands) ;
+  checkTrue("one command per scrolled frame", frames == 6 && commands == 6 && emu.strobes - strobes == 12) ;
+
+  pegs(lcd) ;
+  slot = lcdGlyph(lcd, GLYPH_PEG_EXACT) ;
+  slotA = lcdGlyph(lcd, GLYPH_PEG_APPROX) ;
+  snprintf(exp0, sizeof(exp0), "Pegs      %c%c%c", slot, slotA, slotA) ;
+  check("peg glyphs", exp0, "") ;
+  checkTrue("exact peg glyph in CGRAM", memcmp(&emu.cgram [slot * 8], pegExact, 8) == 0) ;
+
+  lcdGlyphStats(&uploads, &bytes) ;
+  checkTrue("glyphs uploaded once only", uploads == 3 && bytes == 24) ;
+
+  // button input: record the simulated player, then replay it without the player
+  {
+    char path [] = "/tmp/lcdemutest-XXXXXX" ;
+    int fd = mkstemp(path), secret [3] = { 3, 2, 1 }, value1, value2 ;
+    uint64_t ms1, ms2 ;
+
+    close(fd) ;
+    playerStart = buttonInputMs() ;
+    setIdleHook(player) ;
+    replayRecord(path, 1, secret, 3) ;
+    value1 = getButtonInput(emu.regs, BUTTON, 5, 5, 2) ;
+    ms1 = buttonInputMs() - playerStart ;
+    replayFinish(stdout) ;
+    checkTrue("recorded input: 3 presses and a double press", value1 == 4) ;
+
+    setIdleHook(NULL) ;
+    emu.regs [13] = 0 ;
+    playerStart = buttonInputMs() ;
+    checkTrue("recording loaded", replayLoad(path)) ;
+    value2 = getButtonInput(emu.regs, BUTTON, 5, 5, 2) ;
+    ms2 = buttonInputMs() - playerStart ;
+    checkTrue("replayed input: same value at the same input time", value2 == value1 && ms2 == ms1) ;
+    checkTrue("replayed input: same digest", replayFinish(verbose ? stdout : stderr)) ;
+    unlink(path) ;
+  }
+
+  checkTrue("no timing violations", emu.violations == 0) ;
+  if (verbose || emu.violations)
+    lcdEmuReport(&emu, stdout) ;
+
+  char4 = (double)emu.ops [EMU_OP_WRITE_DDRAM].busNs / emu.ops [EMU_OP_WRITE_DDRAM].count ;
+
+  // fast boot: the controller is still in 4-bit mode, as the game left it
+  {
+    struct lcdDataStruct *lcd2 ;
+    uint64_t t0 = delayNowNs(), tKeep, tQuick ;
+
+    lcd2 = lcdInitMode(emu.regs, ROWS, COLS, 4, RS_PIN, STRB_PIN, dataPins, LCD_INIT_KEEP) ;
+    tKeep = delayNowNs() - t0 ;
+    lcdPuts(lcd2, "Fast") ;
+    check("fast boot, kept 4-bit mode", "Fast", "") ;
+    free(lcd2) ;
+
+    t0 = delayNowNs() ;
+    lcd2 = lcdInitMode(emu.regs, ROWS, COLS, 4, RS_PIN, STRB_PIN, dataPins, LCD_INIT_QUICK) ;
+    tQuick = delayNowNs() - t0 ;
+    lcdPuts(lcd2, "Quick") ;
+    check("fast boot, datasheet reset from 4-bit mode", "Quick", "") ;
+    checkTrue("fast boot: no timing violations", emu.violations == 0 && !emu.dl8) ;
+    if (verbose)
+      fprintf(stdout, "LCD init: kept %.3f ms, datasheet reset %.3f ms\n", tKeep / 1e6, tQuick / 1e6) ;
+    free(lcd2) ;
+  }
+
+  lcdEmuStop(&emu) ;
+  free(lcd) ;
+
+  // 8-bit connection: the same game, one strobe per byte
+  {
+    const struct lcdEmuStats *w = &emu.ops [EMU_OP_WRITE_DDRAM] ;
+    double char8 ;
+
+    lcdEmuInit(&emu, 8, RS_PIN, STRB_PIN, dataPins8) ;
+    delay(20) ;	// power-on wait of the display
+    lcd = lcdInit(emu.regs, ROWS, COLS, 8, RS_PIN, STRB_PIN, dataPins8) ;
+    checkTrue("8-bit init: 8-bit interface, 2 lines, display on, no cursor",
+	      lcd != NULL && emu.dl8 && emu.lines2 && emu.displayOn && !emu.cursorOn && emu.incr) ;
+
+    pegs(lcd) ;
+    slot = lcdGlyph(lcd, GLYPH_PEG_EXACT) ;
+    slotA = lcdGlyph(lcd, GLYPH_PEG_APPROX) ;
+    snprintf(exp0, sizeof(exp0), "Pegs      %c%c%c", slot, slotA, slotA) ;
+    check("8-bit: peg glyphs", exp0, "") ;
+    checkTrue("8-bit: exact peg glyph in CGRAM", memcmp(&emu.cgram [slot * 8], pegExact, 8) == 0) ;
+    for (strobes = 0, i = 0 ; i < EMU_OP_COUNT ; i++)
+      strobes += emu.ops [i].count ;
+    checkTrue("8-bit: one strobe per operation", w->count > 0 && emu.strobes == strobes) ;
+    char8 = (double)w->busNs / w->count ;
+    checkTrue("8-bit: less bus time per character than 4-bit", char8 < char4) ;
+    checkTrue("8-bit: no timing violations", emu.violations == 0) ;
+    if (verbose || emu.violations)
+      lcdEmuReport(&emu, stdout) ;
+    if (verbose)
+      fprintf(stdout, "LCD bus time per character: 4-bit %.1f us, 8-bit %.1f us\n", char4 / 1e3, char8 / 1e3) ;
+    free(lcd) ;
+
+    lcd = lcdInitMode(emu.regs, ROWS, COLS, 8, RS_PIN, STRB_PIN, dataPins8, LCD_INIT_KEEP) ;
+    lcdPuts(lcd, "Fast") ;
+    check("8-bit: fast boot, kept 8-bit mode", "Fast", "") ;
+    free(lcd) ;
+    lcd = lcdInitMode(emu.regs, ROWS, COLS, 8, RS_PIN, STRB_PIN, dataPins8, LCD_INIT_QUICK) ;
+    lcdPuts(lcd, "Quick") ;
+    check("8-bit: fast boot, datasheet reset", "Quick", "") ;
+    checkTrue("8-bit: fast boot, no timing violations", emu.violations == 0 && emu.dl8) ;
+    free(lcd) ;
+    lcdEmuStop(&emu) ;
+  }
+
+  // the game itself, played by its scripted player, on both connections
+  checkGame("game: screens read by the player, and the last one", "-l 3 -c 3 -s 321",
+            "guess 123\nguess 321\n", gameScreens) ;
+  checkGame("8-bit: game: screens read by the player, and the last one", "-8 -l 3 -c 3 -s 321",
+            "guess 123\nguess 321\n", gameScreens) ;
+  checkGame("game of length 8: counts only, no glyphs wrapping", "-l 8 -c 8 -s 12345678",
+            "guess 81234567\nguess 12345678\n", longScreens) ;
+
+  fprintf(stdout, "%d of %d tests are OK\n", ok, n) ;
+  return (ok == n ? 0 : 1) ;
+}
@@ -0,0 +1,182 @@
+/* ***************************************************************************** */
+/* Non-blocking LED animations                                                   */
+/* A pattern is a sequence of keyframes (pin, value, hold time). Up to           */
+/* ANIM_PLAYERS patterns play at the same time on different LEDs; a pattern      */
+/* using an LED which is already animated is queued behind the last to end of    */
+/* the animations on its LEDs, so that no two of them drive an LED at once.      */
+/* ledAnimTick() applies the keyframes that are due and never blocks, so it can  */
+/* run from the idle hook while the game waits for button input.                 */
+/* ***************************************************************************** */
+
+#include <string.h>
+
+#include "lcdBinary.h"
+#include "ledAnim.h"
+#include "mmTime.h"
+#include "mmTrace.h"
+
+/* a keyframe due longer ago than this (in ns) restarts the pattern's clock, */
+/* rather than being applied in a burst with the following keyframes         */
+#define ANIM_LATE ((uint64_t)2 * IDLE_PERIOD * 1000000ULL)
+
+struct ledPlayer
+{
+  int active, n, idx ;
+  uint64_t pins ;	// bit mask of the pins used
+  uint64_t next ;	// when the next keyframe is due, in ns
+  struct ledKey keys [2 * ANIM_MAX_KEYS] ;
+} ;
+
+static uint32_t *gpio = NULL ;
+static struct ledPlayer players [ANIM_PLAYERS] ;
+
+// -----------------------------------------------------------------------------
+// Declaring patterns
+
+void ledPatternAdd(struct ledPattern *p, int pin, int value, unsigned int ms)
+{
+  if (p->n >= ANIM_MAX_KEYS)
+    return ;
+  p->keys [p->n].pin   = pin ;
+  p->keys [p->n].value = value ;
+  p->keys [p->n].ms    = ms ;
+  p->keys [p->n].hist  = NULL ;
+  p->n++ ;
+}
+
+void ledPatternMark(struct ledPattern *p, struct mmHist *hist, uint64_t since)
+{
+  if (p->n == 0 || since == 0)
+    return ;
+  p->keys [p->n - 1].hist  = hist ;
+  p->keys [p->n - 1].since = since ;
+}
+
+void ledPatternBlink(struct ledPattern *p, int pin, int count, unsigned int onMs, unsigned int offMs)
+{
+  int i ;
+
+  for (i = 0 ; i < count ; i++) {
+    ledPatternAdd(p, pin, HIGH, onMs) ;
+    ledPatternAdd(p, pin, LOW, offMs) ;
+  }
+}
+
+// -----------------------------------------------------------------------------
+// Playing patterns
+
+void ledAnimInit(uint32_t *g)
+{
+  gpio = g ;
+  memset(players, 0, sizeof(players)) ;
+}
+
+static uint64_t pinMask(const struct ledPattern *p)
+{
+  uint64_t mask = 0 ;
+  int i ;
+
+  for (i = 0 ; i < p->n ; i++)
+    mask |= 1ULL << (p->keys [i].pin & 63) ;
+  return mask ;
+}
+
+/* when the last hold time of a player is over, in ns */
+static uint64_t playerEnd(const struct ledPlayer *pl)
+{
+  uint64_t end = pl->next ;
+  int i ;
+
+  for (i = pl->idx ; i < pl->n ; i++)
+    end += (uint64_t)pl->keys [i].ms * 1000000ULL ;
+  return end ;
+}
+
+int ledAnimPlay(const struct ledPattern *p)
+{
+  uint64_t mask = pinMask(p) ;
+  struct ledPlayer *pl = NULL ;
+  int i ;
+
+  if (p->n == 0)
+    return 1 ;
+
+  /* queue behind the last to end of the patterns using one of the same LEDs; */
+  /* the others are over by then ...                                          */
+  for (i = 0 ; i < ANIM_PLAYERS ; i++)
+    if (players [i].active && (players [i].pins & mask) &&
+        (pl == NULL || playerEnd(&players [i]) > playerEnd(pl)))
+      pl = &players [i] ;
+  if (pl != NULL) {
+    if (pl->idx > 0) {	// drop the keyframes already played
+      memmove(pl->keys, pl->keys + pl->idx, (pl->n - pl->idx) * sizeof(struct ledKey)) ;
+      pl->n -= pl->idx ;
+      pl->idx = 0 ;
+    }
+    if (pl->n + p->n > 2 * ANIM_MAX_KEYS)
+      return 0 ;
+    memcpy(pl->keys + pl->n, p->keys, p->n * sizeof(struct ledKey)) ;
+    pl->n += p->n ;
+    pl->pins |= mask ;
+    return 1 ;
+  }
+
+  /* ... or start it on a free player */
+  for (i = 0 ; i < ANIM_PLAYERS && pl == NULL ; i++)
+    if (!players [i].active)
+      pl = &players [i] ;
+  if (pl == NULL)
+    return 0 ;
+
+  memcpy(pl->keys, p->keys, p->n * sizeof(struct ledKey)) ;
+  pl->n = p->n ;
+  pl->idx = 0 ;
+  pl->pins = mask ;
+  pl->next = delayNowNs() ;
+  pl->active = 1 ;
+  TRACE_INSTANT("led pattern", p->n) ;
+  ledAnimTick() ;	// the first keyframe is applied straight away
+  return 1 ;
+}
+
+void ledAnimTick(void)
+{
+  uint64_t now = delayNowNs() ;
+  struct ledPlayer *pl ;
+  struct ledKey *k ;
+  int i ;
+
+  for (i = 0 ; i < ANIM_PLAYERS ; i++) {
+    pl = &players [i] ;
+    while (pl->active && now >= pl->next) {
+      if (pl->idx == pl->n) {	// last hold time is over
+	pl->active = 0 ;
+	break ;
+      }
+      k = &pl->keys [pl->idx++] ;
+      TRACE_INSTANT(k->value ? "led on" : "led off", k->pin) ;
+      digitalWrite(gpio, k->pin, k->value) ;
+      if (k->hist != NULL)	// e.g. the acknowledgement of a press is visible now
+	histSince(k->hist, k->since) ;
+      if (now - pl->next > ANIM_LATE)
+	pl->next = now ;
+      pl->next += (uint64_t)k->ms * 1000000ULL ;
+    }
+  }
+}
+
+int ledAnimBusy(void)
+{
+  int i ;
+
+  for (i = 0 ; i < ANIM_PLAYERS ; i++)
+    if (players [i].active)
+      return 1 ;
+  return 0 ;
+}
+
+void ledAnimWait(void)
+{
+  while (ledAnimBusy() && !buttonAborted())
+    idleDelay(IDLE_PERIOD) ;
+}
@@ -0,0 +1,45 @@
+/**
+ * ledAnim.h - Non-blocking LED animations for the MasterMind game
+ * Patterns are keyframe sequences, advanced from the idle hook (see lcdBinary.h)
+ */
+
+#ifndef LED_ANIM_H
+#define LED_ANIM_H
+
+#include <stdint.h>   /* Integer types */
+
+#include "mmHist.h"   /* Latency histograms */
+
+/* Maximum number of keyframes in a pattern, and of patterns playing at once */
+#define ANIM_MAX_KEYS 96
+#define ANIM_PLAYERS  4
+
+/* one keyframe: set @pin@ to @value@, then hold for @ms@; if @hist@ is set, the */
+/* time from @since@ (histNowNs) to the write is recorded in it                  */
+struct ledKey
+{
+  int pin, value ;
+  unsigned int ms ;
+  struct mmHist *hist ;
+  uint64_t since ;
+} ;
+
+struct ledPattern
+{
+  int n ;
+  struct ledKey keys [ANIM_MAX_KEYS] ;
+} ;
+
+/* Declaring patterns */
+void ledPatternAdd(struct ledPattern *p, int pin, int value, unsigned int ms);  /* Append a keyframe */
+void ledPatternBlink(struct ledPattern *p, int pin, int count, unsigned int onMs, unsigned int offMs);  /* Append blinks */
+void ledPatternMark(struct ledPattern *p, struct mmHist *hist, uint64_t since);  /* Record the latency from @since@ to the write of the last keyframe */
+
+/* Playing patterns */
+void ledAnimInit(uint32_t *gpio);  /* LED pins must be configured as outputs */
+int ledAnimPlay(const struct ledPattern *p);  /* Start, or queue behind patterns on the same LEDs; 0 if no room */
+void ledAnimTick(void);  /* Apply all keyframes that are due; call regularly */
+int ledAnimBusy(void);  /* Is any pattern still playing? */
+void ledAnimWait(void);  /* Wait until all patterns have finished, running the idle hook */
+
+#endif /* LED_ANIM_H */
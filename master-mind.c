@@ -64,6 +64,22 @@
 #include <signal.h>
 
 #include "lcdBinary.h"
+#include "lcdDriver.h"
+#include "lcdEmu.h"
+#include "ledAnim.h"
+#include "mmTime.h"
+#include "mmTrace.h"
+#include "mmHist.h"
+#include "mmMatch.h"
+#include "mmServer.h"
+#include "mmArena.h"
+#include "mmLog.h"
+#include "mmReplay.h"
+#include "mmGuess.h"
+#include "mmEvil.h"
+#include "mmScore.h"
+#include "mmPlayer.h"
+#include "mmRt.h"
 #include <ctype.h>
 
 /* --------------------------------------------------------------------------- */
@@ -91,13 +107,14 @@
 #define TIMEOUT 3000000
 // in seconds: time window for button input
 #define INPUT_TIMEOUT 5  
+// in mili-seconds: time per frame when scrolling text on the LCD
+#define SCROLL_PERIOD 300
 
 // =======================================================
 // APP constants   ---------------------------------
-// number of colours, length of the sequence and maximum number of attempts
-#define COLS 3
-#define SEQL 3
-#define MAX_ATTEMPTS 5
+// the number of colours (colors, COLS by default, or -c), the length of the
+// sequence (seqlen, SEQL or -l) and the maximum number of attempts
+// (MAX_ATTEMPTS) are shared with the matchers and the server, in mmMatch.h
 
 // =======================================================
 
@@ -108,9 +125,6 @@
 #  define	FALSE	(1==2)
 #endif
 
-#define	PAGE_SIZE		(4*1024)
-#define	BLOCK_SIZE		(4*1024)
-
 #define	INPUT			 0
 #define	OUTPUT			 1
 
@@ -127,81 +141,95 @@
 #define DATA1_PIN 10
 #define DATA2_PIN 27
 #define DATA3_PIN 22
+// D0-D3 of the LCD (DATA0-3 above are D4-D7), only wired for an 8-bit connection (-8)
+#define LOW0_PIN   6
+#define LOW1_PIN  12
+#define LOW2_PIN  13
+#define LOW3_PIN  16
 
 /* ======================================================= */
 /* SECTION: constants and prototypes                       */
 /* ------------------------------------------------------- */
 
-// =======================================================
-// char data for the CGRAM, i.e. defining new characters for the display
-
-static unsigned char newChar [8] = 
-{
-  0b11111,
-  0b10001,
-  0b10001,
-  0b10101,
-  0b11111,
-  0b10001,
-  0b10001,
-  0b11111,
-} ;
-
 /* Constants */
 
-static const int colors = COLS;
-static const int seqlen = SEQL;
-
 static char* color_names[] = { "red", "green", "blue" };
 
 static int* theSeq = NULL;
 
 static int *seq1, *seq2, *cpy1, *cpy2;
 
-/* --------------------------------------------------------------------------- */
-
-// data structure holding data on the representation of the LCD
-struct lcdDataStruct
+/* all state of one game, with the sequences inline; theSeq, seq1 etc point */
+/* into it. It comes from a pool, and per-game scratch data (the guesses)   */
+/* from this thread's arena, so nothing is malloc'ed while playing          */
+struct mmGame
 {
-  int bits, rows, cols ;
-  int rsPin, strbPin ;
-  int dataPins [8] ;
-  int cx, cy ;
+  int secret [SEQL_MAX] ;
+  int seq1 [SEQL_MAX], seq2 [SEQL_MAX], cpy1 [SEQL_MAX], cpy2 [SEQL_MAX] ;
 } ;
 
-static int lcdControl ;
+static struct mmPool gamePool ;
+static struct mmGame *game = NULL ;
+static struct mmArena *scratch = NULL ;
+
+/* the game log (-L), and the record of the current game */
+static struct mmLog *gameLog = NULL ;
+static struct mmLogGame logRec ;
+
+/* seed for the secret; taken from the recording in a replay (-P) */
+static unsigned int seed ;
+
+/* fast boot (-F): a clean exit leaves this marker, holding the boot id and */
+/* the number of data lines, to tell the next start that the LCD controller */
+/* is still in that interface mode                                           */
+#define LCD_STATE_FILE "/run/master-mind.lcd"
+#define BOOT_ID_FILE   "/proc/sys/kernel/random/boot_id"
 
-/* ***************************************************************************** */
-/* INLINED fcts from wiringPi/devLib/lcd.c: */
-// HD44780U Commands (see Fig 11, p28 of the Hitachi HD44780U datasheet)
+static int fastBoot = 0, lcdReady = 0 ;
 
-#define	LCD_CLEAR	0x01
-#define	LCD_HOME	0x02
-#define	LCD_ENTRY	0x04
-#define	LCD_CTRL	0x08
-#define	LCD_CDSHIFT	0x10
-#define	LCD_FUNC	0x20
-#define	LCD_CGRAM	0x40
-#define	LCD_DGRAM	0x80
+/* LCD connection: 4 or 8 data lines (-8), and the pins (-W): RS, E, then */
+/* the data lines from the lowest; with 4 lines, those are D4-D7          */
+static int lcdBits = 4 ;
+static int lcdPins [2 + 8] = { RS_PIN, STRB_PIN, DATA0_PIN, DATA1_PIN, DATA2_PIN, DATA3_PIN } ;
+static const int lcdPins8 [2 + 8] = { RS_PIN, STRB_PIN, LOW0_PIN, LOW1_PIN, LOW2_PIN, LOW3_PIN,
+                                      DATA0_PIN, DATA1_PIN, DATA2_PIN, DATA3_PIN } ;
 
-// Bits in the entry register
+/* command-line options used while playing (see main) */
+static int verbose = 0, debug = 0 ;
+static char *opt_s = NULL, *opt_L = NULL, *opt_R = NULL ;
 
-#define	LCD_ENTRY_SH		0x01
-#define	LCD_ENTRY_ID		0x02
+/* the matcher for the size of the game: a specialisation, or the generic one */
+static matchFn match ;
 
-// Bits in the control register
+/* daemon (-D): games played, and requests from signal handlers; abortInput */
+/* makes the input functions return (see buttonSetAbort)                   */
+static int daemonMode = 0, games = 0 ;
+static volatile sig_atomic_t abortInput = 0, stopRequest = 0, hupRequest = 0 ;
 
-#define	LCD_BLINK_CTRL		0x01
-#define	LCD_CURSOR_CTRL		0x02
-#define	LCD_DISPLAY_CTRL	0x04
+/* hints (-H): the results so far as constraints (see mmGuess.h), and the  */
+/* search nodes per hint; most take a few hundred, and this bounds the rest */
+/* well below the 2 s the attempt is shown for                              */
+#define HINT_NODES 100000
+static int hints = 0 ;
+static struct mmGuesser hintGuesser ;
 
-// Bits in the function register
+/* adversarial host (-E): no secret fixed up front (see mmEvil.h) */
+static int evilMode = 0 ;
+static struct mmEvil host ;
 
-#define	LCD_FUNC_F	0x04
-#define	LCD_FUNC_N	0x08
-#define	LCD_FUNC_DL	0x10
+/* virtual hardware (-V): the GPIO registers are the LCD emulator's, time is */
+/* virtual, and the button is pressed by a scripted player (see mmPlayer.h) */
+static int virtualHw = 0 ;
+static struct lcdEmu emu ;
 
-#define	LCD_CDSHIFT_RL	0x04
+/* CGRAM traffic (see lcdGlyphStats): the totals before the current game, and */
+/* the traffic of the last game played                                        */
+static unsigned int glyphUploads, glyphBytes, lastUploads, lastBytes ;
+
+/* when the time to the next input started: start of main, or end of the last game */
+static uint64_t readySince ;
+
+/* --------------------------------------------------------------------------- */
 
 // Mask for the bottom 64 pins which belong to the Raspberry Pi
 //	The others are available for the other devices
@@ -210,6 +238,12 @@ static int lcdControl ;
 
 static unsigned int gpiobase ;
 static uint32_t *gpio ;
+static uint32_t *sysTimer ;
+
+/* end-to-end input latencies, printed in verbose mode */
+static struct mmHist histPress, histAck, histResult, histNext ;
+/* time per move of the adversarial host (-E) to partition the secrets alive */
+static struct mmHist histEvil ;
 
 static int timed_out = 0;
 
@@ -220,6 +254,7 @@ int failure(int fatal, const char *message, ...);
 void waitForEnter(void);
 void waitForButton(uint32_t *gpio, int button);
 void cleanupResources(void);
+void lcdMarkReady(void);
 void acknowledgeInput(uint32_t *gpio, int redLED);
 void echoInput(uint32_t *gpio, int greenLED, int count);
 void signalEndOfInput(uint32_t *gpio, int redLED);
@@ -239,22 +274,37 @@ void displaySurnameGreeting(uint32_t *gpio, int redLED, int greenLED, const char
 /* Implement these as C functions in this file                */
 /* ********************************************************** */
 
+/* start a new game: a fresh game object, and an empty scratch arena */
+static void newGame(void)
+{
+    if (gamePool.objSize == 0 &&
+        !poolInit(&gamePool, "game", sizeof(struct mmGame), 1, 1))
+        failure(TRUE, "Out of memory for the game");
+    if (scratch == NULL && (scratch = arenaLocal()) == NULL)
+        failure(TRUE, "Out of memory for the scratch arena");
+
+    if (game != NULL)
+        poolFree(&gamePool, game);
+    if ((game = (struct mmGame *)poolAlloc(&gamePool)) == NULL)
+        failure(TRUE, "No game object available");
+    arenaReset(scratch);
+
+    theSeq = game->secret;
+    seq1 = game->seq1;
+    seq2 = game->seq2;
+    cpy1 = game->cpy1;
+    cpy2 = game->cpy2;
+}
+
 /* initialise the secret sequence; by default it should be a random sequence */
 void initSeq()
 {
     int i;
     
-    /* Allocate memory for the secret sequence if not already done */
-    if (theSeq == NULL) {
-        theSeq = (int*)malloc(seqlen * sizeof(int));
-        if (theSeq == NULL) {
-            fprintf(stderr, "Memory allocation for the Sequence failed\n");
-            exit(EXIT_FAILURE);
-        }
-    }
+    /* the secret sequence is part of the game, see newGame() */
     
     /* Seed the random number generator */
-    srand(time(NULL));
+    srand(seed);
     
     /* Generate random sequence with values between 1 and colors */
     for (i = 0; i < seqlen; i++) {
@@ -262,118 +312,6 @@ void initSeq()
     }
 }
 
-/* display the sequence on the terminal window, using the format from the sample run in the spec */
-void showSeq(int *seq)
-{
-    int i;
-    
-    printf("Secret: ");
-    for (i = 0; i < seqlen; i++) {
-        printf("%d ", seq[i]);
-    }
-    printf("\n");
-}
-
-#define NAN1 8
-#define NAN2 9
-
-/* counts how many entries in seq2 match entries in seq1 */
-/* returns exact and approximate matches, either both encoded in one value, */
-/* or as a pointer to a pair of values */
-int countMatches(int *seq1, int *seq2)
-{
-    int i, j;
-    int exact = 0;
-    int approx = 0;
-    int *used1, *used2;
-    
-    /* Allocate arrays to track which elements have been matched */
-    used1 = (int*)malloc(seqlen * sizeof(int));
-    used2 = (int*)malloc(seqlen * sizeof(int));
-    
-    if (used1 == NULL || used2 == NULL) {
-        fprintf(stderr, "Memory allocation failed in countMatches\n");
-        exit(EXIT_FAILURE);
-    }
-    
-    /* Initialize arrays */
-    for (i = 0; i < seqlen; i++) {
-        used1[i] = 0;
-        used2[i] = 0;
-    }
-    
-    /* First pass: Count exact matches */
-    for (i = 0; i < seqlen; i++) {
-        if (seq1[i] == seq2[i]) {
-            exact++;
-            used1[i] = 1;
-            used2[i] = 1;
-        }
-    }
-    
-    /* Second pass: Count approximate matches */
-    for (i = 0; i < seqlen; i++) {
-        if (!used1[i]) {
-            for (j = 0; j < seqlen; j++) {
-                if (!used2[j] && seq1[i] == seq2[j]) {
-                    approx++;
-                    used1[i] = 1;
-                    used2[j] = 1;
-                    break;
-                }
-            }
-        }
-    }
-    
-    /* Free memory */
-    free(used1);
-    free(used2);
-    
-    /* Return result encoded: exact in tens, approximate in ones */
-    return (exact * 10) + approx;
-}
-
-/* show the results from calling countMatches on seq1 and seq1 */
-void showMatches(int code, int *seq1, int *seq2, int lcd_format)
-{
-    int exact = code / 10;
-    int approx = code % 10;
-    
-    if (lcd_format) {
-        /* Format for LCD display */
-        printf("%d exact\n%d approximate\n", exact, approx);
-    } else {
-        /* Format for terminal */
-        printf("Exact matches: %d\n", exact);
-        printf("Approximate matches: %d\n", approx);
-    }
-}
-
-/* parse an integer value as a list of digits, and put them into @seq@ */
-/* needed for processing command-line with options -s or -u            */
-void readSeq(int *seq, int val)
-{
-    int i;
-    int temp = val;
-    int divisor;
-    
-    /* Process each digit from left to right */
-    for (i = 0; i < seqlen; i++) {
-        divisor = 1;
-        for (int j = 0; j < seqlen - i - 1; j++) {
-            divisor *= 10;
-        }
-        
-        seq[i] = (temp / divisor);
-        temp %= divisor;
-        
-        /* Ensure values are in range 1-colors */
-        if (seq[i] < 1 || seq[i] > colors) {
-            seq[i] = 1;
-        }
-    }
-}
-
 /* read a guess sequence fron stdin and store the values in arr */
 /* only needed for testing the game logic, without button input */
 int readNum(int max)
@@ -420,17 +358,12 @@ static uint64_t startT, stopT;
 /* Implement these as C functions in this file                */
 /* ********************************************************** */
 
-/* you may need this function in timer_handler() below  */
-/* use the libc fct gettimeofday() to implement it      */
+/* you may need this function in timer_handler() below      */
+/* wall-clock time of the clock in use (see mmTime.h); on   */
+/* the real one, the same as gettimeofday()                 */
 uint64_t timeInMicroseconds()
 {
-    struct timeval tv;
-    uint64_t micros;
-    
-    gettimeofday(&tv, NULL);
-    micros = (uint64_t)(tv.tv_sec) * 1000000 + (uint64_t)(tv.tv_usec);
-    
-    return micros;
+    return delayWallNs() / 1000;
 }
 
 /* this should be the callback, triggered via an interval timer, */
@@ -446,6 +379,29 @@ void timer_handler(int signum)
     }
 }
 
+/* daemon (-D): SIGTERM and SIGINT stop, SIGHUP abandons the game, reopens */
+/* the game log and starts a new game; both stop waiting for input         */
+static void daemonSignal(int signum)
+{
+    if (signum == SIGHUP)
+        hupRequest = 1;
+    else
+        stopRequest = 1;
+    abortInput = 1;
+}
+
+static void daemonSignals(void)
+{
+    struct sigaction sa;
+    
+    memset(&sa, 0, sizeof(sa));
+    sa.sa_handler = daemonSignal;
+    sigaction(SIGTERM, &sa, NULL);
+    sigaction(SIGINT, &sa, NULL);
+    sigaction(SIGHUP, &sa, NULL);
+    buttonSetAbort(&abortInput);
+}
+
 /* initialise time-stamps, setup an interval timer, and install the timer_handler callback */
 void initITimer(uint64_t timeout)
 {
@@ -507,291 +463,104 @@ void waitForEnter (void)
   (void)fgetc (stdin) ;
 }
 
-/*
- * delay:
- *	Wait for some number of milliseconds
- *********************************************************************************
- */
-
-void delay (unsigned int howLong)
-{
-  struct timespec sleeper, dummy ;
-
-  sleeper.tv_sec  = (time_t)(howLong / 1000) ;
-  sleeper.tv_nsec = (long)(howLong % 1000) * 1000000 ;
-
-  nanosleep (&sleeper, &dummy) ;
-}
-
-/* From wiringPi code; comment by Gordon Henderson
- * delayMicroseconds:
- *	This is somewhat intersting. It seems that on the Pi, a single call
- *	to nanosleep takes some 80 to 130 microseconds anyway, so while
- *	obeying the standards (may take longer), it's not always what we
- *	want!
- *
- *	So what I'll do now is if the delay is less than 100uS we'll do it
- *	in a hard loop, watching a built-in counter on the ARM chip. This is
- *	somewhat sub-optimal in that it uses 100% CPU, something not an issue
- *	in a microcontroller, but under a multi-tasking, multi-user OS, it's
- *	wastefull, however we've no real choice )-:
- *
- *      Plan B: It seems all might not be well with that plan, so changing it
- *      to use gettimeofday () and poll on that instead...
- *********************************************************************************
- */
-
- void delayMicroseconds(unsigned int howLong)
- {
-     struct timespec sleeper;
-     unsigned int uSecs = howLong % 1000000;
-     unsigned int wSecs = howLong / 1000000;
-     
-     if (howLong == 0)
-         return;
-     else {
-         sleeper.tv_sec = wSecs;
-         sleeper.tv_nsec = (long)(uSecs * 1000L);
-         nanosleep(&sleeper, NULL);
-     }
- }
-
  /* Clean up resources */
 void cleanupResources(void)
 {
-    /* Free allocated memory */
-    if (theSeq != NULL) {
-        free(theSeq);
-        theSeq = NULL;
-    }
-    
-    if (seq1 != NULL) {
-        free(seq1);
-        seq1 = NULL;
+    /* Return the game to its pool; the sequences are part of it */
+    if (game != NULL) {
+        poolFree(&gamePool, game);
+        game = NULL;
+        theSeq = seq1 = seq2 = cpy1 = cpy2 = NULL;
     }
+    poolDestroy(&gamePool);
     
-    if (seq2 != NULL) {
-        free(seq2);
-        seq2 = NULL;
-    }
+    /* Tell the next fast boot that the LCD needs no reset */
+    if (fastBoot && lcdReady && !virtualHw)
+        lcdMarkReady();
     
-    if (cpy1 != NULL) {
-        free(cpy1);
-        cpy1 = NULL;
-    }
+    /* Flush the game log */
+    logClose(gameLog);
+    gameLog = NULL;
     
-    if (cpy2 != NULL) {
-        free(cpy2);
-        cpy2 = NULL;
+    /* Unmap GPIO memory; with -V it is the emulator's */
+    if (gpio != MAP_FAILED && gpio != NULL && !virtualHw) {
+        munmap((void*)gpio, BLOCK_SIZE);
     }
     
-    /* Unmap GPIO memory */
-    if (gpio != MAP_FAILED && gpio != NULL) {
-        munmap((void*)gpio, BLOCK_SIZE);
+    if (sysTimer != MAP_FAILED && sysTimer != NULL) {
+        munmap((void*)sysTimer, BLOCK_SIZE);
     }
 }
 
-/* ======================================================= */
-/* SECTION: LCD functions                                  */
-/* ------------------------------------------------------- */
-/* medium-level interface functions (all in C) */
-
-/* from wiringPi:
- * strobe:
- *	Toggle the strobe (Really the "E") pin to the device.
- *	According to the docs, data is latched on the falling edge.
- *********************************************************************************
- */
-
- void strobe(const struct lcdDataStruct *lcd)
- {
-     digitalWrite(gpio, lcd->strbPin, 1);
-     delayMicroseconds(50);
-     digitalWrite(gpio, lcd->strbPin, 0);
-     delayMicroseconds(50);
- }
-
-/*
- * sentDataCmd:
- *	Send an data or command byte to the display.
- *********************************************************************************
- */
-
- void sendDataCmd(const struct lcdDataStruct *lcd, unsigned char data)
- {
-     register unsigned char myData = data;
-     unsigned char i, d4;
-     
-     if (lcd->bits == 4) {
-         d4 = (myData >> 4) & 0x0F;
-         for (i = 0; i < 4; ++i) {
-             digitalWrite(gpio, lcd->dataPins[i], (d4 & 1));
-             d4 >>= 1;
-         }
-         strobe(lcd);
-         
-         d4 = myData & 0x0F;
-         for (i = 0; i < 4; ++i) {
-             digitalWrite(gpio, lcd->dataPins[i], (d4 & 1));
-             d4 >>= 1;
-         }
-     } else {
-         for (i = 0; i < 8; ++i) {
-             digitalWrite(gpio, lcd->dataPins[i], (myData & 1));
-             myData >>= 1;
-         }
-     }
-     strobe(lcd);
- }
-
-/*
- * lcdPutCommand:
- *	Send a command byte to the display
- *********************************************************************************
- */
-
- void lcdPutCommand(const struct lcdDataStruct *lcd, unsigned char command)
- {
- #ifdef DEBUG
-     fprintf(stderr, "lcdPutCommand: digitalWrite(%d,%d) and sendDataCmd(%d,%d)\n", lcd->rsPin, 0, lcd, command);
- #endif
-     digitalWrite(gpio, lcd->rsPin, 0);
-     sendDataCmd(lcd, command);
-     delay(2);
- }
-
- void lcdPut4Command(const struct lcdDataStruct *lcd, unsigned char command)
- {
-     register unsigned char myCommand = command;
-     register unsigned char i;
-     
-     digitalWrite(gpio, lcd->rsPin, 0);
-     
-     for (i = 0; i < 4; ++i) {
-         digitalWrite(gpio, lcd->dataPins[i], (myCommand & 1));
-         myCommand >>= 1;
-     }
-     strobe(lcd);
- }
-
-/*
- * lcdHome: lcdClear:
- *	Home the cursor or clear the screen.
- *********************************************************************************
- */
-
- void lcdHome(struct lcdDataStruct *lcd)
- {
- #ifdef DEBUG
-     fprintf(stderr, "lcdHome: lcdPutCommand(%d,%d)\n", lcd, LCD_HOME);
- #endif
-     lcdPutCommand(lcd, LCD_HOME);
-     lcd->cx = lcd->cy = 0;
-     delay(5);
- }
- 
- void lcdClear(struct lcdDataStruct *lcd)
- {
- #ifdef DEBUG
-     fprintf(stderr, "lcdClear: lcdPutCommand(%d,%d) and lcdPutCommand(%d,%d)\n", lcd, LCD_CLEAR, lcd, LCD_HOME);
- #endif
-     lcdPutCommand(lcd, LCD_CLEAR);
-     lcdPutCommand(lcd, LCD_HOME);
-     lcd->cx = lcd->cy = 0;
-     delay(5);
- }
-
-/*
- * lcdPosition:
- *	Update the position of the cursor on the display.
- *	Ignore invalid locations.
- *********************************************************************************
- */
-
- void lcdPosition(struct lcdDataStruct *lcd, int x, int y)
- {
-     if ((x > lcd->cols) || (x < 0))
-         return;
-     if ((y > lcd->rows) || (y < 0))
-         return;
-     
-     lcdPutCommand(lcd, x + (LCD_DGRAM | (y > 0 ? 0x40 : 0x00)));
-     
-     lcd->cx = x;
-     lcd->cy = y;
- }
-
-
-/*
- * lcdDisplay: lcdCursor: lcdCursorBlink:
- *	Turn the display, cursor, cursor blinking on/off
- *********************************************************************************
- */
-
- void lcdDisplay(struct lcdDataStruct *lcd, int state)
- {
-     if (state)
-         lcdControl |= LCD_DISPLAY_CTRL;
-     else
-         lcdControl &= ~LCD_DISPLAY_CTRL;
-     
-     lcdPutCommand(lcd, LCD_CTRL | lcdControl);
- }
- 
- void lcdCursor(struct lcdDataStruct *lcd, int state)
- {
-     if (state)
-         lcdControl |= LCD_CURSOR_CTRL;
-     else
-         lcdControl &= ~LCD_CURSOR_CTRL;
-     
-     lcdPutCommand(lcd, LCD_CTRL | lcdControl);
- }
- 
- void lcdCursorBlink(struct lcdDataStruct *lcd, int state)
- {
-     if (state)
-         lcdControl |= LCD_BLINK_CTRL;
-     else
-         lcdControl &= ~LCD_BLINK_CTRL;
-     
-     lcdPutCommand(lcd, LCD_CTRL | lcdControl);
- }
-
-/*
- * lcdPutchar:
- *	Send a data byte to be displayed on the display. We implement a very
- *	simple terminal here - with line wrapping, but no scrolling. Yet.
- *********************************************************************************
- */
-
- void lcdPutchar(struct lcdDataStruct *lcd, unsigned char data)
- {
-     digitalWrite(gpio, lcd->rsPin, 1);
-     sendDataCmd(lcd, data);
-     
-     if (++lcd->cx == lcd->cols) {
-         lcd->cx = 0;
-         if (++lcd->cy == lcd->rows)
-             lcd->cy = 0;
-         
-         lcdPutCommand(lcd, lcd->cx + (LCD_DGRAM | (lcd->cy > 0 ? 0x40 : 0x00)));
-     }
- }
-
+/* read the id of this boot of the Pi into @buf@; 0 if unknown */
+static int bootId(char *buf, int len)
+{
+    FILE *f = fopen(BOOT_ID_FILE, "r");
+    int ok;
+    
+    if (f == NULL)
+        return 0;
+    ok = (fgets(buf, len, f) != NULL);
+    fclose(f);
+    return ok;
+}
 
-/*
- * lcdPuts:
- *	Send a string to be displayed on the display
- *********************************************************************************
- */
+/* was the LCD left initialised, on as many data lines, by a clean exit since the Pi booted? */
+/* the marker is removed, so that a crash leaves none                 */
+static int lcdWasReady(void)
+{
+    char id[64], marked[64] = "", bits[8] = "";
+    FILE *f = fopen(LCD_STATE_FILE, "r");
+    
+    if (f == NULL)
+        return 0;
+    if (fgets(marked, sizeof(marked), f) == NULL || fgets(bits, sizeof(bits), f) == NULL)
+        marked[0] = '\0';
+    fclose(f);
+    unlink(LCD_STATE_FILE);
+    return bootId(id, sizeof(id)) && strcmp(id, marked) == 0 && atoi(bits) == lcdBits;
+}
 
- void lcdPuts(struct lcdDataStruct *lcd, const char *string)
- {
-     while (*string)
-         lcdPutchar(lcd, *string++);
- }
+void lcdMarkReady(void)
+{
+    char id[64];
+    FILE *f;
+    
+    if (!bootId(id, sizeof(id)) || (f = fopen(LCD_STATE_FILE, "w")) == NULL)
+        return;
+    fprintf(f, "%s%d\n", id, lcdBits);
+    fclose(f);
+}
 
+/* -W: "RS,E,D..." as GPIO numbers, with @bits@ data lines, into lcdPins; 0 if */
+/* malformed, not on the header (0-27), or the same as another pin             */
+static int parsePins(const char *arg, int bits)
+{
+    int pins[2 + 8], n = 0, i, j;
+    char *end;
+    long v;
+    
+    for (;;) {
+        v = strtol(arg, &end, 10);
+        if (end == arg || v < 0 || v > 27 || n == 2 + bits)
+            return 0;
+        pins[n++] = (int)v;
+        if (*end != ',')
+            break;
+        arg = end + 1;
+    }
+    if (*end != '\0' || n != 2 + bits)
+        return 0;
+    for (i = 0; i < n; i++) {
+        if (pins[i] == LED || pins[i] == LED2 || pins[i] == BUTTON)
+            return 0;
+        for (j = 0; j < i; j++)
+            if (pins[j] == pins[i])
+                return 0;
+    }
+    memcpy(lcdPins, pins, n * sizeof(int));
+    return 1;
+}
 
 /* ======================================================= */
 /* SECTION: aux functions for game logic                   */
@@ -805,109 +574,92 @@ void cleanupResources(void)
 /* --------------------------------------------------------------------------- */
 /* interface on top of the low-level pin I/O code */
 
+/* LED output is declared as keyframe patterns, played by ledAnim.c without */
+/* blocking the game; the patterns advance from the idle hook (idleTick)     */
+
 /* blink the led on pin @led@, @c@ times */
 void blinkN(uint32_t *gpio, int led, int c)
 {
-    int i;
+    struct ledPattern p = { 0 };
     
-    for (i = 0; i < c; i++) {
-        writeLED(gpio, led, HIGH);
-        delay(DELAY);
-        writeLED(gpio, led, LOW);
-        delay(DELAY);
-    }
+    ledPatternBlink(&p, led, c, DELAY, DELAY);
+    ledAnimPlay(&p);
 }
 
 /* Blink red LED once to acknowledge input */
 void acknowledgeInput(uint32_t *gpio, int redLED) {
-    writeLED(gpio, redLED, HIGH);
-    delay(DELAY);
-    writeLED(gpio, redLED, LOW);
+    struct ledPattern p = { 0 };
+    
+    ledPatternAdd(&p, redLED, HIGH, DELAY);
+    ledPatternMark(&p, &histAck, buttonLastPress());	// when the LED lights, which may be queued
+    ledPatternAdd(&p, redLED, LOW, 0);
+    ledAnimPlay(&p);
 }
 
 /* Blink green LED n times to echo input value */
 void echoInput(uint32_t *gpio, int greenLED, int count) {
-    for (int i = 0; i < count; i++) {
-        writeLED(gpio, greenLED, HIGH);
-        delay(DELAY);
-        writeLED(gpio, greenLED, LOW);
-        delay(DELAY/2); // Shorter delay between blinks
-    }
+    struct ledPattern p = { 0 };
+    
+    ledPatternBlink(&p, greenLED, count, DELAY, DELAY/2); // Shorter delay between blinks
+    ledAnimPlay(&p);
 }
 
 /* Blink red LED twice to indicate end of input */
 void signalEndOfInput(uint32_t *gpio, int redLED) {
-    for (int i = 0; i < 2; i++) {
-        writeLED(gpio, redLED, HIGH);
-        delay(DELAY);
-        writeLED(gpio, redLED, LOW);
-        delay(DELAY);
-    }
+    struct ledPattern p = { 0 };
+    
+    ledPatternBlink(&p, redLED, 2, DELAY, DELAY);
+    ledAnimPlay(&p);
 }
 
 /* Display match results with LED pattern */
 void displayMatchResults(uint32_t *gpio, int greenLED, int redLED, int exact, int approx) {
+    struct ledPattern p = { 0 };
+    
     // Blink green LED for exact matches
-    for (int i = 0; i < exact; i++) {
-        writeLED(gpio, greenLED, HIGH);
-        delay(DELAY);
-        writeLED(gpio, greenLED, LOW);
-        delay(DELAY/2);
-    }
+    ledPatternBlink(&p, greenLED, exact, DELAY, DELAY/2);
     
     // Red LED separator
-    delay(DELAY);
-    writeLED(gpio, redLED, HIGH);
-    delay(DELAY);
-    writeLED(gpio, redLED, LOW);
-    delay(DELAY);
+    ledPatternAdd(&p, redLED, LOW, DELAY);
+    ledPatternBlink(&p, redLED, 1, DELAY, DELAY);
     
     // Blink green LED for approximate matches
-    for (int i = 0; i < approx; i++) {
-        writeLED(gpio, greenLED, HIGH);
-        delay(DELAY);
-        writeLED(gpio, greenLED, LOW);
-        delay(DELAY/2);
-    }
+    ledPatternBlink(&p, greenLED, approx, DELAY, DELAY/2);
+    ledAnimPlay(&p);
 }
 
 /* Blink red LED three times to indicate new round */
 void signalNewRound(uint32_t *gpio, int redLED) {
-    for (int i = 0; i < 3; i++) {
-        writeLED(gpio, redLED, HIGH);
-        delay(DELAY);
-        writeLED(gpio, redLED, LOW);
-        delay(DELAY);
-    }
+    struct ledPattern p = { 0 };
+    
+    ledPatternBlink(&p, redLED, 3, DELAY, DELAY);
+    ledAnimPlay(&p);
 }
 
 /* Success pattern: green LED blinks three times while red LED is on */
 void displaySuccess(uint32_t *gpio, int greenLED, int redLED) {
-    writeLED(gpio, redLED, HIGH);
-    for (int i = 0; i < 3; i++) {
-        writeLED(gpio, greenLED, HIGH);
-        delay(DELAY);
-        writeLED(gpio, greenLED, LOW);
-        delay(DELAY);
-    }
-    writeLED(gpio, redLED, LOW);
+    struct ledPattern p = { 0 };
+    
+    ledPatternAdd(&p, redLED, HIGH, 0);
+    ledPatternBlink(&p, greenLED, 3, DELAY, DELAY);
+    ledPatternAdd(&p, redLED, LOW, 0);
+    ledAnimPlay(&p);
 }
 
 /* Surname-based greeting function */
 void displaySurnameGreeting(uint32_t *gpio, int redLED, int greenLED, const char *surname, struct lcdDataStruct *lcd) {
     int len = strlen(surname);
+    char line[LCD_LINE_LEN + 1];
+    struct ledPattern p = { 0 };
     
-    // Display surname on LCD
-    lcdClear(lcd);
-    lcdPuts(lcd, "Hello");
-    lcdPosition(lcd, 0, 1);
-    lcdPuts(lcd, surname);
-    delay(2000);
+    // Display greeting on LCD; it scrolls while the LEDs blink if it is too long
+    snprintf(line, sizeof(line), "Hello %s", surname);
+    lcdScrollStart(lcd, line, "", SCROLL_PERIOD);
     
-    // Turn off both LEDs initially
-    writeLED(gpio, redLED, LOW);
-    writeLED(gpio, greenLED, LOW);
-    delay(DELAY);
+    // Turn off both LEDs initially, after showing the greeting for 2s
+    ledPatternAdd(&p, redLED, LOW, 2000);
+    ledPatternAdd(&p, redLED, LOW, 0);
+    ledPatternAdd(&p, greenLED, LOW, DELAY);
     
     // Blink LEDs based on surname
     for (int i = 0; i < len; i++) {
@@ -915,341 +667,113 @@ void displaySurnameGreeting(uint32_t *gpio, int redLED, int greenLED, const char
         // Check if vowel (a, e, i, o, u)
         if (c == 'a' || c == 'e' || c == 'i' || c == 'o' || c == 'u') {
             // Blink green LED for vowel
-            writeLED(gpio, greenLED, HIGH);
-            delay(DELAY);
-            writeLED(gpio, greenLED, LOW);
+            ledPatternAdd(&p, greenLED, HIGH, DELAY);
+            ledPatternAdd(&p, greenLED, LOW, DELAY/2);
         } else if (c >= 'a' && c <= 'z') {
             // Blink red LED for consonant (only for letters)
-            writeLED(gpio, redLED, HIGH);
-            delay(DELAY);
-            writeLED(gpio, redLED, LOW);
+            ledPatternAdd(&p, redLED, HIGH, DELAY);
+            ledPatternAdd(&p, redLED, LOW, DELAY/2);
+        } else {
+            ledPatternAdd(&p, redLED, LOW, DELAY/2);
         }
-        delay(DELAY/2);
     }
     
     // Final confirmation pattern
     for (int i = 0; i < 2; i++) {
-        writeLED(gpio, greenLED, HIGH);
-        writeLED(gpio, redLED, HIGH);
-        delay(DELAY);
-        writeLED(gpio, greenLED, LOW);
-        writeLED(gpio, redLED, LOW);
-        delay(DELAY);
+        ledPatternAdd(&p, greenLED, HIGH, 0);
+        ledPatternAdd(&p, redLED, HIGH, DELAY);
+        ledPatternAdd(&p, greenLED, LOW, 0);
+        ledPatternAdd(&p, redLED, LOW, DELAY);
     }
     
-    // Clear LCD for next message
-    delay(1000);
+    // Keep the greeting for another second before the next message
+    ledPatternAdd(&p, redLED, LOW, 1000);
+    ledAnimPlay(&p);
+    ledAnimWait();
 }
 
 
-/* ======================================================= */
-/* SECTION: main fct                                       */
-/* ------------------------------------------------------- */
+/* run by the button polling loops and idleDelay(): advance timed LCD and LED output */
+static void idleTick(void) {
+    lcdScrollTick();
+    ledAnimTick();
+}
 
-int main(int argc, char *argv[])
+
+/* snapshot the CGRAM traffic at the start of a game, or take the game's share at its end */
+static void glyphsGame(int end)
 {
-    struct lcdDataStruct *lcd;
-    int bits, rows, cols;
-    unsigned char func;
-    
-    int found = 0, attempts = 0, i, j, code;
-    int c, d, buttonPressed, rel, foo;
-    int *attSeq;
-    
-    int pinLED = LED, pin2LED2 = LED2, pinButton = BUTTON;
-    int fSel, shift, pin, clrOff, setOff, off, res;
-    int fd;
-    
-    int exact, contained;
-    char str1[32];
-    char str2[32];
-    
-    struct timeval t1, t2;
-    int t;
-    
-    char buf[32];
-    
-    // variables for command-line processing
-    char str_in[20], str[20] = "some text";
-    int verbose = 0, debug = 0, help = 0, opt_m = 0, opt_n = 0, opt_s = 0, unit_test = 0, res_matches = 0;
-    
-    // Register cleanup function to be called on exit
-    atexit(cleanupResources);
-  
-  // -------------------------------------------------------
-  // process command-line arguments
+  unsigned int uploads, bytes;
 
-  // see: man 3 getopt for docu and an example of command line parsing
-  { // see the CW spec for the intended meaning of these options
-      int opt;
-      while ((opt = getopt(argc, argv, "hvdus:")) != -1) {
-          switch (opt) {
-              case 'v':
-                  verbose = 1;
-                  break;
-              case 'h':
-                  help = 1;
-                  break;
-              case 'd':
-                  debug = 1;
-                  break;
-              case 'u':
-                  unit_test = 1;
-                  break;
-              case 's':
-                  opt_s = atoi(optarg);
-                  break;
-              default: /* '?' */
-                  fprintf(stderr, "Usage: %s [-h] [-v] [-d] [-u <seq1> <seq2>] [-s <secret seq>]  \n", argv[0]);
-                  exit(EXIT_FAILURE);
-          }
-      }
+  lcdGlyphStats(&uploads, &bytes);
+  if (end) {
+    lastUploads = uploads - glyphUploads;
+    lastBytes = bytes - glyphBytes;
   }
-
-  if (help) {
-    fprintf(stderr, "MasterMind program, running on a Raspberry Pi, with connected LED, button and LCD display\n");
-    fprintf(stderr, "Use the button for input of numbers. The LCD display will show the matches with the secret sequence.\n");
-    fprintf(stderr, "For full specification of the program see: https://www.macs.hw.ac.uk/~hwloidl/Courses/F28HS/F28HS_CW2_2022.pdf\n");
-    fprintf(stderr, "Usage: %s [-h] [-v] [-d] [-u <seq1> <seq2>] [-s <secret seq>]  \n", argv[0]);
-    exit(EXIT_SUCCESS);
-}
-
-if (unit_test && optind >= argc - 1) {
-    fprintf(stderr, "Expected 2 arguments after option -u\n");
-    exit(EXIT_FAILURE);
+  glyphUploads = uploads;
+  glyphBytes = bytes;
 }
 
-if (verbose && unit_test) {
-    printf("1st argument = %s\n", argv[optind]);
-    printf("2nd argument = %s\n", argv[optind + 1]);
-}
+/* play one game on @lcd@: returns 1 if the secret was found, 0 if not, and */
+/* -1 if stopped by a signal (see buttonSetAbort)                           */
+static int playGame(struct lcdDataStruct *lcd)
+{
+  int found = 0, attempts = 0, i, j, code;
+  int *attSeq;
+  int pinLED = LED, pin2LED2 = LED2, pinButton = BUTTON;
+  int exact, contained, hint[SEQL_MAX];
+  char buf[64];
+  uint64_t inputMs, waitFrom;
+
+  games++;
+  memset(&logRec, 0, sizeof(logRec));
+  glyphsGame(0);
+
+  /* initialise the secret sequence; with -E, any code will do until the */
+  /* first guess, and it changes with every answer                        */
+  if (evilMode) {
+    if (!evilInit(&host, seqlen, colors))
+      failure(TRUE, "Too many codes for -E (at most %d), or out of memory\n", EVIL_CODES);
+    evilSecret(&host, theSeq);
+  } else if (opt_s == NULL)
+    initSeq();
+  else
+    readSeq(theSeq, opt_s);	// every game is a new object (see newGame)
+  if (replayActive())
+    memcpy(theSeq, replaySecret(seqlen), seqlen * sizeof(int));
+  if (debug)
+    showSeq(theSeq);
+  for (i = 0; i < seqlen; i++)
+    replayNote(theSeq[i]);
+  if (hints)
+    guessInit(&hintGuesser, seqlen, colors, (uint64_t)seed + games);
+
+  // Wait for user to start (clearing also stops the scrolling greeting); with -F,
+  // and in a daemon, the game starts at once, waiting for the button
+  replayPhase(NULL);
+  if (!fastBoot && !daemonMode && !replayActive()) {
+    lcdClear(lcd);
+    lcdPuts(lcd, "Press enter");
+    lcdPosition(lcd, 0, 1);
+    lcdPuts(lcd, "to start");
+    waitForEnter();
+  }
 
-if (verbose) {
-    fprintf(stdout, "Settings for running the program\n");
-    fprintf(stdout, "Verbose is %s\n", (verbose ? "ON" : "OFF"));
-    fprintf(stdout, "Debug is %s\n", (debug ? "ON" : "OFF"));
-    fprintf(stdout, "Unittest is %s\n", (unit_test ? "ON" : "OFF"));
-    if (opt_s)  fprintf(stdout, "Secret sequence set to %d\n", opt_s);
-}
+  // -R: record the button input of this game, for replays with -P
+  if (opt_R != NULL && !replayRecord(opt_R, seed, theSeq, seqlen))
+    failure(TRUE, "Cannot write the recording %s: %s\n", opt_R, strerror(errno));
 
-// Allocate memory for sequences
-seq1 = (int *)malloc(seqlen * sizeof(int));
-seq2 = (int *)malloc(seqlen * sizeof(int));
-cpy1 = (int *)malloc(seqlen * sizeof(int));
-cpy2 = (int *)malloc(seqlen * sizeof(int));
+  logRec.start = delayWallNs() / 1000000000ULL;
+  memcpy(logRec.secret, theSeq, sizeof(logRec.secret));
 
-if (seq1 == NULL || seq2 == NULL || cpy1 == NULL || cpy2 == NULL) {
-  fprintf(stderr, "Memory allocation failed\n");
-  exit(EXIT_FAILURE);
-}
-
-  // check for -u option, and if so run a unit test on the matching function
-  if (unit_test && argc > optind+1) { // more arguments to process; only needed with -u 
-    strcpy(str_in, argv[optind]);
-    opt_m = atoi(str_in);
-    strcpy(str_in, argv[optind+1]);
-    opt_n = atoi(str_in);
-    // CALL a test-matches function; see testm.c for an example implementation
-    readSeq(seq1, opt_m); // turn the integer number into a sequence of numbers
-    readSeq(seq2, opt_n); // turn the integer number into a sequence of numbers
-    if (verbose)
-      fprintf(stdout, "Testing matches function with sequences %d and %d\n", opt_m, opt_n);
-    res_matches = countMatches(seq1, seq2);
-    showMatches(res_matches, seq1, seq2, 1);
-    exit(EXIT_SUCCESS);
-  } 
-
-  if (opt_s) { // if -s option is given, use the sequence as secret sequence
-    if (theSeq==NULL)
-      theSeq = (int*)malloc(seqlen*sizeof(int));
-    readSeq(theSeq, opt_s);
-    if (verbose) {
-      fprintf(stderr, "Running program with secret sequence:\n");
-      showSeq(theSeq);
-    }
-  }
-  
-  // -------------------------------------------------------
-  // LCD constants, hard-coded: 16x2 display, using a 4-bit connection
-  bits = 4; 
-  cols = 16; 
-  rows = 2; 
-  // -------------------------------------------------------
-
-  printf("Raspberry Pi LCD driver, for a %dx%d display (%d-bit wiring) \n", cols, rows, bits);
-    
-    if (geteuid() != 0)
-        fprintf(stderr, "setup: Must be root. (Did you forget sudo?)\n");
-    
-    // init of guess sequence, and copies (for use in countMatches)
-    attSeq = (int *)malloc(seqlen * sizeof(int));
-    if (attSeq == NULL) {
-        fprintf(stderr, "Memory allocation failed for attSeq\n");
-        exit(EXIT_FAILURE);
-    }
-
-  // -----------------------------------------------------------------------------
-  // constants for RPi2
-  gpiobase = 0x3F200000 ;
-
-  // -----------------------------------------------------------------------------
-  // memory mapping 
-  // Open the master /dev/memory device
-
-  if ((fd = open ("/dev/mem", O_RDWR | O_SYNC | O_CLOEXEC) ) < 0)
-    return failure (FALSE, "setup: Unable to open /dev/mem: %s\n", strerror (errno)) ;
-
-  // GPIO:
-  gpio = (uint32_t *)mmap(0, BLOCK_SIZE, PROT_READ|PROT_WRITE, MAP_SHARED, fd, gpiobase) ;
-  if ((int32_t)gpio == -1)
-    return failure (FALSE, "setup: mmap (GPIO) failed: %s\n", strerror (errno)) ;
-
-  // -------------------------------------------------------
-  // Configuration of LED and BUTTON
-
-  /* ***  COMPLETE the code here  ***  */
-  pinMode(gpio, pinLED, OUTPUT);
-  pinMode(gpio, pin2LED2, OUTPUT);
-  pinMode(gpio, pinButton, INPUT);
-  pinMode(gpio, STRB_PIN, OUTPUT);
-  pinMode(gpio, RS_PIN, OUTPUT);
-  pinMode(gpio, DATA0_PIN, OUTPUT);
-  pinMode(gpio, DATA1_PIN, OUTPUT);
-  pinMode(gpio, DATA2_PIN, OUTPUT);
-  pinMode(gpio, DATA3_PIN, OUTPUT);
-  
-  // -------------------------------------------------------
-  // INLINED version of lcdInit (can only deal with one LCD attached to the RPi):
-  // you can use this code as-is, but you need to implement digitalWrite() and
-  // pinMode() which are called from this code
-  // Create a new LCD:
-  lcd = (struct lcdDataStruct *)malloc (sizeof (struct lcdDataStruct)) ;
-  if (lcd == NULL)
-    return -1 ;
-
-  // hard-wired GPIO pins
-  lcd->rsPin   = RS_PIN ;
-  lcd->strbPin = STRB_PIN ;
-  lcd->bits    = 4 ;
-  lcd->rows    = rows ;  // # of rows on the display
-  lcd->cols    = cols ;  // # of cols on the display
-  lcd->cx      = 0 ;     // x-pos of cursor
-  lcd->cy      = 0 ;     // y-pos of curosr
-
-  lcd->dataPins [0] = DATA0_PIN ;
-  lcd->dataPins [1] = DATA1_PIN ;
-  lcd->dataPins [2] = DATA2_PIN ;
-  lcd->dataPins [3] = DATA3_PIN ;
-  // lcd->dataPins [4] = d4 ;
-  // lcd->dataPins [5] = d5 ;
-  // lcd->dataPins [6] = d6 ;
-  // lcd->dataPins [7] = d7 ;
-
-  // lcds [lcdFd] = lcd ;
-
-  digitalWrite (gpio, lcd->rsPin,   0) ; 
-  pinMode (gpio, lcd->rsPin,   OUTPUT) ;
-  digitalWrite (gpio, lcd->strbPin, 0) ; 
-  pinMode (gpio, lcd->strbPin, OUTPUT) ;
-
-  for (i = 0 ; i < bits ; ++i)
-  {
-    digitalWrite (gpio, lcd->dataPins [i], 0) ;
-    pinMode      (gpio, lcd->dataPins [i], OUTPUT) ;
-  }
-  delay (35) ; // mS
-
-// Gordon Henderson's explanation of this part of the init code (from wiringPi):
-// 4-bit mode?
-//	OK. This is a PIG and it's not at all obvious from the documentation I had,
-//	so I guess some others have worked through either with better documentation
-//	or more trial and error... Anyway here goes:
-//
-//	It seems that the controller needs to see the FUNC command at least 3 times
-//	consecutively - in 8-bit mode. If you're only using 8-bit mode, then it appears
-//	that you can get away with one func-set, however I'd not rely on it...
-//
-//	So to set 4-bit mode, you need to send the commands one nibble at a time,
-//	the same three times, but send the command to set it into 8-bit mode those
-//	three times, then send a final 4th command to set it into 4-bit mode, and only
-//	then can you flip the switch for the rest of the library to work in 4-bit
-//	mode which sends the commands as 2 x 4-bit values.
-
-  if (bits == 4)
-  {
-    func = LCD_FUNC | LCD_FUNC_DL ;			// Set 8-bit mode 3 times
-    lcdPut4Command (lcd, func >> 4) ; 
-    delay (35) ;
-    lcdPut4Command (lcd, func >> 4) ; 
-    delay (35) ;
-    lcdPut4Command (lcd, func >> 4) ; 
-    delay (35) ;
-    func = LCD_FUNC ;					// 4th set: 4-bit mode
-    lcdPut4Command (lcd, func >> 4) ; 
-    delay (35) ;
-    lcd->bits = 4 ;
-  }
-  else
-  {
-    failure(TRUE, "setup: only 4-bit connection supported\n");
-    func = LCD_FUNC | LCD_FUNC_DL ;
-    lcdPutCommand  (lcd, func     ) ; delay (35) ;
-    lcdPutCommand  (lcd, func     ) ; delay (35) ;
-    lcdPutCommand  (lcd, func     ) ; delay (35) ;
-  }
-
-  if (lcd->rows > 1)
-  {
-    func |= LCD_FUNC_N ;
-    lcdPutCommand (lcd, func) ; delay (35) ;
-  }
-
-  // Rest of the initialisation sequence
-  lcdDisplay     (lcd, TRUE) ;
-  lcdCursor      (lcd, FALSE) ;
-  lcdCursorBlink (lcd, FALSE) ;
-  lcdClear       (lcd) ;
-
-  lcdPutCommand (lcd, LCD_ENTRY   | LCD_ENTRY_ID) ;    // set entry mode to increment address counter after write
-  lcdPutCommand (lcd, LCD_CDSHIFT | LCD_CDSHIFT_RL) ;  // set display shift to right-to-left
-
-  // END lcdInit ------
-  // -----------------------------------------------------------------------------
-  // Start of game
-  fprintf(stderr,"Printing welcome message on the LCD display ...\n");
-  /* ***  COMPLETE the code here  ***  */
-  fprintf(stderr, "Printing welcome message on the LCD display ...\n");
-    
-  // Welcome message
-  lcdClear(lcd);
-  lcdPuts(lcd, "Welcome to");
-  lcdPosition(lcd, 1, 1);
-  lcdPuts(lcd, "MasterMind");
-  delay(2000);
-  lcdClear(lcd);
-  
-  displaySurnameGreeting(gpio, pin2LED2, pinLED, "Dsouza & Ahmed", lcd);
-
-  /* initialise the secret sequence */
-  if (!opt_s)
-    initSeq();
-  if (debug)
-    showSeq(theSeq);
-
-  // Wait for user to start
-  lcdPuts(lcd, "Press enter");
-  lcdPosition(lcd, 0, 1);
-  lcdPuts(lcd, "to start");
-  waitForEnter();
-
-  // -----------------------------------------------------------------------------
-  // +++++ main loop
+  // -----------------------------------------------------------------------------
+  // +++++ main loop
 
 // Turn LEDs off at start
   writeLED(gpio, pinLED, LOW);
   writeLED(gpio, pin2LED2, LOW);
 // Main game loop - player has MAX_ATTEMPTS attempts to guess the sequence
-while (!found && attempts < MAX_ATTEMPTS) {
+while (!found && attempts < MAX_ATTEMPTS && !buttonAborted()) {
 
     /* ******************************************************* */
     /* ***  COMPLETE the code here  ***                        */
@@ -1263,20 +787,38 @@ while (!found && attempts < MAX_ATTEMPTS) {
     /* ***  COMPLETE the code here  ***  */
 
   // Clear LCD for new attempt
+        replayPhase("attempt");
         lcdClear(lcd);
         
         // Print attempt number
         printf("Attempt: %d\n", attempts + 1);
         
-        // Show attempt number on LCD
-        lcdPuts(lcd, "Starting");
+        // Show attempt number on LCD; with -H, a code that fits all results so far
+        // instead of "Starting"
+        if (hints && guessNext(&hintGuesser, hint, HINT_NODES) > 0) {
+            strcpy(buf, "Try ");
+            for (j = 0; j < seqlen; j++)
+                buf[4 + j] = (char)pegChar(hint[j]);
+            buf[4 + seqlen] = '\0';
+            printf("%s\n", buf);
+            lcdPuts(lcd, buf);
+        } else
+            lcdPuts(lcd, "Starting");
         lcdPosition(lcd, 0, 1);
         sprintf(buf, "Attempt: %d", attempts + 1);
         lcdPuts(lcd, buf);
-        delay(2000);
+        lcdBar(lcd, 11, 1, 5, attempts + 1, MAX_ATTEMPTS);
+        if ((!fastBoot && !daemonMode) || attempts > 0)
+            idleDelay(2000);
         
-    // Get input for each position in the sequence
-for (i = 0; i < seqlen; i++) {
+    // Get input for each position in the sequence; every guess is kept in the
+    // scratch arena until the next game
+    attSeq = (int *)arenaAlloc(scratch, seqlen * sizeof(int));
+    if (attSeq == NULL)
+        failure(TRUE, "Scratch arena full");
+    replayPhase("input");
+    inputMs = 0;
+for (i = 0; i < seqlen && !buttonAborted(); i++) {
     lcdClear(lcd);
     lcdPuts(lcd, "Position ");
     sprintf(buf, "%d", i + 1);
@@ -1284,8 +826,24 @@ for (i = 0; i < seqlen; i++) {
     lcdPosition(lcd, 0, 1);
     lcdPuts(lcd, "Press button");
     
-    // Use the improved function to get input
+    // Start-up time: from exec (well, main), or from the end of the last game,
+    // to waiting for the first input
+    if (readySince != 0) {
+        if (games == 1 && (fastBoot || verbose))
+            fprintf(stderr, "Ready for input %.1f ms after start\n", (delayNowNs() - readySince) / 1e6);
+        if (games > 1) {
+            histRecord(&histNext, delayNowNs() - readySince);
+            if (verbose)
+                fprintf(stderr, "Ready for input %.1f ms after the last game\n", (delayNowNs() - readySince) / 1e6);
+        }
+        readySince = 0;
+    }
+    
+    // Use the improved function to get input; only the time spent waiting for
+    // the player counts as input time, not the acknowledgements and screens
+    waitFrom = buttonInputMs();
     int selectedValue = getButtonInput(gpio, pinButton, colors, INPUT_TIMEOUT, 2);
+    inputMs += buttonInputMs() - waitFrom;
     
     // Acknowledge input with red LED
     acknowledgeInput(gpio, pin2LED2);
@@ -1295,17 +853,22 @@ for (i = 0; i < seqlen; i++) {
     
     // Store the value
     attSeq[i] = selectedValue;
+    replayNote(selectedValue);
     
     // Show the selected value on LCD
     lcdClear(lcd);
     lcdPuts(lcd, "Position ");
-    sprintf(buf, "%d: %d", i + 1, attSeq[i]);
+    sprintf(buf, "%d: %c", i + 1, pegChar(attSeq[i]));
     lcdPuts(lcd, buf);
-    delay(1000);
+    idleDelay(1000);
 }
 
+if (buttonAborted())
+    break;
+
 // Signal end of input sequence
 signalEndOfInput(gpio, pin2LED2);
+logRec.inputMs[attempts] = (unsigned int)inputMs;
         
         // Display the entered sequence
         if (debug) {
@@ -1314,18 +877,52 @@ signalEndOfInput(gpio, pin2LED2);
         }
         
         // Calculate matches
-code = countMatches(theSeq, attSeq);
-exact = code / 10;
-contained = code % 10;
-
-// Display result on LCD
+replayPhase("match");
+if (evilMode) {
+    // the host answers with the largest class, and picks a secret from it
+    evilAnswer(&host, attSeq, theSeq);
+    histRecord(&histEvil, host.ns);
+    memcpy(logRec.secret, theSeq, sizeof(logRec.secret));
+    printf("Host: %d secrets left (partition %.3f ms)\n", host.n, host.ns / 1e6);
+}
+TRACE_BEGIN(traceMatch);
+code = match(theSeq, attSeq);
+TRACE_END(traceMatch, "match", code);
+exact = MATCH_EXACT(code);
+contained = MATCH_APPROX(code);
+memcpy(logRec.guess[attempts], attSeq, sizeof(logRec.guess[attempts]));
+logRec.result[attempts] = code;
+if (hints)
+    guessAdd(&hintGuesser, attSeq, code);
+
+replayNote(code);
+
+// Display result on LCD, with one peg glyph per match from column 10; for codes
+// too long for that (more than 6 pegs on a 16x2 display) the counts only, as the
+// glyphs would wrap onto the other line
+replayPhase("result");
+TRACE_BEGIN(traceResult);
 lcdClear(lcd);
 lcdPosition(lcd, 0, 0);
 sprintf(buf, "Exact: %d", exact);
 lcdPuts(lcd, buf);
+if (seqlen <= lcd->cols - 10) {
+    lcdPosition(lcd, 10, 0);
+    for (j = 0; j < exact; j++)
+        lcdPutchar(lcd, GLYPH_CHAR(GLYPH_PEG_EXACT));
+}
 lcdPosition(lcd, 0, 1);
 sprintf(buf, "Approx: %d", contained);
 lcdPuts(lcd, buf);
+if (seqlen <= lcd->cols - 10) {
+    lcdPosition(lcd, 10, 1);
+    for (j = 0; j < contained; j++)
+        lcdPutchar(lcd, GLYPH_CHAR(GLYPH_PEG_APPROX));
+}
+TRACE_END(traceResult, "lcd result", code);
+if (virtualHw && debug)    // -V -d: the result too, which the player reads but does not act on
+    playerShow(stdout, "Screen");
+histSince(&histResult, buttonLastPress());
 
 // Display match results with LED pattern
 displayMatchResults(gpio, pinLED, pin2LED2, exact, contained);
@@ -1337,9 +934,14 @@ if (exact == seqlen) {
     // Display success pattern
     displaySuccess(gpio, pinLED, pin2LED2);
 } else {
-    // Wait for button press to continue
-    delay(2000);
-    lcdPosition(lcd, 10, 1);
+    // Wait for button press to continue; the prompt gets a screen of its own, with
+    // the counts, as the peg glyphs leave no room for it
+    replayPhase("next");
+    idleDelay(2000);
+    lcdClear(lcd);
+    sprintf(buf, "Exact %d Appr %d", exact, contained);
+    lcdPuts(lcd, buf);
+    lcdPosition(lcd, 0, 1);
     lcdPuts(lcd, "Next?");
     waitForButton(gpio, pinButton);
     attempts++;
@@ -1349,7 +951,22 @@ if (exact == seqlen) {
     }
     }
     
+// Stopped by a signal (daemon): no game over screens, and the game is logged as abandoned
+if (buttonAborted()) {
+    replayPhase(NULL);
+    glyphsGame(1);
+    if (gameLog != NULL && attempts > 0) {
+        logRec.flags = 0;
+        logRec.attempts = attempts;
+        logGame(gameLog, &logRec);
+    }
+    return -1;
+}
+
 // Game over - display result
+replayPhase("end");
+replayNote(found);
+replayNote(attempts);
 if (found) {
     lcdClear(lcd);
     lcdPosition(lcd, 0, 0);
@@ -1361,30 +978,489 @@ if (found) {
     // Display success pattern again
     displaySuccess(gpio, pinLED, pin2LED2);
 } else {
-    lcdClear(lcd);
-    lcdPosition(lcd, 0, 0);
-    lcdPuts(lcd, "Game Over!");
-    lcdPosition(lcd, 0, 1);
-    lcdPuts(lcd, "Secret was:");
+    // Show the secret on the LCD, scrolling as it does not fit
+    sprintf(buf, "Secret was:");
+    for (i = 0; i < seqlen; i++)
+        sprintf(buf + strlen(buf), " %c", pegChar(theSeq[i]));
+    lcdScrollStart(lcd, "Game Over!", buf, SCROLL_PERIOD);
     
     // Show the secret sequence
-    if (debug) {
-        printf("Secret: ");
-        showSeq(theSeq);
-    }
+    if (debug)
+        showSeq(theSeq);  // "Secret: ..."
     
     // Failure pattern
-    for (i = 0; i < 3; i++) {
-        writeLED(gpio, pin2LED2, HIGH);
-        delay(DELAY*2);
-        writeLED(gpio, pin2LED2, LOW);
-        delay(DELAY);
+    {
+        struct ledPattern p = { 0 };
+        
+        ledPatternBlink(&p, pin2LED2, 3, DELAY*2, DELAY);
+        ledAnimPlay(&p);
     }
 }
+
+    // Log the game; written out with buffered I/O, so not in the input loop
+    if (gameLog != NULL) {
+        logRec.flags = LOG_OVER | (found ? LOG_WON : 0);
+        logRec.attempts = (found ? attempts + 1 : attempts);
+        if (!logGame(gameLog, &logRec))
+            fprintf(stderr, "Cannot write to the game log %s: %s\n", opt_L, strerror(errno));
+    }
+    
+    // Let the LED patterns (and the scrolling secret) finish
+    ledAnimWait();
+    replayPhase(NULL);
+    glyphsGame(1);
+    return found;
+    
+}
+
+/* ======================================================= */
+/* SECTION: main fct                                       */
+/* ------------------------------------------------------- */
+
+int main(int argc, char *argv[])
+{
+    struct lcdDataStruct *lcd;
+    int bits, rows, cols;
+    unsigned char func;
+    
+    int c, d, buttonPressed, rel, foo;
+    
+    int pinLED = LED, pin2LED2 = LED2, pinButton = BUTTON;
+    int fSel, shift, pin, clrOff, setOff, off, res;
+    int fd;
+    
+    char str1[32];
+    char str2[32];
+    
+    struct timeval t1, t2;
+    int t;
+    
+    // variables for command-line processing
+    char str[20] = "some text";
+    int help = 0, unit_test = 0, res_matches = 0;
+    int opt_l = SEQL, opt_c = COLS;
+    char *opt_S = NULL, *opt_P = NULL, *opt_W = NULL, *opt_V = NULL;
+    int opt_T = 0, opt_A = -1;
+    uint64_t realStart = 0;
+    const struct scorer *scoring;
+    
+    // start-up time is measured from here
+    readySince = delayNowNs();
+    
+    // Register cleanup function to be called on exit
+    atexit(cleanupResources);
+  
+  // -------------------------------------------------------
+  // process command-line arguments
+
+  // see: man 3 getopt for docu and an example of command line parsing
+  { // see the CW spec for the intended meaning of these options
+      int opt;
+      while ((opt = getopt(argc, argv, "hvdus:l:c:S:L:R:P:FDHE8W:T:A:V:")) != -1) {
+          switch (opt) {
+              case 'v':
+                  verbose = 1;
+                  break;
+              case 'h':
+                  help = 1;
+                  break;
+              case 'd':
+                  debug = 1;
+                  break;
+              case 'u':
+                  unit_test = 1;
+                  break;
+              case 's':
+                  opt_s = optarg;
+                  break;
+              case 'l':
+                  opt_l = atoi(optarg);
+                  break;
+              case 'c':
+                  opt_c = atoi(optarg);
+                  break;
+              case 'S':
+                  opt_S = optarg;
+                  break;
+              case 'L':
+                  opt_L = optarg;
+                  break;
+              case 'R':
+                  opt_R = optarg;
+                  break;
+              case 'P':
+                  opt_P = optarg;
+                  break;
+              case 'F':
+                  fastBoot = 1;
+                  break;
+              case 'D':
+                  daemonMode = 1;
+                  break;
+              case 'H':
+                  hints = 1;
+                  break;
+              case 'E':
+                  evilMode = 1;
+                  break;
+              case '8':
+                  lcdBits = 8;
+                  break;
+              case 'W':
+                  opt_W = optarg;
+                  break;
+              case 'T':
+                  opt_T = atoi(optarg);
+                  break;
+              case 'A':
+                  opt_A = atoi(optarg);
+                  break;
+              case 'V':
+                  opt_V = optarg;
+                  break;
+              default: /* '?' */
+                  fprintf(stderr, "Usage: %s [-h] [-v] [-d] [-u <seq1> <seq2> | -u <file>|-] [-s <secret seq>] [-l <length>] [-c <colours>] [-S <socket>] [-L <log file>] [-R <recording> | -P <recording>] [-F] [-D] [-H] [-E] [-8] [-W <RS,E,data pins>] [-T <priority> [-A <cpu>]] [-V <script>]  \n", argv[0]);
+                  exit(EXIT_FAILURE);
+          }
+      }
+  }
+
+  if (help) {
+    fprintf(stderr, "MasterMind program, running on a Raspberry Pi, with connected LED, button and LCD display\n");
+    fprintf(stderr, "Use the button for input of numbers. The LCD display will show the matches with the secret sequence.\n");
+    fprintf(stderr, "For full specification of the program see: https://www.macs.hw.ac.uk/~hwloidl/Courses/F28HS/F28HS_CW2_2022.pdf\n");
+    fprintf(stderr, "Usage: %s [-h] [-v] [-d] [-u <seq1> <seq2> | -u <file>|-] [-s <secret seq>] [-l <length>] [-c <colours>] [-S <socket>] [-L <log file>] [-R <recording> | -P <recording>] [-F] [-D] [-H] [-E] [-8] [-W <RS,E,data pins>] [-T <priority> [-A <cpu>]] [-V <script>]  \n", argv[0]);
+    exit(EXIT_SUCCESS);
+}
+
+// -l, -c: size of the game; sequences of more than 9 colours use a-z for 10 and up
+if (!matchSetSize(opt_l, opt_c)) {
+    fprintf(stderr, "Length must be 1 to %d, and colours 1 to %d\n", SEQL_MAX, COLS_MAX);
+    exit(EXIT_FAILURE);
+}
+match = matcherBest()->fn;
+scoring = scoreInit();
+
+// -8, -W: the LCD connection; the default pins are those of the wiring above
+if (lcdBits == 8)
+    memcpy(lcdPins, lcdPins8, sizeof(lcdPins));
+if (opt_W != NULL && !parsePins(opt_W, lcdBits)) {
+    fprintf(stderr, "-W needs RS, E and %d data pins from D%d up, as distinct GPIO numbers 0-27 other than %d, %d and %d\n",
+            lcdBits, 8 - lcdBits, LED, LED2, BUTTON);
+    exit(EXIT_FAILURE);
+}
+
+// -T, -A: real-time mode at this SCHED_FIFO priority, on this CPU (see mmRt.h)
+if ((opt_T != 0 && (opt_T < 1 || opt_T > 99)) || (opt_A >= 0 && opt_T == 0) || opt_A < -1) {
+    fprintf(stderr, "-T needs a priority from 1 to 99; -A a CPU number, with -T\n");
+    exit(EXIT_FAILURE);
+}
+
+if (unit_test && optind >= argc) {
+    fprintf(stderr, "Expected 2 arguments, or a file of test cases, after option -u\n");
+    exit(EXIT_FAILURE);
+}
+
+// -u with a file (or - for stdin) of "secret guess exact approx" lines: check them all
+if (unit_test && optind == argc - 1) {
+    unsigned long cases;
+    uint64_t t0 = delayNowNs();
+    int failures;
+    
+    fd = (strcmp(argv[optind], "-") == 0 ? 0 : open(argv[optind], O_RDONLY));
+    if (fd < 0) {
+        fprintf(stderr, "Cannot open %s: %s\n", argv[optind], strerror(errno));
+        exit(EXIT_FAILURE);
+    }
+    failures = matchBatch(fd, countMatches, &cases);
+    if (failures < 0)
+        exit(EXIT_FAILURE);
+    fprintf(stdout, "%lu of %lu cases are OK\n", cases - failures, cases);
+    if (verbose)
+        fprintf(stderr, "%.1f million cases per second\n",
+                cases / ((delayNowNs() - t0) / 1e9) / 1e6);
+    exit(failures == 0 ? EXIT_SUCCESS : EXIT_FAILURE);
+}
+
+// -V: simulated hardware on the virtual clock, played by a script; all time from here
+// on is virtual, so the games take as long as their computation
+if (opt_V != NULL) {
+    if (opt_S != NULL || opt_R != NULL || opt_P != NULL || daemonMode) {
+        fprintf(stderr, "-V plays the games of its script; not with -S, -R, -P or -D\n");
+        exit(EXIT_FAILURE);
+    }
+    if (!playerLoad(opt_V, seqlen, colors)) {
+        fprintf(stderr, "Cannot play the script %s: %s\n", opt_V, strerror(errno));
+        exit(EXIT_FAILURE);
+    }
+    virtualHw = 1;
+    realStart = clockReal.now();	// the real time taken, for the summary at the end
+    delaySetClock(&clockVirtual);
+    readySince = delayNowNs();
+}
+
+// -L: append every game played to a binary log (see mmLog.h, and mmlogsum); after -V,
+// so that a new log is stamped with the clock its games are played on
+if (opt_L != NULL && (gameLog = logOpen(opt_L)) == NULL) {
+    fprintf(stderr, "Cannot open the game log %s: %s\n", opt_L, strerror(errno));
+    exit(EXIT_FAILURE);
+}
+
+// -P: replay the button input of a recording (made with -R), with its seed and secret
+seed = (unsigned int)(delayWallNs() / 1000000000ULL);
+if (opt_P != NULL) {
+    if (!replayLoad(opt_P)) {
+        fprintf(stderr, "Cannot replay %s: %s\n", opt_P, strerror(errno));
+        exit(EXIT_FAILURE);
+    }
+    if (replaySecret(seqlen) == NULL) {
+        fprintf(stderr, "%s: not a recording of a game of length %d\n", opt_P, seqlen);
+        exit(EXIT_FAILURE);
+    }
+    seed = replaySeed();
+}
+
+if (daemonMode && (opt_R != NULL || opt_P != NULL)) {
+    fprintf(stderr, "Recording and replaying are for single games, not with -D\n");
+    exit(EXIT_FAILURE);
+}
+
+// -E: the host keeps all codes, so only for sizes with few enough of them
+if (evilMode && opt_s != NULL) {
+    fprintf(stderr, "With -E there is no secret to set with -s\n");
+    exit(EXIT_FAILURE);
+}
+if (evilMode && !evilInit(&host, seqlen, colors)) {
+    fprintf(stderr, "Too many codes for -E (at most %d), or out of memory\n", EVIL_CODES);
+    exit(EXIT_FAILURE);
+}
+
+// -S: serve games to many clients on a Unix socket, instead of playing on the Pi
+if (opt_S != NULL)
+    exit(serverRun(opt_S, gameLog, verbose) == 0 ? EXIT_SUCCESS : EXIT_FAILURE);
+
+if (verbose && unit_test) {
+    printf("1st argument = %s\n", argv[optind]);
+    printf("2nd argument = %s\n", argv[optind + 1]);
+}
+
+if (verbose) {
+    fprintf(stdout, "Settings for running the program\n");
+    fprintf(stdout, "Verbose is %s\n", (verbose ? "ON" : "OFF"));
+    fprintf(stdout, "Debug is %s\n", (debug ? "ON" : "OFF"));
+    fprintf(stdout, "Unittest is %s\n", (unit_test ? "ON" : "OFF"));
+    if (opt_s)  fprintf(stdout, "Secret sequence set to %s\n", opt_s);
+    fprintf(stdout, "%d colours, length %d, matcher %s, scoring %s\n", colors, seqlen, matcherBest()->name, scoring->name);
+}
+
+// Set up the game, with all its sequences
+replayPhase("boot");
+newGame();
+
+  // check for -u option, and if so run a unit test on the matching function
+  if (unit_test && argc > optind+1) { // more arguments to process; only needed with -u 
+    // CALL a test-matches function; see testm.c for an example implementation
+    readSeq(seq1, argv[optind]); // turn the string of pegs into a sequence of numbers
+    readSeq(seq2, argv[optind+1]); // turn the string of pegs into a sequence of numbers
+    if (verbose)
+      fprintf(stdout, "Testing matches function with sequences %s and %s\n", argv[optind], argv[optind+1]);
+    res_matches = countMatches(seq1, seq2);
+    showMatches(res_matches, seq1, seq2, 1);
+    exit(EXIT_SUCCESS);
+  } 
+
+  if (opt_s) { // if -s option is given, use the sequence as secret sequence
+    readSeq(theSeq, opt_s);
+    if (verbose) {
+      fprintf(stderr, "Running program with secret sequence:\n");
+      showSeq(theSeq);
+    }
+  }
+  
+  // -------------------------------------------------------
+  // LCD constants: 16x2 display, using a 4-bit connection unless -8
+  bits = lcdBits; 
+  cols = 16; 
+  rows = 2; 
+  // -------------------------------------------------------
+
+  printf("Raspberry Pi LCD driver, for a %dx%d display (%d-bit wiring) \n", cols, rows, bits);
+    
+    if (geteuid() != 0 && !virtualHw)
+        fprintf(stderr, "setup: Must be root. (Did you forget sudo?)\n");
+
+  // -T: real-time mode, before the delays are calibrated; steps not allowed are skipped
+  if (opt_T != 0) {
+    char mode[64];
+
+    rtDescribe(rtEnter(opt_T, opt_A, stderr), opt_T, opt_A, mode, sizeof(mode));
+    if (verbose)
+      fprintf(stdout, "Real-time mode: %s\n", mode);
+  }
+    
+
+  // -----------------------------------------------------------------------------
+  // constants for RPi2
+  gpiobase = 0x3F200000 ;
+
+  // -----------------------------------------------------------------------------
+  // memory mapping 
+  // Open the master /dev/memory device
+
+  // -V: the emulator's registers, decoding the LCD pin writes (see lcdEmu.h)
+  if (virtualHw) {
+    fd = -1 ;
+    lcdEmuInit (&emu, bits, lcdPins [0], lcdPins [1], lcdPins + 2) ;
+    gpio = emu.regs ;
+    sysTimer = NULL ;
+  } else {
+    if ((fd = open ("/dev/mem", O_RDWR | O_SYNC | O_CLOEXEC) ) < 0)
+      return failure (FALSE, "setup: Unable to open /dev/mem: %s\n", strerror (errno)) ;
+
+    // GPIO:
+    gpio = (uint32_t *)mmap(0, BLOCK_SIZE, PROT_READ|PROT_WRITE, MAP_SHARED, fd, gpiobase) ;
+    if (gpio == MAP_FAILED)
+      return failure (FALSE, "setup: mmap (GPIO) failed: %s\n", strerror (errno)) ;
+
+    // System timer (optional): used as the spin clock for short delays
+    sysTimer = (uint32_t *)mmap(0, BLOCK_SIZE, PROT_READ, MAP_SHARED, fd, SYSTIMER_BASE) ;
+    if (sysTimer == MAP_FAILED)
+      sysTimer = NULL ;
+  }
+
+  // calibrate the sleep overshoot used by delay() and delayMicroseconds()
+  delayInit(sysTimer) ;
+  if (verbose)
+    fprintf(stdout, "Delay calibration: nanosleep overshoot %uus, spin clock %s\n",
+            delaySlack(), (virtualHw ? "virtual" : sysTimer != NULL ? "system timer" : "CLOCK_MONOTONIC_RAW"));
+
+  // -------------------------------------------------------
+  // Configuration of LED and BUTTON
+
+  /* ***  COMPLETE the code here  ***  */
+  pinMode(gpio, pinLED, OUTPUT);
+  pinMode(gpio, pin2LED2, OUTPUT);
+  pinMode(gpio, pinButton, INPUT);
+  for (c = 0; c < 2 + bits; c++)
+    pinMode(gpio, lcdPins[c], OUTPUT);
+  
+  // -------------------------------------------------------
+  // Create a new LCD, on the wired GPIO pins (see lcdInit in lcdDriver.c)
+  {
+    // -F: the datasheet's minimum waits, or no reset at all if a clean exit left the LCD ready
+    lcd = lcdInitMode (gpio, rows, cols, bits, lcdPins [0], lcdPins [1], lcdPins + 2,
+                       !fastBoot ? LCD_INIT_FULL : !virtualHw && lcdWasReady() ? LCD_INIT_KEEP : LCD_INIT_QUICK) ;
+    if (lcd == NULL)
+      return -1 ;
+    lcdReady = 1 ;
+  }
+
+  // timed LCD and LED output (scrolling, animations) is advanced while waiting for input
+  ledAnimInit(gpio) ;
+  setIdleHook(idleTick) ;
+
+  histInit(&histPress, "edge->press") ;
+  histInit(&histAck, "press->LED ack") ;
+  histInit(&histResult, "last peg->result") ;
+  histInit(&histNext, "game->ready") ;
+  histInit(&histEvil, "host partition") ;
+  buttonSetLatencyHist(&histPress) ;
+  if (daemonMode)
+    daemonSignals() ;
+  if (virtualHw) {
+    playerStart(&emu) ;
+    if (debug)
+      playerTrace(stdout) ;	// -d: every screen the player reads
+  }
+
+  // END lcdInit ------
+  // -----------------------------------------------------------------------------
+  // Start of game
+  fprintf(stderr,"Printing welcome message on the LCD display ...\n");
+  /* ***  COMPLETE the code here  ***  */
+  fprintf(stderr, "Printing welcome message on the LCD display ...\n");
+    
+  // Welcome message, and greeting; skipped with -F
+  replayPhase("welcome");
+  if (!fastBoot) {
+    lcdClear(lcd);
+    lcdPuts(lcd, "Welcome to");
+    lcdPosition(lcd, 1, 1);
+    lcdPuts(lcd, "MasterMind");
+    delay(2000);
+    lcdClear(lcd);
+    
+    displaySurnameGreeting(gpio, pin2LED2, pinLED, "Dsouza & Ahmed", lcd);
+  }
+
+  // Play a game; with -D, one after the other, keeping the GPIO mapping, the pin
+  // set-up and the LCD, until SIGTERM (SIGHUP starts a new game); with -V, the
+  // games of the script
+  for (;;) {
+    res = playGame(lcd);
+    if ((!daemonMode && !(virtualHw && games < playerGames())) || stopRequest)
+      break;
+    if (hupRequest && opt_L != NULL) {
+      logClose(gameLog);
+      if ((gameLog = logOpen(opt_L)) == NULL)
+        fprintf(stderr, "Cannot reopen the game log %s: %s\n", opt_L, strerror(errno));
+    }
+    hupRequest = abortInput = 0;
+    readySince = delayNowNs();
+    seed = (unsigned int)(delayWallNs() / 1000000000ULL) + games;
+    newGame();
+  }
+  if (daemonMode) {
+    lcdClear(lcd);
+    lcdPuts(lcd, "MasterMind");
+    lcdPosition(lcd, 0, 1);
+    lcdPuts(lcd, "closed");
+    writeLED(gpio, LED, LOW);
+    writeLED(gpio, LED2, LOW);
+  }
+
+    // -V: the screen left at the end, and the games played, in game (virtual)
+    // time and in real time
+    if (virtualHw) {
+        playerStop();
+        playerShow(stdout, "LCD");
+        fprintf(stderr, "Played %d games, %lu button presses: %.1f s of game time in %.1f ms\n",
+                games, playerPresses(), (delayNowNs() - VIRTUAL_START_NS) / 1e9, (clockReal.now() - realStart) / 1e6);
+    }
+
+    // Check a replay against its recording, and compare the phases across builds
+    res = (replayFinish(stdout) ? EXIT_SUCCESS : EXIT_FAILURE);
+    if (opt_P != NULL || verbose)
+        replayPhasePrint(stdout);
+    
+    if (verbose) {
+        unsigned int uploads, bytes;
+        unsigned long frames, commands;
+        lcdGlyphStats(&uploads, &bytes);
+        fprintf(stdout, "CGRAM: %u glyph uploads, %u bytes written in the last game", lastUploads, lastBytes);
+        if (games > 1)
+            fprintf(stdout, "; %u, %u bytes in all %d games", uploads, bytes, games);
+        fprintf(stdout, "\n");
+        lcdScrollStats(&frames, &commands);
+        if (frames > 0)
+            fprintf(stdout, "Scrolling: %lu frames, %.1f commands per frame (rewriting a line: %d)\n",
+                    frames, (double)commands / frames, 1 + cols);
+        poolPrint(&gamePool, stdout);
+        arenaPrint(scratch, "scratch", stdout);
+        fprintf(stdout, "Input latencies:\n");
+        histPrint(&histPress, stdout);
+        histPrint(&histAck, stdout);
+        histPrint(&histResult, stdout);
+        if (daemonMode)
+            histPrint(&histNext, stdout);
+        if (evilMode)
+            histPrint(&histEvil, stdout);
+    }
     
     // Clean up and exit
     free(lcd);
-    close(fd);
+    if (fd >= 0)
+        close(fd);
     
-    return 0;
+    return res;
 }
\ No newline at end of file
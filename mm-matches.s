@@ -18,7 +18,7 @@
 @ -----------------------------------------------------------------------------
 @ matches function - compares two sequences and returns exact and approximate matches
 @ Input:  R0 = pointer to secret sequence, R1 = pointer to guess sequence
-@ Output: R0 = result encoded as (exact*10 + approximate)
+@ Output: R0 = result encoded as (exact << 8 | approximate), see MATCH_CODE in mmMatch.h
 matches:
     PUSH {R4-R11, LR}   @ Save registers we'll use
     
@@ -120,11 +120,10 @@ next_outer:
     B    approx_outer_loop @ Continue outer loop
     
 approx_done:
-    @ Calculate final result: exact*10 + approximate
+    @ Calculate final result: exact << 8 | approximate
     MOV  R0, R4         @ R0 = exact matches
-    MOV  R3, #10        @ R3 = 10 (use R3 instead of R1 to avoid register conflict)
-    MUL  R0, R0, R3     @ R0 = exact * 10
-    ADD  R0, R0, R5     @ R0 = (exact * 10) + approximate
+    LSL  R0, R0, #8     @ R0 = exact << 8
+    ORR  R0, R0, R5     @ R0 = (exact << 8) | approximate
     
     @ Clean up and return
     ADD  SP, SP, #24    @ Deallocate stack space
@@ -0,0 +1,140 @@
+/* ***************************************************************************** */
+/* Slab pool and bump arena                                                      */
+/* Memory is only requested from malloc when a pool needs another slab, or a     */
+/* thread uses its arena for the first time; after the first game, allocating    */
+/* and freeing is a few pointer updates                                          */
+/* ***************************************************************************** */
+
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+
+#include "mmArena.h"
+
+#define ROUND_UP(n) (((n) + ARENA_ALIGN - 1) & ~(size_t)(ARENA_ALIGN - 1))
+
+// -----------------------------------------------------------------------------
+// Scratch arena
+
+void arenaInit(struct mmArena *a, void *mem, size_t size)
+{
+    memset(a, 0, sizeof(*a));
+    a->base = (char *)mem;
+    a->size = size;
+}
+
+void *arenaAlloc(struct mmArena *a, size_t n)
+{
+    size_t start = ROUND_UP(a->used);
+
+    if (start + n > a->size || start + n < start) {
+        a->failed++;
+        return NULL;
+    }
+    a->used = start + n;
+    if (a->used > a->peak)
+        a->peak = a->used;
+    return a->base + start;
+}
+
+void arenaReset(struct mmArena *a)
+{
+    a->used = 0;
+    a->resets++;
+}
+
+struct mmArena *arenaLocal(void)
+{
+    static __thread struct mmArena local;
+    void *mem;
+
+    if (local.base == NULL) {
+        if ((mem = malloc(ARENA_SIZE)) == NULL)
+            return NULL;
+        arenaInit(&local, mem, ARENA_SIZE);
+    }
+    return &local;
+}
+
+void arenaPrint(const struct mmArena *a, const char *name, FILE *out)
+{
+    fprintf(out, "%-10s arena: peak %zu of %zu bytes, %lu resets, %lu failed allocations\n",
+            name, a->peak, a->size, a->resets, a->failed);
+}
+
+// -----------------------------------------------------------------------------
+// Slab pool; a free object holds the pointer to the next free one, and each
+// slab starts with a pointer to the previous slab
+
+static int poolGrow(struct mmPool *p)
+{
+    char *slab, *obj;
+    unsigned int i;
+
+    if (p->slabs >= p->maxSlabs)
+        return 0;
+    slab = (char *)malloc(ARENA_ALIGN + (size_t)p->perSlab * p->objSize);
+    if (slab == NULL)
+        return 0;
+    *(void **)slab = p->slabList;
+    p->slabList = slab;
+    p->slabs++;
+
+    for (i = p->perSlab; i-- > 0; ) {
+        obj = slab + ARENA_ALIGN + (size_t)i * p->objSize;
+        *(void **)obj = p->freeList;
+        p->freeList = obj;
+    }
+    return 1;
+}
+
+int poolInit(struct mmPool *p, const char *name, size_t objSize, unsigned int perSlab, unsigned int maxSlabs)
+{
+    memset(p, 0, sizeof(*p));
+    p->name = name;
+    p->objSize = ROUND_UP(objSize < sizeof(void *) ? sizeof(void *) : objSize);
+    p->perSlab = (perSlab > 0 ? perSlab : 1);
+    p->maxSlabs = (maxSlabs > 0 ? maxSlabs : 1);
+    return poolGrow(p);
+}
+
+void *poolAlloc(struct mmPool *p)
+{
+    void *obj;
+
+    if (p->freeList == NULL && !poolGrow(p))
+        return NULL;
+    obj = p->freeList;
+    p->freeList = *(void **)obj;
+    memset(obj, 0, p->objSize);
+    if (++p->live > p->peak)
+        p->peak = p->live;
+    return obj;
+}
+
+void poolFree(struct mmPool *p, void *obj)
+{
+    if (obj == NULL)
+        return;
+    *(void **)obj = p->freeList;
+    p->freeList = obj;
+    p->live--;
+}
+
+void poolDestroy(struct mmPool *p)
+{
+    void *slab, *prev;
+
+    for (slab = p->slabList; slab != NULL; slab = prev) {
+        prev = *(void **)slab;
+        free(slab);
+    }
+    p->slabList = p->freeList = NULL;
+    p->slabs = p->live = 0;
+}
+
+void poolPrint(const struct mmPool *p, FILE *out)
+{
+    fprintf(out, "%-10s pool: %u in use, peak %u, %u slab(s) of %u x %zu bytes\n",
+            p->name, p->live, p->peak, p->slabs, p->perSlab, p->objSize);
+}
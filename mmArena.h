@@ -0,0 +1,52 @@
+/**
+ * mmArena.h - Memory for games and sessions, without malloc during play
+ * A slab pool hands out fixed-size objects (e.g. a game with all its
+ * sequences inline); a bump arena per thread holds scratch data, and is
+ * reset at the start of each game
+ */
+
+#ifndef MM_ARENA_H
+#define MM_ARENA_H
+
+#include <stdio.h>    /* FILE */
+#include <stddef.h>   /* size_t */
+
+/* Alignment of all objects, and size of the per-thread scratch arena */
+#define ARENA_ALIGN 16
+#define ARENA_SIZE  (64 * 1024)
+
+/* bump allocator over one block of memory; freed all at once by arenaReset */
+struct mmArena
+{
+    char *base;
+    size_t size, used;
+    size_t peak;                /* highest use since arenaInit */
+    unsigned long resets, failed;
+};
+
+/* pool of equal-sized objects, allocated @perSlab@ at a time, up to @maxSlabs@ slabs */
+struct mmPool
+{
+    const char *name;
+    size_t objSize;
+    unsigned int perSlab, maxSlabs;
+    unsigned int slabs, live, peak;     /* slabs allocated, objects in use, most in use */
+    void *freeList;
+    void *slabList;
+};
+
+/* Scratch arena */
+void arenaInit(struct mmArena *a, void *mem, size_t size);  /* Use @mem@ for the arena */
+void *arenaAlloc(struct mmArena *a, size_t n);  /* Aligned, not zeroed; NULL when full */
+void arenaReset(struct mmArena *a);  /* Free everything, e.g. at the start of a game */
+struct mmArena *arenaLocal(void);  /* This thread's ARENA_SIZE arena; NULL if out of memory */
+void arenaPrint(const struct mmArena *a, const char *name, FILE *out);  /* Usage statistics */
+
+/* Slab pool */
+int poolInit(struct mmPool *p, const char *name, size_t objSize, unsigned int perSlab, unsigned int maxSlabs);  /* Allocates the first slab; 0 on error */
+void *poolAlloc(struct mmPool *p);  /* Zeroed object; NULL when all slabs are in use */
+void poolFree(struct mmPool *p, void *obj);  /* Return an object to the pool */
+void poolDestroy(struct mmPool *p);  /* Free all slabs */
+void poolPrint(const struct mmPool *p, FILE *out);  /* Usage statistics */
+
+#endif /* MM_ARENA_H */
@@ -0,0 +1,92 @@
+/* ***************************************************************************** */
+/* Adversarial host (see mmEvil.h): the batch scorer (mmScore.h) gives the       */
+/* feedback to the guess of every secret alive, which are counted per class;    */
+/* a second pass moves the largest class to the front. Ties go to the class     */
+/* with fewer exact, then fewer approximate matches, which tells the player the  */
+/* least. Nothing is allocated per guess or per game                             */
+/* ***************************************************************************** */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "mmEvil.h"
+#include "mmScore.h"
+#include "mmTime.h"
+
+/* a feedback class: exact and approximate matches, each 0..SEQL_MAX */
+#define CLASS(exact, approx) ((exact) * (SEQL_MAX + 1) + (approx))
+#define CLASSES              ((SEQL_MAX + 1) * (SEQL_MAX + 1))
+
+int evilInit(struct mmEvil *e, int seql, int cols)
+{
+    int i, q, size, v;
+
+    for (size = 1, q = 0; q < seql; q++)
+        if ((size *= cols) > EVIL_CODES)
+            return 0;
+    if (e->pegs == NULL || e->seql != seql || e->cols != cols) {
+        evilFree(e);
+        e->pegs = (uint8_t *)malloc((size_t)size * seql);
+        e->fb = (uint16_t *)malloc((size_t)size * sizeof(uint16_t));
+        if (e->pegs == NULL || e->fb == NULL) {
+            evilFree(e);
+            return 0;
+        }
+        e->seql = seql;
+        e->cols = cols;
+        e->size = size;
+    }
+
+    /* all codes in order: 11..1, 11..2, ...; code i is the digits of i in base cols, plus 1 */
+    for (i = 0; i < size; i++)
+        for (v = i, q = seql - 1; q >= 0; q--, v /= cols)
+            e->pegs[q * size + i] = (uint8_t)(v % cols + 1);
+    e->n = size;
+    e->ns = 0;
+    return 1;
+}
+
+void evilSecret(const struct mmEvil *e, int *secret)
+{
+    int q;
+
+    for (q = 0; q < e->seql; q++)
+        secret[q] = e->pegs[q * e->size];
+}
+
+int evilAnswer(struct mmEvil *e, int *guess, int *secret)
+{
+    int count[CLASSES] = { 0 };
+    int i, k, q, c, best;
+    uint64_t t0 = clockReal.now();	// real time: the cost of the partition, which virtual time does not see
+
+    scoreBatch(e->pegs, e->size, e->n, guess, e->fb);
+    for (i = 0; i < e->n; i++) {
+        c = CLASS(MATCH_EXACT(e->fb[i]), MATCH_APPROX(e->fb[i]));
+        e->fb[i] = (uint16_t)c;
+        count[c]++;
+    }
+    for (best = 0, c = 1; c < CLASSES; c++)	// in order of exact, then approximate matches
+        if (count[c] > count[best])
+            best = c;
+
+    for (q = 0; q < e->seql; q++) {
+        uint8_t *pegs = e->pegs + q * e->size;
+
+        for (i = k = 0; i < e->n; i++)
+            if (e->fb[i] == best)
+                pegs[k++] = pegs[i];
+    }
+    e->n = count[best];
+    evilSecret(e, secret);
+    e->ns = clockReal.now() - t0;
+    return MATCH_CODE(best / (SEQL_MAX + 1), best % (SEQL_MAX + 1));
+}
+
+void evilFree(struct mmEvil *e)
+{
+    free(e->pegs);
+    free(e->fb);
+    e->pegs = NULL;
+    e->fb = NULL;
+}
@@ -0,0 +1,36 @@
+/**
+ * mmEvil.h - An adversarial host ("evil host") for the MasterMind game
+ * The host does not commit to a secret: it keeps every secret consistent
+ * with the feedback given so far, and answers each guess with the feedback
+ * that keeps the most of them alive, so a secret is only fixed when there is
+ * no choice left. All codes are kept, by peg for the batch scorer in
+ * mmScore.h, in one block that is allocated when the size of the game
+ * changes; a guess partitions them by feedback and keeps the largest class
+ * in place.
+ */
+
+#ifndef MM_EVIL_H
+#define MM_EVIL_H
+
+#include <stdint.h>   /* Integer types */
+
+#include "mmMatch.h"  /* SEQL_MAX, MATCH_CODE */
+
+/* most codes (colours^length) the host keeps, e.g. 6 pegs of 8 colours */
+#define EVIL_CODES (1 << 18)
+
+struct mmEvil
+{
+    int seql, cols;
+    int n, size;                /* secrets alive, and all codes */
+    uint8_t *pegs;              /* peg q of code i at pegs[q * size + i]; the n alive first */
+    uint16_t *fb;               /* feedback of each secret alive to the last guess */
+    uint64_t ns;                /* time taken by the last partition */
+};
+
+int evilInit(struct mmEvil *e, int seql, int cols);  /* Every code a secret; 0 if more than EVIL_CODES, or out of memory */
+int evilAnswer(struct mmEvil *e, int *guess, int *secret);  /* Feedback keeping the most secrets alive; one of them into @secret@ */
+void evilSecret(const struct mmEvil *e, int *secret);  /* A secret alive */
+void evilFree(struct mmEvil *e);  /* Release the codes */
+
+#endif /* MM_EVIL_H */
@@ -0,0 +1,315 @@
+/* ***************************************************************************** */
+/* Next consistent guess by backtracking with propagation (see mmGuess.h)        */
+/* The common colours of a guess only depend on how many pegs of each colour the */
+/* code has: sum over colours of min(pegs in the code, pegs in the guess). So   */
+/* the search first picks these counts, colour by colour, cutting as soon as a  */
+/* guess has too many common colours or cannot reach its number any more; then  */
+/* it places the pegs, most constrained position first, narrowing the colours  */
+/* of the free positions before each peg: a colour used up is gone everywhere, */
+/* a colour with as many pegs left as positions that can take it goes on all of */
+/* them; a guess at its exact matches rules out its pegs where they are, and a  */
+/* guess needing all its remaining candidates gets them. An empty position cuts */
+/* the branch, so the search never visits a code that is not consistent        */
+/* The counts also bound the exact matches: a colour can match no more often   */
+/* than the guess has it where it may go, and must match when it has more pegs */
+/* than the other positions that can take it                                   */
+/* ***************************************************************************** */
+
+#include <string.h>
+
+#include "mmGuess.h"
+
+struct search
+{
+    struct mmGuesser *g;
+    int *seq;
+    int colour[COLS_MAX];               /* order in which the counts are picked */
+    int want[COLS_MAX + 1];             /* pegs of each colour in the code */
+    int common[GUESS_MAX];              /* of the counts picked so far */
+    /* per guess and colour: positions where a peg matches exactly, and where it can go without */
+    unsigned char hit[GUESS_MAX][COLS_MAX + 1], miss[GUESS_MAX][COLS_MAX + 1];
+    int most[GUESS_MAX], least[GUESS_MAX];  /* exact matches the counts picked so far allow */
+    int exact[GUESS_MAX];               /* of the pegs placed so far */
+    int n[COLS_MAX + 1];                /* pegs of each colour placed so far */
+    unsigned long nodes, limit;
+};
+
+static uint64_t nextRandom(uint64_t *rng)
+{
+    *rng ^= *rng << 13;
+    *rng ^= *rng >> 7;
+    *rng ^= *rng << 17;
+    return *rng;
+}
+
+static int popcount(uint64_t x)
+{
+    return __builtin_popcountll(x);
+}
+
+void guessInit(struct mmGuesser *g, int seql, int cols, uint64_t seed)
+{
+    int q;
+
+    memset(g, 0, sizeof(*g));
+    g->seql = seql;
+    g->cols = cols;
+    g->rng = seed | 1;
+    for (q = 0; q < seql; q++)
+        g->domain[q] = ((2ULL << cols) - 1) & ~1ULL;    /* colours 1..cols */
+}
+
+int guessAdd(struct mmGuesser *g, const int *guess, int code)
+{
+    int i = g->n, p, q;
+
+    if (i == GUESS_MAX)
+        return 0;
+    memcpy(g->guess[i], guess, g->seql * sizeof(int));
+    g->exact[i] = MATCH_EXACT(code);
+    g->common[i] = MATCH_EXACT(code) + MATCH_APPROX(code);
+    memset(g->count[i], 0, sizeof(g->count[i]));
+    for (q = 0; q < g->seql; q++)
+        g->count[i][guess[q]]++;
+    g->n++;
+
+    /* no exact matches: no peg of the guess where it is; no common colours: none of them anywhere */
+    for (q = 0; q < g->seql; q++) {
+        if (g->exact[i] == 0)
+            g->domain[q] &= ~(1ULL << guess[q]);
+        if (g->common[i] == 0)
+            for (p = 0; p < g->seql; p++)
+                g->domain[p] &= ~(1ULL << guess[q]);
+    }
+    return 1;
+}
+
+// -----------------------------------------------------------------------------
+// Second step: the pegs, with the count of each colour fixed
+
+/* narrow the colours @d@ of the free positions (not in @done@); 0 if one is left empty */
+static int propagate(struct search *s, uint64_t *d, unsigned done)
+{
+    struct mmGuesser *g = s->g;
+    uint64_t was, bits;
+    int room[COLS_MAX + 1], hit[COLS_MAX + 1];
+    int i, q, c, left, need, most, least, changed;
+
+    do {
+        changed = 0;
+        /* colours: each exactly as many more pegs as it has left */
+        memset(room, 0, sizeof(room));
+        for (q = 0; q < g->seql; q++)
+            if (!(done >> q & 1))
+                for (bits = d[q]; bits != 0; bits &= bits - 1)
+                    room[__builtin_ctzll(bits)]++;
+        for (c = 1; c <= g->cols; c++) {
+            need = s->want[c] - s->n[c];
+            left = room[c];
+            if (left < need)
+                return 0;
+            if (left > 0 && (need == 0 || need == left))
+                for (q = 0; q < g->seql; q++) {
+                    if (done >> q & 1)
+                        continue;
+                    was = d[q];
+                    if (need == 0)
+                        d[q] &= ~(1ULL << c);
+                    else if (d[q] >> c & 1)
+                        d[q] = 1ULL << c;
+                    changed |= (d[q] != was);
+                }
+        }
+        /* guesses: exact matches; positions narrowed above only make room[] an overestimate */
+        for (i = 0; i < g->n; i++) {
+            for (bits = 0, left = 0, q = 0; q < g->seql; q++) {
+                c = g->guess[i][q];
+                if (!(done >> q & 1) && (d[q] >> c & 1)) {
+                    hit[c] = (bits >> c & 1 ? hit[c] + 1 : 1);
+                    bits |= 1ULL << c;
+                    left++;
+                }
+            }
+            need = g->exact[i] - s->exact[i];
+            if (left < need)
+                return 0;
+            /* a colour matches no more often than it has pegs left, and at least as often as */
+            /* it has more pegs left than other positions that can take it */
+            for (most = least = 0; bits != 0; bits &= bits - 1) {
+                c = __builtin_ctzll(bits);
+                most += (s->want[c] - s->n[c] < hit[c] ? s->want[c] - s->n[c] : hit[c]);
+                if (s->want[c] - s->n[c] > room[c] - hit[c])
+                    least += s->want[c] - s->n[c] - (room[c] - hit[c]);
+            }
+            if (most < need || least > need)
+                return 0;
+            if (left > 0 && (need == 0 || need == left))
+                for (q = 0; q < g->seql; q++) {
+                    if (done >> q & 1)
+                        continue;
+                    was = d[q];
+                    if (need == 0)
+                        d[q] &= ~(1ULL << g->guess[i][q]);
+                    else if (d[q] >> g->guess[i][q] & 1)
+                        d[q] = 1ULL << g->guess[i][q];
+                    changed |= (d[q] != was);
+                }
+        }
+        for (q = 0; q < g->seql; q++)
+            if (!(done >> q & 1) && d[q] == 0)
+                return 0;
+    } while (changed);
+    return 1;
+}
+
+/* place a peg, with @k@ placed so far at @done@: 1 found, 0 none, -1 out of nodes */
+static int placePeg(struct search *s, const uint64_t *dom, unsigned done, int k)
+{
+    struct mmGuesser *g = s->g;
+    uint64_t d[SEQL_MAX];
+    int cs[COLS_MAX], q, best, c, i, j, n, start, res;
+
+    memcpy(d, dom, g->seql * sizeof(uint64_t));
+    if (!propagate(s, d, done))
+        return 0;
+    if (k == g->seql)
+        return 1;
+
+    /* the free position with the fewest colours left */
+    for (best = -1, q = 0; q < g->seql; q++)
+        if (!(done >> q & 1) && (best < 0 || popcount(d[q]) < popcount(d[best])))
+            best = q;
+    q = best;
+    for (n = 0, c = 1; c <= g->cols; c++)
+        if (d[q] >> c & 1)
+            cs[n++] = c;
+
+    start = (int)(nextRandom(&g->rng) % (uint64_t)n);
+    for (j = 0; j < n; j++) {
+        c = cs[(start + j) % n];
+        if (++s->nodes > s->limit)
+            return -1;
+        for (i = 0; i < g->n; i++)
+            s->exact[i] += (g->guess[i][q] == c);
+        s->n[c]++;
+        s->seq[q] = c;
+        d[q] = 1ULL << c;
+        if ((res = placePeg(s, d, done | 1u << q, k + 1)) != 0)
+            return res;
+        s->n[c]--;
+        for (i = 0; i < g->n; i++)
+            s->exact[i] -= (g->guess[i][q] == c);
+    }
+    return 0;
+}
+
+// -----------------------------------------------------------------------------
+// First step: how many pegs of each colour
+
+/* can every guess still get its common colours, with @k@ colours counted and @rest@ pegs to go? */
+static int countsPossible(struct search *s, int k, int rest)
+{
+    struct mmGuesser *g = s->g;
+    int i, j, c, more, hits;
+
+    for (i = 0; i < g->n; i++) {
+        if (s->common[i] > g->common[i] || s->least[i] > g->exact[i])
+            return 0;
+        for (more = hits = 0, j = k; j < g->cols; j++) {
+            c = s->colour[j];
+            more += g->count[i][c];
+            hits += s->hit[i][c];
+        }
+        if (s->common[i] + (more < rest ? more : rest) < g->common[i] ||
+            s->most[i] + (hits < rest ? hits : rest) < g->exact[i])
+            return 0;
+    }
+    return 1;
+}
+
+/* pick the count of the colour at step @k@, with @rest@ pegs to go: 1 found, 0 none, -1 out of nodes */
+static int pickCount(struct search *s, int k, int rest)
+{
+    struct mmGuesser *g = s->g;
+    int c, i, j, q, v, most, start, res;
+
+    if (k == g->cols) {
+        memset(s->exact, 0, g->n * sizeof(int));
+        memset(s->n, 0, sizeof(s->n));
+        return placePeg(s, g->domain, 0, 0);
+    }
+    c = s->colour[k];
+    for (most = 0, q = 0; q < g->seql; q++)
+        most += (g->domain[q] >> c) & 1;
+    if (most > rest)
+        most = rest;
+    if (k == g->cols - 1 && most < rest)
+        return 0;
+
+    start = (int)(nextRandom(&g->rng) % (uint64_t)(most + 1));
+    for (j = 0; j <= most; j++) {
+        v = (k == g->cols - 1 ? rest : (start + j) % (most + 1));
+        if (++s->nodes > s->limit)
+            return -1;
+        s->want[c] = v;
+        for (i = 0; i < g->n; i++) {
+            s->common[i] += (v < g->count[i][c] ? v : g->count[i][c]);
+            s->most[i] += (v < s->hit[i][c] ? v : s->hit[i][c]);
+            s->least[i] += (v > s->miss[i][c] ? v - s->miss[i][c] : 0);
+        }
+        res = countsPossible(s, k + 1, rest - v) ? pickCount(s, k + 1, rest - v) : 0;
+        for (i = 0; i < g->n; i++) {
+            s->common[i] -= (v < g->count[i][c] ? v : g->count[i][c]);
+            s->most[i] -= (v < s->hit[i][c] ? v : s->hit[i][c]);
+            s->least[i] -= (v > s->miss[i][c] ? v - s->miss[i][c] : 0);
+        }
+        if (res != 0)
+            return res;
+        if (k == g->cols - 1)
+            break;
+    }
+    return 0;
+}
+
+int guessNext(struct mmGuesser *g, int *seq, unsigned long maxNodes)
+{
+    struct search s;
+    int c, i, j, q, t, res;
+
+    memset(s.hit, 0, g->n * sizeof(s.hit[0]));
+    memset(s.miss, 0, g->n * sizeof(s.miss[0]));
+    for (i = 0; i < g->n; i++)
+        for (q = 0; q < g->seql; q++)
+            for (c = 1; c <= g->cols; c++)
+                if (g->domain[q] >> c & 1) {
+                    if (g->guess[i][q] == c)
+                        s.hit[i][c]++;
+                    else
+                        s.miss[i][c]++;
+                }
+    s.g = g;
+    s.seq = seq;
+    g->nodes = 0;
+    g->restarts = 0;
+    for (s.limit = GUESS_FIRST; ; s.limit *= 2, g->restarts++) {
+        if (s.limit > maxNodes - g->nodes)
+            s.limit = maxNodes - g->nodes;
+        /* colours in a random order, so a restart looks somewhere else */
+        for (c = 0; c < g->cols; c++)
+            s.colour[c] = c + 1;
+        for (c = g->cols - 1; c > 0; c--) {
+            j = (int)(nextRandom(&g->rng) % (uint64_t)(c + 1));
+            t = s.colour[c]; s.colour[c] = s.colour[j]; s.colour[j] = t;
+        }
+        s.nodes = 0;
+        memset(s.common, 0, g->n * sizeof(int));
+        memset(s.most, 0, g->n * sizeof(int));
+        memset(s.least, 0, g->n * sizeof(int));
+        res = countsPossible(&s, 0, g->seql) ? pickCount(&s, 0, g->seql) : 0;
+        g->nodes += s.nodes;
+        if (res >= 0)
+            return res;
+        if (g->nodes >= maxNodes)
+            return -1;
+    }
+}
@@ -0,0 +1,44 @@
+/**
+ * mmGuess.h - Next guess consistent with all results so far, for any size
+ * The code space (colours^length) is never enumerated: each guess in the
+ * history is a constraint on the number of exact matches, and on the number
+ * of common colours (exact + approximate). A backtracking search first picks
+ * how many pegs of each colour the code has, which fixes the common colours,
+ * then places one peg at a time, most constrained position first, and cuts a
+ * branch as soon as a constraint is exceeded or cannot be reached with the
+ * pegs left; the colours possible at each position are narrowed when a guess
+ * is added, and before each peg.
+ * Searches are restarted with a random order of colours and a growing node
+ * limit, so a hard corner of the space does not hold up the next move.
+ */
+
+#ifndef MM_GUESS_H
+#define MM_GUESS_H
+
+#include <stdint.h>   /* Integer types */
+
+#include "mmMatch.h"  /* SEQL_MAX, COLS_MAX, MATCH_CODE */
+
+/* most guesses in a history */
+#define GUESS_MAX   64
+/* search nodes of the first restart of guessNext(); doubled on each restart */
+#define GUESS_FIRST 256
+
+struct mmGuesser
+{
+    int seql, cols;
+    int n;                                  /* guesses in the history */
+    int guess[GUESS_MAX][SEQL_MAX];
+    int exact[GUESS_MAX], common[GUESS_MAX];    /* common: exact + approximate */
+    unsigned char count[GUESS_MAX][COLS_MAX + 1];   /* pegs of each colour in a guess */
+    uint64_t domain[SEQL_MAX];              /* colours possible at a position, bit c */
+    uint64_t rng;
+    unsigned long nodes;                    /* search nodes of the last guessNext() */
+    int restarts;                           /* restarts of the last guessNext() */
+};
+
+void guessInit(struct mmGuesser *g, int seql, int cols, uint64_t seed);  /* Empty history */
+int guessAdd(struct mmGuesser *g, const int *guess, int code);  /* Add a guess and its MATCH_CODE result; 0 if full */
+int guessNext(struct mmGuesser *g, int *seq, unsigned long maxNodes);  /* Consistent guess: 1, none exists: 0, not found in @maxNodes@: -1 */
+
+#endif /* MM_GUESS_H */
@@ -0,0 +1,99 @@
+/* ***************************************************************************** */
+/* Latency histograms                                                            */
+/* Values below HIST_SUB get a bucket each; above that, every power of two is    */
+/* split into HIST_SUB equal buckets, so the memory needed is fixed and small    */
+/* while the relative precision is the same from microseconds to minutes         */
+/* ***************************************************************************** */
+
+#include <string.h>
+
+#include "mmHist.h"
+#include "mmTime.h"
+
+uint64_t histNowNs(void)
+{
+    return delayNowNs();
+}
+
+// -----------------------------------------------------------------------------
+// Bucket arithmetic
+
+static int bucketOf(uint64_t v)
+{
+    int e;
+
+    if (v < HIST_SUB)
+        return (int)v;
+    e = 63 - __builtin_clzll(v);	/* v is in [2^e, 2^(e+1)) */
+    return (e - HIST_SUB_BITS + 1) * HIST_SUB + (int)((v >> (e - HIST_SUB_BITS)) & (HIST_SUB - 1));
+}
+
+/* largest value falling into bucket @b@ */
+static uint64_t bucketTop(int b)
+{
+    int e = b / HIST_SUB + HIST_SUB_BITS - 1;
+    uint64_t sub = (uint64_t)(b % HIST_SUB);
+
+    if (b < HIST_SUB)
+        return (uint64_t)b;
+    return ((HIST_SUB + sub + 1) << (e - HIST_SUB_BITS)) - 1;
+}
+
+// -----------------------------------------------------------------------------
+// Recording
+
+void histInit(struct mmHist *h, const char *name)
+{
+    memset(h, 0, sizeof(*h));
+    h->name = name;
+}
+
+void histRecord(struct mmHist *h, uint64_t ns)
+{
+    if (h->count == 0 || ns < h->min)
+        h->min = ns;
+    if (ns > h->max)
+        h->max = ns;
+    h->count++;
+    h->buckets[bucketOf(ns)]++;
+}
+
+void histSince(struct mmHist *h, uint64_t start)
+{
+    if (start != 0)
+        histRecord(h, histNowNs() - start);
+}
+
+// -----------------------------------------------------------------------------
+// Reporting
+
+uint64_t histPercentile(const struct mmHist *h, double pct)
+{
+    uint64_t rank, seen = 0;
+    int b;
+
+    if (h->count == 0)
+        return 0;
+    rank = (uint64_t)(pct / 100.0 * (double)h->count + 0.5);
+    if (rank < 1)
+        rank = 1;
+
+    for (b = 0; b < HIST_BUCKETS; b++) {
+        seen += h->buckets[b];
+        if (seen >= rank)
+            return bucketTop(b) < h->max ? bucketTop(b) : h->max;
+    }
+    return h->max;
+}
+
+void histPrint(const struct mmHist *h, FILE *out)
+{
+    if (h->count == 0) {
+        fprintf(out, "%-16s no samples\n", h->name);
+        return;
+    }
+    fprintf(out, "%-16s n=%-4llu p50 %8.3f  p90 %8.3f  p99 %8.3f  max %8.3f ms\n", h->name,
+            (unsigned long long)h->count,
+            histPercentile(h, 50) / 1e6, histPercentile(h, 90) / 1e6,
+            histPercentile(h, 99) / 1e6, h->max / 1e6);
+}
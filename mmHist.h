@@ -0,0 +1,38 @@
+/**
+ * mmHist.h - Latency histograms for the MasterMind game
+ * Log-bucketed (HDR style): 16 linear sub-buckets per power of two, so any
+ * recorded value is reported within 1/16 (6.25%) of its true size
+ */
+
+#ifndef MM_HIST_H
+#define MM_HIST_H
+
+#include <stdio.h>    /* FILE */
+#include <stdint.h>   /* Integer types */
+
+/* log2 of the number of sub-buckets per power of two */
+#define HIST_SUB_BITS 4
+#define HIST_SUB      (1 << HIST_SUB_BITS)
+/* enough buckets for any 64-bit value */
+#define HIST_BUCKETS  ((64 - HIST_SUB_BITS + 1) * HIST_SUB)
+
+struct mmHist
+{
+    const char *name;
+    uint64_t count, min, max;
+    uint32_t buckets[HIST_BUCKETS];
+};
+
+/* Time source for latencies, in nanoseconds: delayNowNs(), the clock in use (see mmTime.h) */
+uint64_t histNowNs(void);
+
+/* Recording */
+void histInit(struct mmHist *h, const char *name);  /* Empty histogram */
+void histRecord(struct mmHist *h, uint64_t ns);  /* Add one latency */
+void histSince(struct mmHist *h, uint64_t start);  /* Add histNowNs() - start; ignored if start is 0 */
+
+/* Reporting */
+uint64_t histPercentile(const struct mmHist *h, double pct);  /* Upper bound of the pct-th percentile */
+void histPrint(const struct mmHist *h, FILE *out);  /* One line: count, p50/p90/p99/max in ms */
+
+#endif /* MM_HIST_H */
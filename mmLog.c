@@ -0,0 +1,264 @@
+/* ***************************************************************************** */
+/* Binary game log: buffered writer and mmap-based reader                        */
+/* Numbers are LEB128 varints (7 bits per byte, low bits first), so a typical    */
+/* 3x3 game takes about 15 bytes                                                 */
+/* ***************************************************************************** */
+
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "mmLog.h"
+#include "mmTime.h"
+
+/* longest record: length, flags, start, secret, count, and MAX_ATTEMPTS attempts */
+#define LOG_RECORD_MAX (4 * 10 + 1 + MAX_ATTEMPTS * (10 + 1 + 5))
+
+struct mmLog
+{
+    FILE *f;
+    uint64_t created;
+    int seql, cols;             /* size of the games, from the header */
+    char buf[LOG_BUFFER];
+};
+
+// -----------------------------------------------------------------------------
+// Encoding
+
+static unsigned char *putVarint(unsigned char *p, uint64_t v)
+{
+    while (v >= 0x80) {
+        *p++ = (unsigned char)(v | 0x80);
+        v >>= 7;
+    }
+    *p++ = (unsigned char)v;
+    return p;
+}
+
+/* 0 if the varint runs past @end@ or is too long */
+static int getVarint(const unsigned char **p, const unsigned char *end, uint64_t *v)
+{
+    int shift;
+
+    *v = 0;
+    for (shift = 0; *p < end && shift < 64; shift += 7) {
+        *v |= (uint64_t)(**p & 0x7F) << shift;
+        if (!(*(*p)++ & 0x80))
+            return 1;
+    }
+    return 0;
+}
+
+static uint64_t zigzag(int64_t v)
+{
+    return ((uint64_t)v << 1) ^ (uint64_t)(v >> 63);
+}
+
+static int64_t unzigzag(uint64_t v)
+{
+    return (int64_t)(v >> 1) ^ -(int64_t)(v & 1);
+}
+
+/* a sequence of @l@ pegs as a number in base @c@, and back; fits in 64 */
+/* bits up to SEQL_MAX pegs of COLS_MAX colours                         */
+static uint64_t seqIndex(const int *seq, int l, int c)
+{
+    uint64_t idx = 0;
+    int i;
+
+    for (i = 0; i < l; i++)
+        idx = idx * c + (uint64_t)(seq[i] - 1);
+    return idx;
+}
+
+static void seqFromIndex(uint64_t idx, int *seq, int l, int c)
+{
+    int i;
+
+    for (i = l - 1; i >= 0; i--, idx /= c)
+        seq[i] = (int)(idx % c) + 1;
+}
+
+static void putHeader(unsigned char *h, uint64_t created)
+{
+    int i;
+
+    memset(h, 0, LOG_HEADER);
+    memcpy(h, LOG_MAGIC, 4);
+    h[4] = LOG_VERSION;
+    h[5] = (unsigned char)seqlen;
+    h[6] = (unsigned char)colors;
+    h[7] = MAX_ATTEMPTS;
+    for (i = 0; i < 8; i++)
+        h[8 + i] = (unsigned char)(created >> (8 * i));
+}
+
+/* 0 unless @h@ is a header for games of a size up to SEQL_MAX and COLS_MAX */
+static int getHeader(const unsigned char *h, uint64_t *created)
+{
+    int i;
+
+    if (memcmp(h, LOG_MAGIC, 4) != 0 || h[4] != LOG_VERSION || h[5] < 1 || h[5] > SEQL_MAX ||
+        h[6] < 1 || h[6] > COLS_MAX || h[7] > MAX_ATTEMPTS)
+        return 0;
+    for (*created = 0, i = 0; i < 8; i++)
+        *created |= (uint64_t)h[8 + i] << (8 * i);
+    return 1;
+}
+
+// -----------------------------------------------------------------------------
+// Writing
+
+struct mmLog *logOpen(const char *path)
+{
+    struct mmLog *log = (struct mmLog *)malloc(sizeof(struct mmLog));
+    unsigned char h[LOG_HEADER];
+
+    if (log == NULL)
+        return NULL;
+    if ((log->f = fopen(path, "a+b")) == NULL) {
+        free(log);
+        return NULL;
+    }
+    setvbuf(log->f, log->buf, _IOFBF, sizeof(log->buf));
+
+    rewind(log->f);
+    if (fread(h, 1, LOG_HEADER, log->f) == LOG_HEADER) {
+        if (!getHeader(h, &log->created) || h[5] != seqlen || h[6] != colors) {
+            fprintf(stderr, "%s: not a log for %d colours, length %d\n", path, colors, seqlen);
+            fclose(log->f);
+            free(log);
+            return NULL;
+        }
+    } else {                    /* new (or empty) file */
+        log->created = delayWallNs() / 1000000000ULL;
+        putHeader(h, log->created);
+        if (fwrite(h, 1, LOG_HEADER, log->f) != LOG_HEADER) {
+            fclose(log->f);
+            free(log);
+            return NULL;
+        }
+    }
+    log->seql = seqlen;
+    log->cols = colors;
+    fseek(log->f, 0, SEEK_END);    /* needed between reading and writing */
+    return log;
+}
+
+int logGame(struct mmLog *log, const struct mmLogGame *g)
+{
+    unsigned char rec[LOG_RECORD_MAX], *p = rec + 10;     /* room for the length in front */
+    unsigned char len[10], *q;
+    uint64_t prev = 0, idx;
+    int i;
+
+    *p++ = (unsigned char)g->flags;
+    p = putVarint(p, g->start > log->created ? g->start - log->created : 0);
+    p = putVarint(p, seqIndex(g->secret, log->seql, log->cols));
+    *p++ = (unsigned char)g->attempts;
+    for (i = 0; i < g->attempts && i < MAX_ATTEMPTS; i++) {
+        idx = seqIndex(g->guess[i], log->seql, log->cols);
+        p = putVarint(p, zigzag((int64_t)idx - (int64_t)prev));
+        prev = idx;
+        *p++ = (unsigned char)(MATCH_EXACT(g->result[i]) << 4 | MATCH_APPROX(g->result[i]));
+        p = putVarint(p, g->inputMs[i]);
+    }
+
+    q = putVarint(len, (uint64_t)(p - (rec + 10)));
+    return fwrite(len, 1, (size_t)(q - len), log->f) == (size_t)(q - len) &&
+           fwrite(rec + 10, 1, (size_t)(p - (rec + 10)), log->f) == (size_t)(p - (rec + 10));
+}
+
+void logClose(struct mmLog *log)
+{
+    if (log == NULL)
+        return;
+    fclose(log->f);
+    free(log);
+}
+
+// -----------------------------------------------------------------------------
+// Reading
+
+int logMap(struct mmLogReader *r, const char *path)
+{
+    struct stat st;
+    void *m;
+    int fd = open(path, O_RDONLY);
+
+    memset(r, 0, sizeof(*r));
+    if (fd < 0)
+        return 0;
+    if (fstat(fd, &st) < 0 || st.st_size < LOG_HEADER) {
+        close(fd);
+        return 0;
+    }
+    m = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (m == MAP_FAILED)
+        return 0;
+    madvise(m, (size_t)st.st_size, MADV_SEQUENTIAL);
+
+    r->base = (const unsigned char *)m;
+    r->size = (size_t)st.st_size;
+    r->end = r->base + r->size;
+    r->p = r->base + LOG_HEADER;
+    r->seql = r->base[5];
+    r->cols = r->base[6];
+    if (!getHeader(r->base, &r->created)) {
+        logUnmap(r);
+        return 0;
+    }
+    return 1;
+}
+
+int logNext(struct mmLogReader *r, struct mmLogGame *g)
+{
+    const unsigned char *p = r->p, *end;
+    uint64_t len, v, prev = 0;
+    int i;
+
+    if (p == r->end)
+        return 0;
+    if (!getVarint(&p, r->end, &len) || len > (uint64_t)(r->end - p))
+        return -1;              /* e.g. a record cut short by a crash */
+    end = p + len;
+
+    if (p == end)
+        return -1;
+    g->flags = *p++;
+    if (!getVarint(&p, end, &v))
+        return -1;
+    g->start = r->created + v;
+    if (!getVarint(&p, end, &v))
+        return -1;
+    seqFromIndex(v, g->secret, r->seql, r->cols);
+    if (p == end || (g->attempts = *p++) > MAX_ATTEMPTS)
+        return -1;
+    for (i = 0; i < g->attempts; i++) {
+        if (!getVarint(&p, end, &v))
+            return -1;
+        prev = (uint64_t)((int64_t)prev + unzigzag(v));
+        seqFromIndex(prev, g->guess[i], r->seql, r->cols);
+        if (p == end)
+            return -1;
+        g->result[i] = MATCH_CODE(*p >> 4, *p & 0x0F);
+        p++;
+        if (!getVarint(&p, end, &v))
+            return -1;
+        g->inputMs[i] = (unsigned int)v;
+    }
+
+    r->p = end;
+    return 1;
+}
+
+void logUnmap(struct mmLogReader *r)
+{
+    if (r->base != NULL)
+        munmap((void *)r->base, r->size);
+    r->base = r->p = r->end = NULL;
+}
@@ -0,0 +1,67 @@
+/**
+ * mmLog.h - Append-only binary log of MasterMind games
+ * File: a fixed 16-byte header, with the length and colours of the games,
+ * then one record per game:
+ *   varint  length of the rest of the record
+ *   byte    flags (LOG_WON, LOG_OVER)
+ *   varint  start of the game, in seconds after the creation of the log
+ *   varint  secret, as a number in base colours
+ *   byte    number of attempts, then per attempt:
+ *     varint  guess, zigzag-encoded difference to the previous guess (or 0)
+ *     byte    exact << 4 | approx
+ *     varint  time taken to enter the guess, in ms
+ * Records are written with buffered I/O at the end of a game; the reader
+ * maps the file and decodes records in place.
+ */
+
+#ifndef MM_LOG_H
+#define MM_LOG_H
+
+#include <stdio.h>    /* FILE */
+#include <stdint.h>   /* Integer types */
+
+#include "mmMatch.h"  /* SEQL_MAX, MAX_ATTEMPTS, seqlen, colors */
+
+#define LOG_MAGIC   "MMLG"
+#define LOG_VERSION 1
+#define LOG_HEADER  16
+/* size of the write buffer */
+#define LOG_BUFFER  (64 * 1024)
+
+/* flags of a game */
+#define LOG_WON  0x01   /* secret found */
+#define LOG_OVER 0x02   /* finished (won or out of attempts); otherwise abandoned */
+
+/* one game, as written and as read back */
+struct mmLogGame
+{
+    uint64_t start;             /* Unix time */
+    int flags;
+    int secret[SEQL_MAX];
+    int attempts;
+    int guess[MAX_ATTEMPTS][SEQL_MAX];
+    int result[MAX_ATTEMPTS];   /* MATCH_CODE(exact, approx) */
+    unsigned int inputMs[MAX_ATTEMPTS];  /* time waiting for the pegs of the guess to be entered */
+};
+
+struct mmLog;   /* a log opened for writing */
+
+struct mmLogReader
+{
+    const unsigned char *base, *p, *end;
+    size_t size;
+    uint64_t created;           /* from the header */
+    int seql, cols;
+};
+
+/* Writing */
+struct mmLog *logOpen(const char *path);  /* Open for appending games of the current size, creating it if needed; NULL on error */
+int logGame(struct mmLog *log, const struct mmLogGame *g);  /* Append one game; 0 on error */
+void logClose(struct mmLog *log);  /* Flush and close */
+
+/* Reading */
+int logMap(struct mmLogReader *r, const char *path);  /* Map a log file, of games of any size; 0 on error */
+int logNext(struct mmLogReader *r, struct mmLogGame *g);  /* Next game: 1, end of log: 0, damaged: -1 */
+void logUnmap(struct mmLogReader *r);
+
+#endif /* MM_LOG_H */
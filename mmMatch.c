@@ -0,0 +1,336 @@
+/* ***************************************************************************** */
+/* Matching functions and sequence helpers, moved here from master-mind.c so    */
+/* that the game, testm and the benchmark all use the same code                  */
+/* ***************************************************************************** */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+
+#include "mmMatch.h"
+
+int seqlen = SEQL, colors = COLS;
+
+// -----------------------------------------------------------------------------
+// Matchers counting colours: exact matches, plus the sum over all colours of
+// the smaller count in either sequence, which is exact + approximate matches.
+// matchCounts() is inlined into a specialisation per size; with constant
+// length and colours, all loops are unrolled and the counts live in registers
+// or a few bytes of stack. Values must be in 1..colours; others give wrong
+// results, but stay inside the counts.
+
+#define COUNTS 64
+
+static inline __attribute__((always_inline)) int matchCounts(const int *seq1, const int *seq2, int l, int c)
+{
+    unsigned char n1[COUNTS], n2[COUNTS];
+    int i, exact = 0, common = 0;
+
+#pragma GCC unroll 36
+    for (i = 0; i <= c; i++)
+        n1[i] = n2[i] = 0;
+#pragma GCC unroll 12
+    for (i = 0; i < l; i++) {
+        exact += (seq1[i] == seq2[i]);
+        n1[seq1[i] & (COUNTS - 1)]++;
+        n2[seq2[i] & (COUNTS - 1)]++;
+    }
+#pragma GCC unroll 36
+    for (i = 1; i <= c; i++)
+        common += (n1[i] < n2[i] ? n1[i] : n2[i]);
+    return MATCH_CODE(exact, common - exact);
+}
+
+/* any size, at the current one */
+static int matchGeneric(int *seq1, int *seq2)
+{
+    return matchCounts(seq1, seq2, seqlen, colors);
+}
+
+/* a matcher for exactly @l@ pegs of @c@ colours */
+#define MATCH_SPECIAL(l, c) \
+static int match##l##x##c(int *seq1, int *seq2) \
+{ \
+    return matchCounts(seq1, seq2, l, c); \
+}
+
+MATCH_SPECIAL(3, 3)
+MATCH_SPECIAL(4, 6)
+MATCH_SPECIAL(5, 8)
+MATCH_SPECIAL(6, 9)
+
+/* the ARM Assembler version can only be linked on the Raspberry Pi, and */
+/* only handles sequences of length 3                                    */
+const struct matcher matchers[] = {
+  { "c", countMatches, 0, 0 },
+  { "generic", matchGeneric, 0, 0 },
+  { "3x3", match3x3, 3, 3 },
+  { "4x6", match4x6, 4, 6 },
+  { "5x8", match5x8, 5, 8 },
+  { "6x9", match6x9, 6, 9 },
+#if defined(__arm__)
+  { "asm", matches, 3, 0 },
+#endif
+  { NULL, NULL, 0, 0 }
+};
+
+const struct matcher *matcherFind(const char *name)
+{
+    const struct matcher *m;
+
+    for (m = matchers; m->name != NULL; m++)
+        if (strcmp(m->name, name) == 0)
+            return m;
+    return NULL;
+}
+
+int matcherFits(const struct matcher *m)
+{
+    return (m->seql == 0 || m->seql == seqlen) && (m->cols == 0 || m->cols == colors);
+}
+
+const struct matcher *matcherBest(void)
+{
+    const struct matcher *m;
+
+    for (m = matchers; m->name != NULL; m++)
+        if (m->seql == seqlen && m->cols == colors)
+            return m;
+    return matcherFind("generic");
+}
+
+int matchSetSize(int seql, int cols)
+{
+    if (seql < 1 || seql > SEQL_MAX || cols < 1 || cols > COLS_MAX)
+        return 0;
+    seqlen = seql;
+    colors = cols;
+    return 1;
+}
+
+// -----------------------------------------------------------------------------
+// Sequences
+
+int pegValue(int ch)
+{
+    if (ch >= '1' && ch <= '9')
+        return ch - '0';
+    if (ch >= 'a' && ch <= 'z')
+        return ch - 'a' + 10;
+    if (ch >= 'A' && ch <= 'Z')
+        return ch - 'A' + 10;
+    return 0;
+}
+
+int pegChar(int colour)
+{
+    return colour < 10 ? '0' + colour : 'a' + colour - 10;
+}
+
+/* display the sequence on the terminal window, using the format from the sample run in the spec */
+void showSeq(int *seq)
+{
+    int i;
+    
+    printf("Secret: ");
+    for (i = 0; i < seqlen; i++) {
+        printf("%c ", pegChar(seq[i]));
+    }
+    printf("\n");
+}
+
+#define NAN1 8
+#define NAN2 9
+
+/* counts how many entries in seq2 match entries in seq1 */
+/* returns exact and approximate matches, either both encoded in one value, */
+/* or as a pointer to a pair of values */
+int countMatches(int *seq1, int *seq2)
+{
+    int i, j;
+    int exact = 0;
+    int approx = 0;
+    /* Track which elements have been matched; on the stack, up to the longest length */
+    int used1[SEQL_MAX], used2[SEQL_MAX];
+    
+    /* Initialize arrays */
+    for (i = 0; i < seqlen; i++) {
+        used1[i] = 0;
+        used2[i] = 0;
+    }
+    
+    /* First pass: Count exact matches */
+    for (i = 0; i < seqlen; i++) {
+        if (seq1[i] == seq2[i]) {
+            exact++;
+            used1[i] = 1;
+            used2[i] = 1;
+        }
+    }
+    
+    /* Second pass: Count approximate matches */
+    for (i = 0; i < seqlen; i++) {
+        if (!used1[i]) {
+            for (j = 0; j < seqlen; j++) {
+                if (!used2[j] && seq1[i] == seq2[j]) {
+                    approx++;
+                    used1[i] = 1;
+                    used2[j] = 1;
+                    break;
+                }
+            }
+        }
+    }
+    
+    /* Return result encoded: see MATCH_CODE */
+    return MATCH_CODE(exact, approx);
+}
+
+/* show the results from calling countMatches on seq1 and seq1 */
+void showMatches(int code, int *seq1, int *seq2, int lcd_format)
+{
+    int exact = MATCH_EXACT(code);
+    int approx = MATCH_APPROX(code);
+    
+    if (lcd_format) {
+        /* Format for LCD display */
+        printf("%d exact\n%d approximate\n", exact, approx);
+    } else {
+        /* Format for terminal */
+        printf("Exact matches: %d\n", exact);
+        printf("Approximate matches: %d\n", approx);
+    }
+}
+
+/* parse a string of pegs (1-9, then a-z for 10 or more colours), and put */
+/* them into @seq@; needed for processing command-line with options -s or -u */
+void readSeq(int *seq, const char *str)
+{
+    int i;
+    
+    for (i = 0; i < seqlen; i++) {
+        seq[i] = (*str != '\0' ? pegValue(*str++) : 0);
+        
+        /* Ensure values are in range 1-colors */
+        if (seq[i] < 1 || seq[i] > colors) {
+            seq[i] = 1;
+        }
+    }
+}
+
+// -----------------------------------------------------------------------------
+// Batch unit tests: one case per line, "secret guess exact approx", e.g.
+//   123 321 1 2
+// Blank lines and lines starting with # are skipped. Input is read in large
+// blocks and parsed in place, so millions of cases take about a second.
+
+#define BATCH_BUF (1 << 16)
+
+static void skipBlanks(const char **p, const char *end)
+{
+    while (*p < end && (**p == ' ' || **p == '\t' || **p == '\r'))
+        (*p)++;
+}
+
+/* a sequence is exactly seqlen pegs; out-of-range pegs become 1, as in readSeq */
+static int parseSeq(const char **p, const char *end, int *seq)
+{
+    int i;
+
+    skipBlanks(p, end);
+    for (i = 0; i < seqlen; i++, (*p)++) {
+        if (*p == end || (**p != '0' && pegValue(**p) == 0))
+            return 0;
+        seq[i] = pegValue(**p);
+        if (seq[i] < 1 || seq[i] > colors)
+            seq[i] = 1;
+    }
+    return *p == end || **p == ' ' || **p == '\t' || **p == '\r';
+}
+
+static int parseNum(const char **p, const char *end, int *val)
+{
+    const char *start;
+
+    skipBlanks(p, end);
+    start = *p;
+    for (*val = 0; *p < end && **p >= '0' && **p <= '9'; (*p)++)
+        *val = *val * 10 + (**p - '0');
+    return *p > start;
+}
+
+/* check one line; returns 1 if it is a case that failed */
+static int batchLine(const char *p, const char *end, unsigned long lineNo, matchFn fn, unsigned long *cases)
+{
+    int secret[SEQL_MAX], guess[SEQL_MAX], exact, approx, code, i;
+
+    skipBlanks(&p, end);
+    if (p == end || *p == '#')
+        return 0;
+
+    (*cases)++;
+    if (!parseSeq(&p, end, secret) || !parseSeq(&p, end, guess) ||
+        !parseNum(&p, end, &exact) || !parseNum(&p, end, &approx) ||
+        (skipBlanks(&p, end), p != end)) {
+        fprintf(stdout, "line %lu: malformed\n", lineNo);
+        return 1;
+    }
+
+    code = fn(secret, guess);
+    if (code == MATCH_CODE(exact, approx))
+        return 0;
+
+    fprintf(stdout, "line %lu: ", lineNo);
+    for (i = 0; i < seqlen; i++)
+        fputc(pegChar(secret[i]), stdout);
+    fputc(' ', stdout);
+    for (i = 0; i < seqlen; i++)
+        fputc(pegChar(guess[i]), stdout);
+    fprintf(stdout, ": expected %d exact %d approximate, got %d exact %d approximate\n",
+            exact, approx, MATCH_EXACT(code), MATCH_APPROX(code));
+    return 1;
+}
+
+int matchBatch(int fd, matchFn fn, unsigned long *cases)
+{
+    static char buf[BATCH_BUF];
+    size_t have = 0;
+    ssize_t n;
+    const char *start, *end, *nl;
+    unsigned long lineNo = 0;
+    int failures = 0;
+
+    *cases = 0;
+    for (;;) {
+        n = read(fd, buf + have, sizeof(buf) - have);
+        if (n < 0) {
+            if (errno == EINTR)
+                continue;
+            perror("matchBatch: read");
+            return -1;
+        }
+        have += (size_t)n;
+        start = buf;
+        end = buf + have;
+        while ((nl = (const char *)memchr(start, '\n', (size_t)(end - start))) != NULL) {
+            failures += batchLine(start, nl, ++lineNo, fn, cases);
+            start = nl + 1;
+        }
+        if (n == 0) {	// last line without a newline
+            if (start < end)
+                failures += batchLine(start, end, ++lineNo, fn, cases);
+            break;
+        }
+        have = (size_t)(end - start);
+        if (have == sizeof(buf)) {	// no newline in a whole buffer
+            fprintf(stdout, "line %lu: too long\n", ++lineNo);
+            (*cases)++;
+            failures++;
+            have = 0;
+        }
+        memmove(buf, start, have);
+    }
+    return failures;
+}
@@ -0,0 +1,72 @@
+/**
+ * mmMatch.h - Matching functions for the MasterMind game
+ * The C reference version, the ARM Assembler version (mm-matches.s), matchers
+ * specialised for common sizes, and a table of all implementations, e.g. for
+ * testing and benchmarking (testm.c)
+ */
+
+#ifndef MM_MATCH_H
+#define MM_MATCH_H
+
+/* default number of colours and length of the sequence; both can be set at */
+/* run time with matchSetSize() (options -c and -l of the game)              */
+#ifndef COLS
+#define COLS 3
+#endif
+#ifndef SEQL
+#define SEQL 3
+#endif
+
+/* largest sizes; sequences are stored in arrays of SEQL_MAX. A sequence is */
+/* written with one character per peg, 1-9 then a-z, and fits in 64 bits   */
+/* as a number in base colours (see mmLog.h)                                */
+#define SEQL_MAX 12
+#define COLS_MAX 35
+
+#if SEQL > SEQL_MAX || COLS > COLS_MAX
+#error "SEQL or COLS too large"
+#endif
+
+/* maximum number of attempts in a game */
+#define MAX_ATTEMPTS 5
+
+/* a match result: exact and approximate matches, 8 bits each */
+#define MATCH_CODE(exact, approx) ((exact) << 8 | (approx))
+#define MATCH_EXACT(code)         ((code) >> 8)
+#define MATCH_APPROX(code)        ((code) & 0xFF)
+
+/* the current size: SEQL and COLS, unless changed with matchSetSize() */
+extern int seqlen, colors;
+
+/* a matching function: returns MATCH_CODE(exact, approximate); no side effects */
+typedef int (*matchFn)(int *seq1, int *seq2);
+
+struct matcher
+{
+  const char *name;
+  matchFn fn;
+  int seql, cols;   /* the only length and colours it handles; 0 for any */
+};
+
+/* All matchers available on this machine, the C version first; ends with { NULL, NULL } */
+extern const struct matcher matchers[];
+
+/* Matchers */
+int countMatches(int *seq1, int *seq2);  /* C version */
+int matches(int *seq1, int *seq2);  /* ARM Assembler version, in mm-matches.s */
+const struct matcher *matcherFind(const char *name);  /* Look up by name; NULL if unknown */
+int matcherFits(const struct matcher *m);  /* Does @m@ handle the current size? */
+const struct matcher *matcherBest(void);  /* The specialisation for the current size, or the generic matcher */
+int matchSetSize(int seql, int cols);  /* Set length and colours; 0 if out of range */
+
+/* Sequences */
+int pegValue(int ch);  /* Colour of a peg character (1-9, a-z), 0 if none */
+int pegChar(int colour);  /* Character of a colour */
+void showSeq(int *seq);  /* Print a sequence */
+void readSeq(int *seq, const char *str);  /* Parse one peg per character into a sequence */
+void showMatches(int code, int *seq1, int *seq2, int lcd_format);  /* Print a match result */
+
+/* Batch unit tests, from lines "secret guess exact approx"; prints the failures */
+int matchBatch(int fd, matchFn fn, unsigned long *cases);  /* Number of failed cases, -1 on read error */
+
+#endif /* MM_MATCH_H */
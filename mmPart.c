@@ -0,0 +1,206 @@
+/* ***************************************************************************** */
+/* Partition scoring (see mmPart.h). Feedback is counted per class of exact and  */
+/* approximate matches; a guess scores the sum of squares of its class sizes.    */
+/* The sampled version keeps the class counts of each guess in the pool, so a    */
+/* doubled sample only scores the secrets that are new                           */
+/* ***************************************************************************** */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "mmPart.h"
+#include "mmScore.h"
+
+/* a feedback class: exact and approximate matches, each 0..SEQL_MAX */
+#define CLASS(fb)  (MATCH_EXACT(fb) * (SEQL_MAX + 1) + MATCH_APPROX(fb))
+#define CLASSES    ((SEQL_MAX + 1) * (SEQL_MAX + 1))
+
+int partInit(struct mmPart *p, int seql, int cols, int exact)
+{
+    int i, q, size, v;
+
+    if (exact) {
+        for (size = 1, q = 0; q < seql; q++)
+            if ((size *= cols) > PART_CODES)
+                return 0;
+    } else {
+        size = PART_SAMPLE_MAX;
+    }
+    if (p->pegs == NULL || p->seql != seql || p->cols != cols || p->exact != exact) {
+        partFree(p);
+        p->pegs = (uint8_t *)malloc((size_t)size * seql);
+        p->fb = (uint16_t *)malloc((size_t)size * sizeof(uint16_t));
+        if (p->pegs == NULL || p->fb == NULL) {
+            partFree(p);
+            return 0;
+        }
+        p->seql = seql;
+        p->cols = cols;
+        p->exact = exact;
+        p->size = size;
+        p->hasOpening = 0;
+    }
+
+    /* exact: all codes in order, as in mmEvil.c */
+    p->n = 0;
+    if (exact) {
+        for (i = 0; i < size; i++)
+            for (v = i, q = seql - 1; q >= 0; q--, v /= cols)
+                p->pegs[q * size + i] = (uint8_t)(v % cols + 1);
+        p->n = size;
+    }
+    p->pool = p->samples = 0;
+    return 1;
+}
+
+void partAdd(struct mmPart *p, const int *guess, int code)
+{
+    int i, k = 0, q;
+
+    if (!p->exact)
+        return;
+    scoreBatch(p->pegs, p->size, p->n, guess, p->fb);
+    for (q = 0; q < p->seql; q++) {
+        uint8_t *pegs = p->pegs + q * p->size;
+
+        for (i = k = 0; i < p->n; i++)
+            if (p->fb[i] == code)
+                pegs[k++] = pegs[i];
+    }
+    p->n = k;
+}
+
+void partFree(struct mmPart *p)
+{
+    free(p->pegs);
+    free(p->fb);
+    p->pegs = NULL;
+    p->fb = NULL;
+}
+
+// -----------------------------------------------------------------------------
+// Exact
+
+static void codeAt(const struct mmPart *p, int i, int *seq)
+{
+    int q;
+
+    for (q = 0; q < p->seql; q++)
+        seq[q] = p->pegs[q * p->size + i];
+}
+
+/* sum of squares of the class sizes of the @n@ codes from @from@, added to @count@ */
+static uint64_t addClasses(struct mmPart *p, int from, int n, const int *guess, uint32_t *count)
+{
+    uint64_t sum = 0;
+    int i, c;
+
+    scoreBatch(p->pegs + from, p->size, n, guess, p->fb);
+    for (i = 0; i < n; i++)
+        count[CLASS(p->fb[i])]++;
+    for (c = 0; c < CLASSES; c++)
+        sum += (uint64_t)count[c] * count[c];
+    return sum;
+}
+
+static int exactNext(struct mmPart *p, int *seq)
+{
+    uint32_t count[CLASSES];
+    uint64_t sum, best = UINT64_MAX;
+    int i, guess[SEQL_MAX], first = (p->n == p->size);
+
+    if (p->n == 0)
+        return 0;
+    if (first && p->hasOpening) {	// all secrets alive: same as last game
+        memcpy(seq, p->opening, sizeof(p->opening));
+        return 1;
+    }
+    for (i = 0; i < p->n; i++) {
+        codeAt(p, i, guess);
+        memset(count, 0, sizeof(count));
+        if ((sum = addClasses(p, 0, p->n, guess, count)) < best) {
+            best = sum;
+            memcpy(seq, guess, sizeof(guess));
+        }
+    }
+    p->pool = p->samples = p->n;
+    if (first) {
+        memcpy(p->opening, seq, sizeof(p->opening));
+        p->hasOpening = 1;
+    }
+    return 1;
+}
+
+// -----------------------------------------------------------------------------
+// Sampled
+
+/* the pool indices of the PART_TOPK least sums, best first */
+static int topK(const uint64_t *sum, int n, int *top)
+{
+    int i, j, k = 0;
+
+    for (i = 0; i < n; i++)
+        if (k < PART_TOPK || sum[i] < sum[top[k - 1]]) {
+            for (j = (k < PART_TOPK ? k++ : k - 1); j > 0 && sum[top[j - 1]] > sum[i]; j--)
+                top[j] = top[j - 1];
+            top[j] = i;
+        }
+    return k;
+}
+
+static int sampledNext(struct mmPart *p, struct mmGuesser *g, int *seq)
+{
+    uint32_t count[PART_POOL][CLASSES];
+    uint64_t sum[PART_POOL];
+    int pool[PART_POOL][SEQL_MAX], top[PART_TOPK] = { 0 }, last[PART_TOPK];
+    int i, j, q, res, tries, n = 0, k, target, stable = 0;
+
+    /* the pool: distinct consistent codes */
+    for (tries = 0; n < PART_POOL && tries < 4 * PART_POOL; tries++) {
+        if ((res = guessNext(g, pool[n], PART_NODES)) == 0)
+            return 0;
+        for (i = 0; res > 0 && i < n; i++)
+            if (memcmp(pool[i], pool[n], p->seql * sizeof(int)) == 0)
+                break;
+        if (res > 0 && i == n)
+            n++;
+    }
+    p->pool = n;
+    p->samples = 0;
+    if (n == 0)
+        return -1;
+    if (n == 1) {
+        memcpy(seq, pool[0], sizeof(pool[0]));
+        return 1;
+    }
+
+    /* double the sample of secrets until the best guesses rank the same twice */
+    memset(count, 0, sizeof(count[0]) * n);
+    for (p->n = 0, target = PART_SAMPLE_MIN, k = 0; ; target *= 2) {
+        int from = p->n;
+
+        for (tries = 0; p->n < target && tries < 2 * target; tries++)
+            if (guessNext(g, seq, PART_NODES) > 0) {
+                for (q = 0; q < p->seql; q++)
+                    p->pegs[q * p->size + p->n] = (uint8_t)seq[q];
+                p->n++;
+            }
+        for (i = 0; i < n; i++)
+            sum[i] = addClasses(p, from, p->n - from, pool[i], count[i]);
+
+        memcpy(last, top, sizeof(top));
+        j = k;
+        k = topK(sum, n, top);
+        stable = (j == k && memcmp(last, top, k * sizeof(int)) == 0);
+        if (stable || target >= PART_SAMPLE_MAX || p->n < target)
+            break;
+    }
+    p->samples = p->n;
+    memcpy(seq, pool[top[0]], sizeof(pool[0]));
+    return 1;
+}
+
+int partNext(struct mmPart *p, struct mmGuesser *g, int *seq)
+{
+    return p->exact ? exactNext(p, seq) : sampledNext(p, g, seq);
+}
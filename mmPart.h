@@ -0,0 +1,53 @@
+/**
+ * mmPart.h - Next guess by the partition it makes of the secrets left
+ * A guess splits the secrets consistent with all results so far by their
+ * feedback to it; the best guess leaves the fewest secrets expected, i.e.
+ * the least sum of squares of the class sizes. Guesses are taken from the
+ * secrets left, so each can still win.
+ * Exact scoring keeps every secret alive, by peg for the batch scorer in
+ * mmScore.h, and scores every one of them as a guess against all the others:
+ * quadratic in the secrets left, so for modest sizes only. Sampled scoring
+ * works on any size: the pool of guesses and the secrets they are scored
+ * against are both consistent codes drawn with the constraint solver of
+ * mmGuess.c, and the sample of secrets is doubled until the best few guesses
+ * rank the same twice in a row.
+ */
+
+#ifndef MM_PART_H
+#define MM_PART_H
+
+#include <stdint.h>   /* Integer types */
+
+#include "mmMatch.h"  /* SEQL_MAX, MATCH_CODE */
+#include "mmGuess.h"  /* struct mmGuesser */
+
+/* most codes (colours^length) for exact scoring, e.g. 6 pegs of 6 colours */
+#define PART_CODES       (1 << 16)
+
+/* sampled scoring: guesses compared per move, the first and the largest */
+/* sample of secrets, and how many of the best guesses must keep their rank */
+#define PART_POOL        32
+#define PART_SAMPLE_MIN  32
+#define PART_SAMPLE_MAX  2048
+#define PART_TOPK        3
+/* search nodes for one consistent code; codes not found in time are skipped */
+#define PART_NODES       100000
+
+struct mmPart
+{
+    int seql, cols;
+    int exact;                  /* all secrets alive are kept */
+    int n, size;                /* codes held (exact: secrets alive), and room for them */
+    uint8_t *pegs;              /* peg q of code i at pegs[q * size + i] */
+    uint16_t *fb;               /* feedback of each code held to a guess */
+    int opening[SEQL_MAX];      /* exact: best first guess, found once */
+    int hasOpening;
+    int pool, samples;          /* last move: guesses compared, and secrets each was scored against */
+};
+
+int partInit(struct mmPart *p, int seql, int cols, int exact);  /* New game; 0 if exact and more than PART_CODES, or out of memory */
+void partAdd(struct mmPart *p, const int *guess, int code);  /* A result: exact keeps the secrets consistent with it */
+int partNext(struct mmPart *p, struct mmGuesser *g, int *seq);  /* Best guess: 1; none consistent: 0; none found in time: -1 */
+void partFree(struct mmPart *p);  /* Release the codes */
+
+#endif /* MM_PART_H */
@@ -0,0 +1,189 @@
+/* ***************************************************************************** */
+/* Scripted player (see mmPlayer.h). The presses for one input are planned when  */
+/* the player first reads a new screen: level changes at input times, returned   */
+/* to the reads at or after them, as in a replay (mmReplay.c). A screen is new   */
+/* when the LCD was strobed since the player last looked at it                   */
+/* ***************************************************************************** */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "lcdBinary.h"
+#include "mmMatch.h"
+#include "mmPlayer.h"
+
+struct change
+{
+    uint64_t ms;                /* input time */
+    int level;
+};
+
+/* the script */
+static int guesses[PLAYER_GUESSES][SEQL_MAX], nGuesses = 0, nGames = 1;
+static int seqLen = 0, nCols = 0;
+
+/* the presses planned, and the screen they were planned for */
+static struct change plan[2 * (COLS_MAX + 2)];
+static int nPlan = 0, next = 0, level = LOW, current = 0;
+static const struct lcdEmu *screen = NULL;
+static unsigned long seen = 0, presses = 0;
+static uint64_t lastAct = 0;
+static FILE *trace = NULL;
+
+// -----------------------------------------------------------------------------
+// Presses
+
+/* plan @n@ presses from @now@: PLAYER_SLOW apart, and the last two PLAYER_FAST */
+static void press(uint64_t now, int n)
+{
+    uint64_t t = now + PLAYER_FAST;
+    int j;
+
+    nPlan = next = 0;
+    for (j = 0; j < n; j++) {
+        plan[nPlan].ms = t;
+        plan[nPlan++].level = HIGH;
+        plan[nPlan].ms = t + PLAYER_HOLD;
+        plan[nPlan++].level = LOW;
+        t += (j == n - 2 ? PLAYER_FAST : PLAYER_SLOW);
+    }
+    presses += n;
+    lastAct = now;
+}
+
+/* look at the screen: enter a peg of the current guess, or go on to the next attempt */
+static void act(uint64_t now)
+{
+    char row0[20], row1[20];
+    int k, p;
+
+    seen = screen->strobes;
+    lcdEmuLine(screen, 0, 16, row0);
+    lcdEmuLine(screen, 1, 16, row1);
+
+    if (strncmp(row1, "Press button", 12) == 0 && sscanf(row0, "Position %d", &k) == 1 &&
+        k >= 1 && k <= seqLen) {
+        if (trace != NULL)
+            playerShow(trace, "Screen");
+        /* from 1, each press adds one (round to 1 after nCols); the last two confirm */
+        for (p = guesses[current][k - 1] - 1; p < 2; p += nCols)
+            ;
+        press(now, p);
+        if (k == seqLen)
+            current = (current + 1) % nGuesses;
+    } else if (strstr(row1, "Next?") != NULL) {
+        if (trace != NULL)
+            playerShow(trace, "Screen");
+        press(now, 1);
+    }
+}
+
+static int playerRead(uint32_t *gpio, int button)
+{
+    uint64_t now = buttonInputMs();
+
+    (void)gpio;
+    (void)button;
+    while (next < nPlan && plan[next].ms <= now)
+        level = plan[next++].level;
+    if (next == nPlan && screen->strobes != seen)
+        act(now);
+
+    if (next == nPlan && now > lastAct + PLAYER_STALL) {
+        char row0[20], row1[20];
+
+        lcdEmuLine(screen, 0, 16, row0);
+        lcdEmuLine(screen, 1, 16, row1);
+        fprintf(stderr, "Player: nothing to do on the screen \"%s\" / \"%s\" (input time %llu ms)\n",
+                row0, row1, (unsigned long long)now);
+        exit(EXIT_FAILURE);
+    }
+    return level;
+}
+
+// -----------------------------------------------------------------------------
+// Script
+
+int playerLoad(const char *path, int seql, int cols)
+{
+    FILE *f = fopen(path, "r");
+    char line[256], pegs[256];
+    int i;
+
+    if (f == NULL)
+        return 0;
+    nGuesses = 0;
+    nGames = 1;
+    seqLen = seql;
+    nCols = cols;
+    while (fgets(line, sizeof(line), f) != NULL) {
+        if (line[0] == '#' || line[0] == '\n')
+            continue;
+        if (sscanf(line, "games %d", &nGames) == 1 && nGames > 0)
+            continue;
+        if (sscanf(line, "guess %255s", pegs) == 1 && (int)strlen(pegs) == seql &&
+            nGuesses < PLAYER_GUESSES) {
+            for (i = 0; i < seql; i++)
+                if ((guesses[nGuesses][i] = pegValue(pegs[i])) < 1 || guesses[nGuesses][i] > cols)
+                    break;
+            if (i == seql) {
+                nGuesses++;
+                continue;
+            }
+        }
+        fprintf(stderr, "%s: bad line (guesses are %d pegs of 1-%d, at most %d of them): %s",
+                path, seql, cols, PLAYER_GUESSES, line);
+        fclose(f);
+        return 0;
+    }
+    fclose(f);
+    if (nGuesses == 0) {
+        fprintf(stderr, "%s: no guesses\n", path);
+        return 0;
+    }
+    return 1;
+}
+
+int playerGames(void)
+{
+    return nGames;
+}
+
+void playerStart(const struct lcdEmu *emu)
+{
+    screen = emu;
+    seen = emu->strobes;
+    nPlan = next = current = 0;
+    level = LOW;
+    lastAct = buttonInputMs();
+    buttonSetReadHook(playerRead);
+}
+
+void playerStop(void)
+{
+    buttonSetReadHook(NULL);
+}
+
+unsigned long playerPresses(void)
+{
+    return presses;
+}
+
+void playerTrace(FILE *out)
+{
+    trace = out;
+}
+
+void playerShow(FILE *out, const char *label)
+{
+    char row[2][20];
+    int r, c;
+
+    for (r = 0; r < 2; r++) {
+        lcdEmuLine(screen, r, 16, row[r]);
+        for (c = 0; row[r][c] != '\0'; c++)
+            if ((unsigned char)row[r][c] < 8)	// a glyph (see lcdGlyph)
+                row[r][c] = '*';
+    }
+    fprintf(out, "%s: [%s] [%s]\n", label, row[0], row[1]);
+}
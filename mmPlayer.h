@@ -0,0 +1,39 @@
+/**
+ * mmPlayer.h - Scripted player for games on simulated hardware
+ * The player reads the LCD emulator's screen, as a person would read the
+ * display, and presses the button through the button read hook, in input
+ * time (see buttonInputMs()): on "Position <k>" / "Press button" it enters
+ * peg k of its current guess, pressing until the value is reached and
+ * confirming with a double press; on "Next?" it presses once. A script is:
+ *   games <n>             games to play (default 1)
+ *   guess <pegs>          guesses, in order, as for -s; used round and round
+ * Together with the virtual clock (mmTime.h) a game takes milliseconds, and
+ * is the same game as with a person pressing at those times.
+ */
+
+#ifndef MM_PLAYER_H
+#define MM_PLAYER_H
+
+#include <stdio.h>    /* FILE */
+
+#include "lcdEmu.h"   /* struct lcdEmu */
+
+/* timing of presses, in input ms: held for PLAYER_HOLD; PLAYER_SLOW apart */
+/* (over the 1 s of a double press), the confirming pair PLAYER_FAST apart */
+#define PLAYER_HOLD    100
+#define PLAYER_SLOW   1200
+#define PLAYER_FAST    300
+/* input time without a screen to act on before the player gives up */
+#define PLAYER_STALL 60000
+/* most guesses in a script */
+#define PLAYER_GUESSES  64
+
+int playerLoad(const char *path, int seql, int cols);  /* Read a script for games of this size; 0 on error */
+int playerGames(void);  /* Games to play */
+void playerStart(const struct lcdEmu *emu);  /* Play on the screen of @emu@, through the button read hook */
+void playerStop(void);  /* Remove the read hook */
+unsigned long playerPresses(void);  /* Button presses made */
+void playerTrace(FILE *out);  /* Print each screen acted on to @out@; NULL (default) for none */
+void playerShow(FILE *out, const char *label);  /* Print the screen as "label: [row 0] [row 1]", CGRAM characters as '*' */
+
+#endif /* MM_PLAYER_H */
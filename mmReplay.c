@@ -0,0 +1,262 @@
+/* ***************************************************************************** */
+/* Recording and replay of button input, and wall-clock time per game phase      */
+/* A level change is keyed by the input time of the read that saw it, and by the */
+/* number of reads before it at that input time, so a replay returns the same    */
+/* level to every read, even where one poll reads the button twice               */
+/* ***************************************************************************** */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "lcdBinary.h"
+#include "mmMatch.h"
+#include "mmReplay.h"
+
+struct change
+{
+    uint64_t ms;                /* input time of the read */
+    unsigned int k;             /* reads before it at the same input time */
+    int level;
+};
+
+static FILE *recFile = NULL;
+static struct change *changes = NULL;
+static size_t nChanges = 0, next = 0;
+static int replayOn = 0, level = LOW;
+static unsigned int seed = 0;
+static int secret[SEQL_MAX], secretLen = 0;
+
+/* position of the current read: input time since the start of the recording */
+/* (or replay), and reads before it at that time                              */
+static uint64_t baseMs = 0, readMs = 0;
+static unsigned int readsAt = 0;
+
+/* FNV-1a of the values noted */
+static uint64_t digest = 0xcbf29ce484222325ULL, recorded = 0;
+
+struct phase
+{
+    const char *name;
+    unsigned long count;
+    uint64_t ns;
+};
+
+static struct phase phases[REPLAY_PHASES];
+static int nPhases = 0, current = -1;
+static uint64_t phaseStart;
+
+// -----------------------------------------------------------------------------
+// Read hooks
+
+static unsigned int readIndex(void)
+{
+    uint64_t now = buttonInputMs() - baseMs;
+
+    if (now != readMs) {
+        readMs = now;
+        readsAt = 0;
+    }
+    return readsAt++;
+}
+
+static int recordRead(uint32_t *gpio, int button)
+{
+    unsigned int k = readIndex();
+    int l = readButtonLevel(gpio, button);
+
+    if (l != level) {
+        fprintf(recFile, "%llu %u %d\n", (unsigned long long)readMs, k, l);
+        level = l;
+    }
+    return l;
+}
+
+static void start(buttonReadHook hook)
+{
+    baseMs = buttonInputMs();
+    readMs = 0;
+    readsAt = 0;
+    level = LOW;
+    next = 0;
+    digest = 0xcbf29ce484222325ULL;
+    buttonSetReadHook(hook);
+}
+
+static int replayRead(uint32_t *gpio, int button)
+{
+    unsigned int k = readIndex();
+
+    (void)gpio;
+    (void)button;
+    while (next < nChanges &&
+           (changes[next].ms < readMs || (changes[next].ms == readMs && changes[next].k <= k)))
+        level = changes[next++].level;
+
+    if (next == nChanges && readMs > (nChanges > 0 ? changes[nChanges - 1].ms : 0) + REPLAY_TAIL) {
+        fprintf(stderr, "Replay: the recording ended before the game (input time %llu ms)\n",
+                (unsigned long long)readMs);
+        exit(EXIT_FAILURE);
+    }
+    return level;
+}
+
+// -----------------------------------------------------------------------------
+// Recording and replay
+
+int replayRecord(const char *path, unsigned int s, const int *sec, int seql)
+{
+    int i;
+
+    if ((recFile = fopen(path, "w")) == NULL)
+        return 0;
+    fprintf(recFile, "# MasterMind recording: input time (ms), reads before at that time, level\n");
+    fprintf(recFile, "seed %u\nsecret", s);
+    for (i = 0; i < seql; i++)
+        fprintf(recFile, " %d", sec[i]);
+    fprintf(recFile, "\n");
+    start(recordRead);
+    return 1;
+}
+
+int replayLoad(const char *path)
+{
+    FILE *f = fopen(path, "r");
+    char line[256], *p, *end;
+    unsigned long long ms;
+    size_t cap = 0;
+    struct change *c;
+    unsigned int k;
+    int l;
+
+    if (f == NULL)
+        return 0;
+    nChanges = 0;
+    recorded = 0;
+    secretLen = 0;
+    while (fgets(line, sizeof(line), f) != NULL) {
+        if (line[0] == '#' || line[0] == '\n')
+            continue;
+        if (sscanf(line, "seed %u", &seed) == 1)
+            continue;
+        if (sscanf(line, "digest %llx", &ms) == 1) {
+            recorded = (uint64_t)ms;
+            continue;
+        }
+        if (strncmp(line, "secret", 6) == 0) {
+            for (p = line + 6, secretLen = 0; secretLen < SEQL_MAX; secretLen++, p = end) {
+                secret[secretLen] = (int)strtol(p, &end, 10);
+                if (end == p)
+                    break;
+            }
+            continue;
+        }
+        if (sscanf(line, "%llu %u %d", &ms, &k, &l) != 3 ||
+            (nChanges > 0 && ms < changes[nChanges - 1].ms)) {
+            fprintf(stderr, "%s: bad line: %s", path, line);
+            fclose(f);
+            return 0;
+        }
+        if (nChanges == cap) {
+            cap = (cap == 0 ? 256 : 2 * cap);
+            if ((c = (struct change *)realloc(changes, cap * sizeof(struct change))) == NULL) {
+                fclose(f);
+                return 0;
+            }
+            changes = c;
+        }
+        changes[nChanges].ms = ms;
+        changes[nChanges].k = k;
+        changes[nChanges++].level = l;
+    }
+    fclose(f);
+    if (secretLen == 0) {
+        fprintf(stderr, "%s: no secret\n", path);
+        return 0;
+    }
+    replayOn = 1;
+    start(replayRead);
+    return 1;
+}
+
+int replayActive(void)
+{
+    return replayOn;
+}
+
+unsigned int replaySeed(void)
+{
+    return seed;
+}
+
+const int *replaySecret(int seql)
+{
+    return replayOn && seql == secretLen ? secret : NULL;
+}
+
+void replayNote(int value)
+{
+    int i;
+
+    for (i = 0; i < 4; i++) {
+        digest ^= (uint64_t)((value >> (8 * i)) & 0xFF);
+        digest *= 0x100000001b3ULL;
+    }
+}
+
+int replayFinish(FILE *out)
+{
+    buttonSetReadHook(NULL);
+    if (recFile != NULL) {
+        fprintf(recFile, "digest %016llx\n", (unsigned long long)digest);
+        fclose(recFile);
+        recFile = NULL;
+        return 1;
+    }
+    if (!replayOn)
+        return 1;
+    replayOn = 0;
+    if (recorded != 0 && digest != recorded) {
+        fprintf(out, "Replay: DIFFERENT game, digest %016llx, recorded %016llx\n",
+                (unsigned long long)digest, (unsigned long long)recorded);
+        return 0;
+    }
+    fprintf(out, "Replay: same game, digest %016llx, %lu level changes\n",
+            (unsigned long long)digest, (unsigned long)nChanges);
+    return 1;
+}
+
+// -----------------------------------------------------------------------------
+// Phases
+
+void replayPhase(const char *name)
+{
+    uint64_t now = delayNowNs();
+    int i;
+
+    if (current >= 0) {
+        phases[current].count++;
+        phases[current].ns += now - phaseStart;
+    }
+    current = -1;
+    if (name == NULL)
+        return;
+    for (i = 0; i < nPhases && strcmp(phases[i].name, name) != 0; i++)
+        ;
+    if (i == nPhases) {
+        if (nPhases == REPLAY_PHASES)
+            return;
+        phases[nPhases++].name = name;
+    }
+    current = i;
+    phaseStart = now;
+}
+
+void replayPhasePrint(FILE *out)
+{
+    int i;
+
+    fprintf(out, "%-16s %6s %12s %12s\n", "phase", "count", "total ms", "mean ms");
+    for (i = 0; i < nPhases; i++)
+        fprintf(out, "%-16s %6lu %12.3f %12.3f\n", phases[i].name, phases[i].count,
+                phases[i].ns / 1e6, phases[i].count ? phases[i].ns / 1e6 / phases[i].count : 0.0);
+}
@@ -0,0 +1,41 @@
+/**
+ * mmReplay.h - Recording and deterministic replay of button input
+ * A recording is a text file with the seed and secret of one game, and every
+ * change of the button level, timed in input time (see buttonInputMs()):
+ *   seed <seed>
+ *   secret <colour> ...
+ *   <input ms> <reads> <level>  one line per change, in order: the input time
+ *                               of the read that saw it, and the number of
+ *                               reads before that one at the same input time
+ *   digest <hex>                of the game (secret, values entered, results)
+ * In a replay the recorded levels are returned instead of reading GPLEV. The
+ * input functions only see levels and input time, so they recognise the same
+ * presses, the game gets the same values, and the digest must match.
+ * Wall-clock time per phase of the game can be compared across builds.
+ */
+
+#ifndef MM_REPLAY_H
+#define MM_REPLAY_H
+
+#include <stdio.h>    /* FILE */
+#include <stdint.h>   /* Integer types */
+
+/* input time past the last change in a recording before a replay gives up */
+#define REPLAY_TAIL   10000
+/* number of distinct phase names */
+#define REPLAY_PHASES 16
+
+/* Recording and replay; the game is added to the digest with replayNote() */
+int replayRecord(const char *path, unsigned int seed, const int *secret, int seql);  /* Record the button; 0 on error */
+int replayLoad(const char *path);  /* Replay the button from a recording; 0 on error */
+int replayActive(void);  /* Replaying? */
+unsigned int replaySeed(void);  /* Seed of the recording being replayed */
+const int *replaySecret(int seql);  /* Secret of the recording being replayed; NULL unless @seql@ long */
+void replayNote(int value);  /* Add a value to the digest of the game */
+int replayFinish(FILE *out);  /* Write (or check) the digest; 0 if a replay differed */
+
+/* Wall-clock time per phase of the game */
+void replayPhase(const char *name);  /* End the current phase and start @name@ (NULL: none) */
+void replayPhasePrint(FILE *out);  /* Count, total and mean per phase */
+
+#endif /* MM_REPLAY_H */
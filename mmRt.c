@@ -0,0 +1,79 @@
+/* ***************************************************************************** */
+/* Real-time execution mode (see mmRt.h). Memory is locked first, so that the    */
+/* prefaulted stack and the heap stay resident; malloc is told not to give       */
+/* memory back, or to use fresh mmaps, which would fault again. Only the calling */
+/* thread gets SCHED_FIFO and the CPU affinity                                   */
+/* ***************************************************************************** */
+
+#define _GNU_SOURCE
+#include <string.h>
+#include <errno.h>
+#include <malloc.h>
+#include <sched.h>
+#include <unistd.h>
+#include <sys/mman.h>
+
+#include "mmRt.h"
+
+/* touch @RT_STACK_PREFAULT@ bytes below the caller's frame; not inlined, so */
+/* that the array is really on the stack, and volatile, so that it is kept   */
+static __attribute__((noinline)) void prefaultStack(void)
+{
+    volatile unsigned char stack[RT_STACK_PREFAULT];
+    long page = sysconf(_SC_PAGESIZE), i;
+
+    for (i = 0; i < RT_STACK_PREFAULT; i += page)
+        stack[i] = 0;
+}
+
+int rtDefaultCpu(void)
+{
+    long n = sysconf(_SC_NPROCESSORS_ONLN);
+
+    return (n > 1 ? (int)n - 1 : 0);
+}
+
+int rtEnter(int priority, int cpu, FILE *log)
+{
+    struct sched_param param;
+    cpu_set_t set;
+    int mode = 0;
+
+    if (mlockall(MCL_CURRENT | MCL_FUTURE) == 0) {
+        mallopt(M_TRIM_THRESHOLD, -1);
+        mallopt(M_MMAP_MAX, 0);
+        prefaultStack();
+        mode |= RT_LOCKED;
+    } else if (log != NULL) {
+        fprintf(log, "rt: cannot lock memory: %s\n", strerror(errno));
+    }
+
+    CPU_ZERO(&set);
+    CPU_SET(cpu < 0 ? rtDefaultCpu() : cpu, &set);
+    if (sched_setaffinity(0, sizeof(set), &set) == 0)
+        mode |= RT_PINNED;
+    else if (log != NULL)
+        fprintf(log, "rt: cannot pin to CPU %d: %s\n", (cpu < 0 ? rtDefaultCpu() : cpu), strerror(errno));
+
+    memset(&param, 0, sizeof(param));
+    param.sched_priority = priority;
+    if (sched_setscheduler(0, SCHED_FIFO, &param) == 0)
+        mode |= RT_FIFO;
+    else if (log != NULL)
+        fprintf(log, "rt: cannot use SCHED_FIFO %d: %s\n", priority, strerror(errno));
+
+    return mode;
+}
+
+void rtDescribe(int mode, int priority, int cpu, char *buf, int len)
+{
+    int n = 0;
+
+    snprintf(buf, len, "off");
+    if (mode & RT_FIFO)
+        n += snprintf(buf + n, len - n, "SCHED_FIFO %d", priority);
+    if (mode & RT_PINNED && n < len)
+        n += snprintf(buf + n, len - n, "%sCPU %d", (n ? ", " : ""), (cpu < 0 ? rtDefaultCpu() : cpu));
+    if (mode & RT_LOCKED && n < len)
+        snprintf(buf + n, len - n, "%smemory locked", (n ? ", " : ""));
+}
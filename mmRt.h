@@ -0,0 +1,31 @@
+/**
+ * mmRt.h - Real-time execution mode for the MasterMind game
+ * Opt-in (-T): all memory is locked (mlockall) and the stack prefaulted, so
+ * there are no page faults while playing; the process is pinned to one CPU
+ * and runs under SCHED_FIFO, so button sampling and LCD strobes are not
+ * delayed by other processes or migrations. Each step needs privileges
+ * (root, or CAP_IPC_LOCK and CAP_SYS_NICE); a step that fails is reported
+ * and skipped, and the program runs on with what it got.
+ */
+
+#ifndef MM_RT_H
+#define MM_RT_H
+
+#include <stdio.h>    /* FILE */
+
+/* SCHED_FIFO priority if none is given: above interrupt threads' default of 50 */
+#define RT_PRIO_DEFAULT 60
+
+/* Bytes of stack touched on entry, so that its pages are mapped (and locked) */
+#define RT_STACK_PREFAULT (256 * 1024)
+
+/* Steps of the mode in effect (rtEnter's result) */
+#define RT_LOCKED   1   /* memory locked, stack prefaulted */
+#define RT_FIFO     2   /* SCHED_FIFO */
+#define RT_PINNED   4   /* on one CPU */
+
+int rtEnter(int priority, int cpu, FILE *log);  /* Enter the mode; cpu -1 for the last one; returns RT_ bits; failures to log (may be NULL) */
+int rtDefaultCpu(void);  /* The last online CPU, which takes fewest interrupts on the Pi */
+void rtDescribe(int mode, int priority, int cpu, char *buf, int len);  /* e.g. "SCHED_FIFO 60, CPU 3, memory locked" */
+
+#endif /* MM_RT_H */
@@ -0,0 +1,201 @@
+/* ***************************************************************************** */
+/* Batch scoring kernels (see mmScore.h). The vector versions are compiled with  */
+/* target attributes, so the rest of the program stays baseline x86-64, and are */
+/* only called when CPUID says the CPU has them. Each handles whole vectors of  */
+/* codes and leaves the rest to the scalar version                              */
+/* ***************************************************************************** */
+
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(__x86_64__)
+#include <immintrin.h>
+#endif
+
+#include "mmScore.h"
+
+/* the colours of @guess@, each once, and how many pegs of each it has */
+static int guessColours(const int *guess, int *cs, int *cn)
+{
+    int q, k, nc = 0;
+
+    for (q = 0; q < seqlen; q++) {
+        for (k = 0; k < nc && cs[k] != guess[q]; k++)
+            ;
+        if (k == nc)
+            cs[nc++] = guess[q], cn[k] = 0;
+        cn[k]++;
+    }
+    return nc;
+}
+
+static void scoreScalar(const uint8_t *pegs, int stride, int n, const int *guess, uint16_t *out)
+{
+    int cs[SEQL_MAX], cn[SEQL_MAX], nc = guessColours(guess, cs, cn);
+    int i, q, k, exact, common, cnt;
+
+    for (i = 0; i < n; i++) {
+        exact = common = 0;
+        for (q = 0; q < seqlen; q++)
+            exact += (pegs[q * stride + i] == guess[q]);
+        for (k = 0; k < nc; k++) {
+            for (cnt = 0, q = 0; q < seqlen; q++)
+                cnt += (pegs[q * stride + i] == cs[k]);
+            common += (cnt < cn[k] ? cnt : cn[k]);
+        }
+        out[i] = (uint16_t)MATCH_CODE(exact, common - exact);
+    }
+}
+
+#if defined(__x86_64__)
+
+/* SSE2 is all it needs (and part of baseline x86-64): byte compares, minimum, unpacking */
+__attribute__((target("sse2")))
+static void scoreSse2(const uint8_t *pegs, int stride, int n, const int *guess, uint16_t *out)
+{
+    int cs[SEQL_MAX], cn[SEQL_MAX], nc = guessColours(guess, cs, cn), i, q, k;
+    __m128i v[SEQL_MAX], exact, common, cnt, c, approx;
+
+    for (i = 0; i + 16 <= n; i += 16) {
+        exact = _mm_setzero_si128();
+        for (q = 0; q < seqlen; q++) {
+            v[q] = _mm_loadu_si128((const __m128i *)(pegs + q * stride + i));
+            exact = _mm_sub_epi8(exact, _mm_cmpeq_epi8(v[q], _mm_set1_epi8((char)guess[q])));
+        }
+        common = _mm_setzero_si128();
+        for (k = 0; k < nc; k++) {
+            c = _mm_set1_epi8((char)cs[k]);
+            for (cnt = _mm_setzero_si128(), q = 0; q < seqlen; q++)
+                cnt = _mm_sub_epi8(cnt, _mm_cmpeq_epi8(v[q], c));
+            common = _mm_add_epi8(common, _mm_min_epu8(cnt, _mm_set1_epi8((char)cn[k])));
+        }
+        approx = _mm_sub_epi8(common, exact);
+        /* 16-bit results: approximate in the low byte, exact in the high one */
+        _mm_storeu_si128((__m128i *)(out + i), _mm_unpacklo_epi8(approx, exact));
+        _mm_storeu_si128((__m128i *)(out + i + 8), _mm_unpackhi_epi8(approx, exact));
+    }
+    scoreScalar(pegs + i, stride, n - i, guess, out + i);
+}
+
+__attribute__((target("avx2")))
+static void scoreAvx2(const uint8_t *pegs, int stride, int n, const int *guess, uint16_t *out)
+{
+    int cs[SEQL_MAX], cn[SEQL_MAX], nc = guessColours(guess, cs, cn), i, q, k;
+    __m256i v[SEQL_MAX], exact, common, cnt, c, approx;
+
+    for (i = 0; i + 32 <= n; i += 32) {
+        exact = _mm256_setzero_si256();
+        for (q = 0; q < seqlen; q++) {
+            v[q] = _mm256_loadu_si256((const __m256i *)(pegs + q * stride + i));
+            exact = _mm256_sub_epi8(exact, _mm256_cmpeq_epi8(v[q], _mm256_set1_epi8((char)guess[q])));
+        }
+        common = _mm256_setzero_si256();
+        for (k = 0; k < nc; k++) {
+            c = _mm256_set1_epi8((char)cs[k]);
+            for (cnt = _mm256_setzero_si256(), q = 0; q < seqlen; q++)
+                cnt = _mm256_sub_epi8(cnt, _mm256_cmpeq_epi8(v[q], c));
+            common = _mm256_add_epi8(common, _mm256_min_epu8(cnt, _mm256_set1_epi8((char)cn[k])));
+        }
+        approx = _mm256_sub_epi8(common, exact);
+        /* unpacking works within 128-bit lanes: codes 0-7 and 16-23, then 8-15 and 24-31 */
+        c = _mm256_unpacklo_epi8(approx, exact);
+        cnt = _mm256_unpackhi_epi8(approx, exact);
+        _mm256_storeu_si256((__m256i *)(out + i), _mm256_permute2x128_si256(c, cnt, 0x20));
+        _mm256_storeu_si256((__m256i *)(out + i + 16), _mm256_permute2x128_si256(c, cnt, 0x31));
+    }
+    scoreScalar(pegs + i, stride, n - i, guess, out + i);
+}
+
+__attribute__((target("avx512f,avx512bw")))
+static void scoreAvx512(const uint8_t *pegs, int stride, int n, const int *guess, uint16_t *out)
+{
+    int cs[SEQL_MAX], cn[SEQL_MAX], nc = guessColours(guess, cs, cn), i, q, k;
+    __m512i v[SEQL_MAX], exact, common, cnt, c, approx, one = _mm512_set1_epi8(1);
+
+    for (i = 0; i + 64 <= n; i += 64) {
+        exact = _mm512_setzero_si512();
+        for (q = 0; q < seqlen; q++) {
+            v[q] = _mm512_loadu_si512((const void *)(pegs + q * stride + i));
+            exact = _mm512_mask_add_epi8(exact, _mm512_cmpeq_epi8_mask(v[q], _mm512_set1_epi8((char)guess[q])), exact, one);
+        }
+        common = _mm512_setzero_si512();
+        for (k = 0; k < nc; k++) {
+            c = _mm512_set1_epi8((char)cs[k]);
+            for (cnt = _mm512_setzero_si512(), q = 0; q < seqlen; q++)
+                cnt = _mm512_mask_add_epi8(cnt, _mm512_cmpeq_epi8_mask(v[q], c), cnt, one);
+            common = _mm512_add_epi8(common, _mm512_min_epu8(cnt, _mm512_set1_epi8((char)cn[k])));
+        }
+        approx = _mm512_sub_epi8(common, exact);
+        /* widen each half of the codes to 16 bits, exact in the high byte */
+        c = _mm512_or_si512(_mm512_cvtepu8_epi16(_mm512_castsi512_si256(approx)),
+                            _mm512_slli_epi16(_mm512_cvtepu8_epi16(_mm512_castsi512_si256(exact)), 8));
+        cnt = _mm512_or_si512(_mm512_cvtepu8_epi16(_mm512_extracti64x4_epi64(approx, 1)),
+                              _mm512_slli_epi16(_mm512_cvtepu8_epi16(_mm512_extracti64x4_epi64(exact, 1)), 8));
+        _mm512_storeu_si512((void *)(out + i), c);
+        _mm512_storeu_si512((void *)(out + i + 32), cnt);
+    }
+    scoreScalar(pegs + i, stride, n - i, guess, out + i);
+}
+
+static int hasSse2(void)
+{
+    return __builtin_cpu_supports("sse2");
+}
+
+static int hasAvx2(void)
+{
+    return __builtin_cpu_supports("avx2");
+}
+
+static int hasAvx512(void)
+{
+    return __builtin_cpu_supports("avx512f") && __builtin_cpu_supports("avx512bw");
+}
+
+#endif /* __x86_64__ */
+
+/* in order of preference, the best last */
+const struct scorer scorers[] = {
+  { "scalar", scoreScalar, NULL },
+#if defined(__x86_64__)
+  { "sse2", scoreSse2, hasSse2 },
+  { "avx2", scoreAvx2, hasAvx2 },
+  { "avx512", scoreAvx512, hasAvx512 },
+#endif
+  { NULL, NULL, NULL }
+};
+
+scoreFn scoreBatch = scoreScalar;
+
+int scoreAvailable(const struct scorer *s)
+{
+#if defined(__x86_64__)
+    __builtin_cpu_init();
+#endif
+    return s->available == NULL || s->available();
+}
+
+const struct scorer *scoreFind(const char *name)
+{
+    const struct scorer *s;
+
+    for (s = scorers; s->name != NULL; s++)
+        if (strcmp(s->name, name) == 0)
+            return scoreAvailable(s) ? s : NULL;
+    return NULL;
+}
+
+const struct scorer *scoreInit(void)
+{
+    const struct scorer *s, *best = scorers;
+    const char *name = getenv("MM_SCORE");
+
+    if (name != NULL && (best = scoreFind(name)) == NULL)
+        best = scorers;
+    if (name == NULL)
+        for (s = scorers; s->name != NULL; s++)
+            if (scoreAvailable(s))
+                best = s;
+    scoreBatch = best->fn;
+    return best;
+}
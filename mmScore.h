@@ -0,0 +1,40 @@
+/**
+ * mmScore.h - Scoring one guess against many codes at once
+ * The codes are stored by peg: the first pegs of all codes, then all second
+ * pegs, ..., one byte each, @stride@ bytes apart. So a vector instruction
+ * compares one peg of 16, 32 or 64 codes with the guess; exact matches are
+ * counted per position, and common colours per colour of the guess. There
+ * is a scalar version for any machine, and SSE2, AVX2 and AVX-512 versions
+ * on x86-64. scoreInit() picks the best one this CPU has, once at start
+ * (or the one named in $MM_SCORE), and points scoreBatch to it.
+ */
+
+#ifndef MM_SCORE_H
+#define MM_SCORE_H
+
+#include <stdint.h>   /* Integer types */
+
+#include "mmMatch.h"  /* seqlen, colors, MATCH_CODE */
+
+/* scores @n@ codes at @pegs@ against @guess@, at the current size: out[i] is */
+/* MATCH_CODE(exact, approximate) of code i as the secret                     */
+typedef void (*scoreFn)(const uint8_t *pegs, int stride, int n, const int *guess, uint16_t *out);
+
+struct scorer
+{
+  const char *name;
+  scoreFn fn;
+  int (*available)(void);   /* does this CPU have it? NULL: always */
+};
+
+/* All scorers built for this machine, the scalar one first; ends with { NULL } */
+extern const struct scorer scorers[];
+
+/* The scorer in use: the scalar one until scoreInit() */
+extern scoreFn scoreBatch;
+
+const struct scorer *scoreInit(void);  /* Select the best available scorer, or $MM_SCORE; returns it */
+const struct scorer *scoreFind(const char *name);  /* Look up by name; NULL if unknown or not available */
+int scoreAvailable(const struct scorer *s);  /* Does this CPU have @s@? */
+
+#endif /* MM_SCORE_H */
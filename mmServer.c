@@ -0,0 +1,433 @@
+/* ***************************************************************************** */
+/* Multi-session game server: every connection on the Unix socket plays its own */
+/* game, kept in a struct mmSession (secret, attempts, history, I/O buffers).    */
+/* All sockets are non-blocking and served from a single epoll loop, so the      */
+/* number of sessions is only limited by the number of file descriptors.         */
+/* ***************************************************************************** */
+
+#define _GNU_SOURCE             /* accept4 */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <stdarg.h>
+#include <errno.h>
+#include <signal.h>
+#include <unistd.h>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+
+#include "mmMatch.h"
+#include "mmArena.h"
+#include "mmHist.h"
+#include "mmTime.h"
+#include "mmServer.h"
+
+/* events handled per epoll_wait call */
+#define SERVER_EVENTS 256
+
+struct mmSession
+{
+    int fd;
+    uint64_t rng;               /* per-session random numbers, for secrets */
+    int secret[SEQL_MAX];
+    int attempts;               /* guesses in this game */
+    int over;                   /* game won or lost; only N, S, H and Q are accepted */
+    int logged;                 /* game written to the log */
+    int guess[MAX_ATTEMPTS][SEQL_MAX];
+    int result[MAX_ATTEMPTS];   /* MATCH_CODE(exact, approx) */
+    uint64_t started;           /* Unix time the game started, for the log */
+    uint64_t waiting;           /* since when the next guess is expected (ns) */
+    unsigned int inputMs[MAX_ATTEMPTS];
+    int closing;                /* Q or end of input received: close once the output is sent */
+    int writing;                /* waiting for EPOLLOUT */
+    size_t inLen, outLen;
+    char in[SESSION_IN], out[SESSION_OUT];
+    struct mmSession *prev, *next;  /* the live sessions, to close them on shutdown */
+};
+
+static volatile sig_atomic_t stopServer = 0;
+static unsigned long nSessions, nGuesses;
+static struct mmPool sessionPool;
+static struct mmSession *sessions;
+static struct mmLog *gameLog;
+static matchFn match;           /* the matcher for the size of the games */
+
+static void onStop(int sig)
+{
+    (void)sig;
+    stopServer = 1;
+}
+
+// -----------------------------------------------------------------------------
+// Game logic, per session
+
+/* append the game to the log, unless it has been logged or is empty */
+static void sessionLog(struct mmSession *s)
+{
+    struct mmLogGame g;
+    int i;
+
+    if (gameLog == NULL || s->attempts == 0 || s->logged)
+        return;
+    g.start = s->started;
+    g.flags = (s->over ? LOG_OVER : 0) | (MATCH_EXACT(s->result[s->attempts - 1]) == seqlen ? LOG_WON : 0);
+    memcpy(g.secret, s->secret, sizeof(g.secret));
+    g.attempts = s->attempts;
+    for (i = 0; i < s->attempts; i++) {
+        memcpy(g.guess[i], s->guess[i], sizeof(g.guess[i]));
+        g.result[i] = s->result[i];
+        g.inputMs[i] = s->inputMs[i];
+    }
+    if (!logGame(gameLog, &g))
+        fprintf(stderr, "Cannot write to the game log: %s\n", strerror(errno));
+    s->logged = 1;
+}
+
+static void sessionGame(struct mmSession *s, const int *secret)
+{
+    int i;
+
+    sessionLog(s);              /* the previous game, if abandoned */
+
+    for (i = 0; i < seqlen; i++) {
+        if (secret != NULL) {
+            s->secret[i] = secret[i];
+        } else {
+            s->rng ^= s->rng << 13; s->rng ^= s->rng >> 7; s->rng ^= s->rng << 17;
+            s->secret[i] = (int)(s->rng % colors) + 1;
+        }
+    }
+    s->attempts = 0;
+    s->over = 0;
+    s->logged = 0;
+    s->started = delayWallNs() / 1000000000ULL;
+    s->waiting = histNowNs();
+}
+
+static void reply(struct mmSession *s, const char *fmt, ...)
+{
+    va_list ap;
+    int n;
+
+    va_start(ap, fmt);
+    n = vsnprintf(s->out + s->outLen, SESSION_OUT - s->outLen, fmt, ap);
+    va_end(ap);
+    if (n > 0 && (size_t)n < SESSION_OUT - s->outLen)
+        s->outLen += (size_t)n;
+}
+
+/* parse exactly seqlen pegs in 1..colors */
+static int parseGuess(const char *p, size_t len, int *seq)
+{
+    size_t i;
+
+    if (len != (size_t)seqlen)
+        return 0;
+    for (i = 0; i < len; i++) {
+        seq[i] = pegValue(p[i]);
+        if (seq[i] < 1 || seq[i] > colors)
+            return 0;
+    }
+    return 1;
+}
+
+static void sessionLine(struct mmSession *s, const char *line, size_t len)
+{
+    int seq[SEQL_MAX], code, i, j;
+
+    while (len > 0 && (line[len - 1] == '\r' || line[len - 1] == ' '))
+        len--;
+    if (len == 0)
+        return;
+
+    switch (line[0]) {
+    case 'N':
+        sessionGame(s, NULL);
+        reply(s, "OK\n");
+        return;
+    case 'S':
+        if (len > 2 && line[1] == ' ' && parseGuess(line + 2, len - 2, seq)) {
+            sessionGame(s, seq);
+            reply(s, "OK\n");
+        } else {
+            reply(s, "ERR secret\n");
+        }
+        return;
+    case 'H':
+        reply(s, "H %d", s->attempts);
+        for (i = 0; i < s->attempts; i++) {
+            reply(s, " ");
+            for (j = 0; j < seqlen; j++)
+                reply(s, "%c", pegChar(s->guess[i][j]));
+            reply(s, ":%d,%d", MATCH_EXACT(s->result[i]), MATCH_APPROX(s->result[i]));
+        }
+        reply(s, "\n");
+        return;
+    case 'Q':
+        s->closing = 1;
+        return;
+    }
+
+    if (!parseGuess(line, len, seq)) {
+        reply(s, "ERR guess\n");
+        return;
+    }
+    if (s->over) {
+        reply(s, "ERR over\n");
+        return;
+    }
+
+    code = match(s->secret, seq);
+    memcpy(s->guess[s->attempts], seq, sizeof(seq));
+    s->inputMs[s->attempts] = (unsigned int)((histNowNs() - s->waiting) / 1000000);
+    s->result[s->attempts++] = code;
+    s->waiting = histNowNs();
+    nGuesses++;
+
+    reply(s, "%d %d", MATCH_EXACT(code), MATCH_APPROX(code));
+    if (MATCH_EXACT(code) == seqlen) {
+        s->over = 1;
+        reply(s, " W");
+        sessionLog(s);
+    } else if (s->attempts == MAX_ATTEMPTS) {
+        s->over = 1;
+        reply(s, " L ");
+        for (j = 0; j < seqlen; j++)
+            reply(s, "%c", pegChar(s->secret[j]));
+        sessionLog(s);
+    }
+    reply(s, "\n");
+}
+
+// -----------------------------------------------------------------------------
+// Connection handling
+
+static void sessionClose(int ep, struct mmSession *s)
+{
+    sessionLog(s);
+    epoll_ctl(ep, EPOLL_CTL_DEL, s->fd, NULL);
+    close(s->fd);
+    if (s->prev != NULL)
+        s->prev->next = s->next;
+    else
+        sessions = s->next;
+    if (s->next != NULL)
+        s->next->prev = s->prev;
+    poolFree(&sessionPool, s);
+}
+
+/* send as much output as possible; returns -1 if the connection is gone */
+static int sessionFlush(int ep, struct mmSession *s)
+{
+    struct epoll_event ev;
+    ssize_t n;
+    size_t done = 0;
+
+    while (done < s->outLen) {
+        n = write(s->fd, s->out + done, s->outLen - done);
+        if (n < 0 && errno == EINTR)
+            continue;
+        if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK))
+            break;
+        if (n <= 0)
+            return -1;
+        done += (size_t)n;
+    }
+    memmove(s->out, s->out + done, s->outLen - done);
+    s->outLen -= done;
+
+    /* only ask for EPOLLOUT while there is output pending */
+    if ((s->outLen > 0) != s->writing) {
+        s->writing = (s->outLen > 0);
+        ev.events = (s->writing ? EPOLLOUT : EPOLLIN);   /* no reading while output is pending */
+        ev.data.ptr = s;
+        epoll_ctl(ep, EPOLL_CTL_MOD, s->fd, &ev);
+    }
+    return 0;
+}
+
+/* is a complete line waiting in the input buffer? */
+static int sessionPending(const struct mmSession *s)
+{
+    return s->inLen > 0 && memchr(s->in, '\n', s->inLen) != NULL;
+}
+
+/* answer the complete lines received, and read more; stops while the output */
+/* buffer is half full, so a client that does not read its replies cannot    */
+/* make the server buffer them. At the end of the input (the client may only */
+/* have shut down its side) the session closes once the replies are sent     */
+static int sessionRead(struct mmSession *s)
+{
+    ssize_t n;
+    char *nl, *start;
+
+    for (;;) {
+        start = s->in;
+        while (!s->closing && s->outLen < SESSION_OUT / 2 &&
+               (nl = memchr(start, '\n', s->inLen - (size_t)(start - s->in))) != NULL) {
+            sessionLine(s, start, (size_t)(nl - start));
+            start = nl + 1;
+        }
+        s->inLen -= (size_t)(start - s->in);
+        memmove(s->in, start, s->inLen);
+        if (s->inLen == SESSION_IN) {   /* no newline in a whole buffer */
+            reply(s, "ERR long\n");
+            s->inLen = 0;
+        }
+        if (s->closing || s->outLen >= SESSION_OUT / 2)
+            return 0;
+
+        n = read(s->fd, s->in + s->inLen, SESSION_IN - s->inLen);
+        if (n < 0 && errno == EINTR)
+            continue;
+        if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK))
+            return 0;
+        if (n < 0)
+            return -1;
+        if (n == 0) {
+            s->closing = 1;
+            return 0;
+        }
+        s->inLen += (size_t)n;
+    }
+}
+
+static void acceptAll(int ep, int lfd)
+{
+    struct epoll_event ev;
+    struct mmSession *s;
+    int fd;
+
+    while ((fd = accept4(lfd, NULL, NULL, SOCK_NONBLOCK | SOCK_CLOEXEC)) >= 0) {
+        s = (struct mmSession *)poolAlloc(&sessionPool);
+        if (s == NULL) {
+            close(fd);
+            continue;
+        }
+        s->fd = fd;
+        s->rng = delayWallNs() / 1000000000ULL * 0x9E3779B97F4A7C15ULL + ++nSessions;
+        sessionGame(s, NULL);
+
+        ev.events = EPOLLIN;
+        ev.data.ptr = s;
+        if (epoll_ctl(ep, EPOLL_CTL_ADD, fd, &ev) < 0) {
+            close(fd);
+            poolFree(&sessionPool, s);
+            continue;
+        }
+        s->next = sessions;
+        if (sessions != NULL)
+            sessions->prev = s;
+        sessions = s;
+    }
+}
+
+// -----------------------------------------------------------------------------
+// Main loop
+
+int serverRun(const char *path, struct mmLog *log, int verbose)
+{
+    struct sockaddr_un addr;
+    struct epoll_event ev, events[SERVER_EVENTS];
+    struct sigaction sa;
+    struct mmSession *s;
+    int lfd, ep, n, i;
+
+    gameLog = log;
+    match = matcherBest()->fn;
+    if (strlen(path) >= sizeof(addr.sun_path)) {
+        fprintf(stderr, "Socket path too long: %s\n", path);
+        return 1;
+    }
+
+    memset(&sa, 0, sizeof(sa));
+    sa.sa_handler = onStop;
+    sigaction(SIGINT, &sa, NULL);
+    sigaction(SIGTERM, &sa, NULL);
+    signal(SIGPIPE, SIG_IGN);
+
+    if (!poolInit(&sessionPool, "session", sizeof(struct mmSession), SESSION_SLAB, SESSION_MAX / SESSION_SLAB)) {
+        fprintf(stderr, "Out of memory for sessions\n");
+        return 1;
+    }
+
+    lfd = socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (lfd < 0) {
+        perror("socket");
+        return 1;
+    }
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    strcpy(addr.sun_path, path);
+    unlink(path);
+    if (bind(lfd, (struct sockaddr *)&addr, sizeof(addr)) < 0 || listen(lfd, SERVER_BACKLOG) < 0) {
+        fprintf(stderr, "Cannot listen on %s: %s\n", path, strerror(errno));
+        close(lfd);
+        return 1;
+    }
+
+    ep = epoll_create1(EPOLL_CLOEXEC);
+    ev.events = EPOLLIN;
+    ev.data.ptr = NULL;         /* NULL marks the listening socket */
+    if (ep < 0 || epoll_ctl(ep, EPOLL_CTL_ADD, lfd, &ev) < 0) {
+        perror("epoll");
+        close(lfd);
+        unlink(path);
+        return 1;
+    }
+    if (verbose)
+        fprintf(stderr, "Serving MasterMind (%d colours, length %d) on %s\n", colors, seqlen, path);
+
+    while (!stopServer) {
+        n = epoll_wait(ep, events, SERVER_EVENTS, -1);
+        if (n < 0) {
+            if (errno == EINTR)
+                continue;
+            perror("epoll_wait");
+            break;
+        }
+        for (i = 0; i < n; i++) {
+            s = (struct mmSession *)events[i].data.ptr;
+            if (s == NULL) {
+                acceptAll(ep, lfd);
+                continue;
+            }
+            if ((events[i].events & (EPOLLIN | EPOLLHUP | EPOLLERR)) && sessionRead(s) < 0) {
+                sessionClose(ep, s);
+                continue;
+            }
+            /* send the replies; once they are all out, answer any lines held */
+            /* back while the output buffer was full                         */
+            for (;;) {
+                if (sessionFlush(ep, s) < 0 || (s->closing && s->outLen == 0)) {
+                    sessionClose(ep, s);
+                    break;
+                }
+                if (s->outLen > 0 || s->closing || !sessionPending(s))
+                    break;
+                if (sessionRead(s) < 0) {
+                    sessionClose(ep, s);
+                    break;
+                }
+            }
+        }
+    }
+
+    /* log the games still open, and send what replies can be sent */
+    while (sessions != NULL) {
+        sessionFlush(ep, sessions);
+        sessionClose(ep, sessions);
+    }
+    if (verbose) {
+        fprintf(stderr, "Server stopped: %lu sessions, %lu guesses\n", nSessions, nGuesses);
+        poolPrint(&sessionPool, stderr);
+    }
+    poolDestroy(&sessionPool);
+    close(ep);
+    close(lfd);
+    unlink(path);
+    return 0;
+}
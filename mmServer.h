@@ -0,0 +1,36 @@
+/**
+ * mmServer.h - Multi-session MasterMind server on a Unix domain socket
+ * One game per connection; all sessions are served from one epoll loop
+ *
+ * Protocol: one command per line, one reply line per command; sequences are
+ * one character per peg, 1-9 then a-z (for games of more than 9 colours)
+ *   <guess>    e.g. 123  ->  "<exact> <approx>", followed by " W" if the
+ *              secret was found, or " L <secret>" after the last attempt
+ *   N          new game (also started on connect)  ->  "OK"
+ *   S <secret> new game with the given secret      ->  "OK"
+ *   H          history  ->  "H <attempts>" and " <guess>:<exact>,<approx>" per attempt
+ *   Q          close the connection (as does the end of the input, once
+ *              the replies to the lines before it are sent)
+ * Errors are reported as "ERR <reason>".
+ * Finished games, and games abandoned after a guess, are appended to the
+ * game log (see mmLog.h) if one is given; on SIGINT/SIGTERM, so are the
+ * games still open.
+ */
+
+#ifndef MM_SERVER_H
+#define MM_SERVER_H
+
+#include "mmLog.h"
+
+/* Pending connections, and the buffers per session */
+#define SERVER_BACKLOG 1024
+#define SESSION_IN     128
+#define SESSION_OUT    512
+
+/* Sessions come from a slab pool (see mmArena.h): SESSION_SLAB at a time, at most SESSION_MAX */
+#define SESSION_SLAB   256
+#define SESSION_MAX    (SESSION_SLAB * 4096)
+
+int serverRun(const char *path, struct mmLog *log, int verbose);  /* Serve until SIGINT/SIGTERM; 0 on a clean exit */
+
+#endif /* MM_SERVER_H */
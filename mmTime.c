@@ -0,0 +1,224 @@
+/* ***************************************************************************** */
+/* Calibrated delay functions for the MasterMind game                            */
+/* Short waits spin on a clock, long waits sleep for the bulk of the time and    */
+/* spin for the rest; the sleep overshoot is measured once at start-up. On the   */
+/* virtual clock a delay is a single sleep, which only advances the clock        */
+/* ***************************************************************************** */
+
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <time.h>
+
+#include "mmTime.h"
+#include "mmTrace.h"
+
+/* number of sleeps used to measure the nanosleep overshoot */
+#define CAL_ROUNDS 25
+/* length of a single calibration sleep, in us */
+#define CAL_SLEEP  200
+/* upper bound for the calibrated slack, in us */
+#define SLACK_MAX  2000
+
+/* BCM system timer (free-running 1MHz counter, CLO is word 1); NULL if not mapped */
+static volatile uint32_t *sysTimer = NULL;
+
+/* expected overshoot of nanosleep in us; wiringPi reports 80 to 130us on the Pi */
+static unsigned int slack = 100;
+
+// -----------------------------------------------------------------------------
+// Clocks
+
+static uint64_t realNow(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC_RAW, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+static uint64_t realWall(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_REALTIME, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+/* sleep for (at least) @ns@ nanoseconds, restarting after signals */
+static void realSleep(uint64_t ns)
+{
+    struct timespec sleeper, rem;
+
+    sleeper.tv_sec  = (time_t)(ns / 1000000000ULL);
+    sleeper.tv_nsec = (long)(ns % 1000000000ULL);
+
+    while (nanosleep(&sleeper, &rem) != 0 && errno == EINTR)
+        sleeper = rem;
+}
+
+const struct mmClock clockReal = { "real", realNow, realWall, realSleep };
+
+/* virtual time: it only moves when slept on */
+static uint64_t virtualNs = VIRTUAL_START_NS;
+
+static uint64_t virtualNow(void)
+{
+    return virtualNs;
+}
+
+static uint64_t virtualWall(void)
+{
+    return VIRTUAL_EPOCH * 1000000000ULL + (virtualNs - VIRTUAL_START_NS);
+}
+
+static void virtualSleep(uint64_t ns)
+{
+    virtualNs += ns;
+}
+
+const struct mmClock clockVirtual = { "virtual", virtualNow, virtualWall, virtualSleep };
+
+/* the clock of all delays and time queries, see delaySetClock() */
+static const struct mmClock *source = &clockReal;
+
+void delaySetClock(const struct mmClock *c)
+{
+    source = (c != NULL ? c : &clockReal);
+}
+
+const struct mmClock *delayClock(void)
+{
+    return source;
+}
+
+// -----------------------------------------------------------------------------
+// Time source
+
+uint64_t delayNowNs(void)
+{
+    return source->now();
+}
+
+uint64_t delayWallNs(void)
+{
+    return source->wall();
+}
+
+void delaySleepNs(uint64_t ns)
+{
+    source->sleep(ns);
+}
+
+unsigned int delaySlack(void)
+{
+    return slack;
+}
+
+static int cmpUint(const void *a, const void *b)
+{
+    unsigned int x = *(const unsigned int *)a, y = *(const unsigned int *)b;
+
+    return (x > y) - (x < y);
+}
+
+/* measure how much longer than requested nanosleep takes, and remember the */
+/* 90th percentile as the amount of time to spin at the end of each delay   */
+void delayInit(volatile uint32_t *timer)
+{
+    unsigned int over[CAL_ROUNDS];
+    uint64_t t0, t1;
+    int64_t ns;
+    int i;
+
+    sysTimer = timer;
+    if (source != &clockReal) {	// sleeps are exact
+        slack = 0;
+        return;
+    }
+
+    for (i = 0; i < CAL_ROUNDS; i++) {
+        t0 = delayNowNs();
+        realSleep(CAL_SLEEP * 1000ULL);
+        t1 = delayNowNs();
+        /* signed: a coarse or virtualised clock can measure less than was slept */
+        ns = (int64_t)(t1 - t0) - (int64_t)CAL_SLEEP * 1000;
+        over[i] = (ns > 0 ? (unsigned int)(ns / 1000) : 0);
+    }
+    qsort(over, CAL_ROUNDS, sizeof(over[0]), cmpUint);
+
+    slack = over[(CAL_ROUNDS * 9) / 10];
+    if (slack > SLACK_MAX)
+        slack = SLACK_MAX;
+}
+
+// -----------------------------------------------------------------------------
+// Delays
+
+/* sleep for all but the last @slack@ us of the wait, then spin to the deadline */
+static void waitUs(uint64_t us)
+{
+    int doSleep = us > (uint64_t)slack + DELAY_SPIN_MIN;
+
+    if (us == 0)
+        return;
+    if (source != &clockReal) {
+        source->sleep(us * 1000ULL);
+        return;
+    }
+
+    if (sysTimer != NULL && us < 0x80000000ULL) {
+        uint32_t start = sysTimer[1];
+
+        if (doSleep)
+            realSleep((us - slack) * 1000ULL);
+        while ((uint32_t)(sysTimer[1] - start) < (uint32_t)us)
+            ;
+    } else {
+        uint64_t start = delayNowNs();
+        uint64_t wait = us * 1000ULL;
+
+        if (doSleep)
+            realSleep((us - slack) * 1000ULL);
+        while (delayNowNs() - start < wait)
+            ;
+    }
+}
+
+/*
+ * delay:
+ *	Wait for some number of milliseconds
+ *********************************************************************************
+ */
+
+void delay(unsigned int howLong)
+{
+    TRACE_BEGIN(t0);
+    waitUs((uint64_t)howLong * 1000ULL);
+    TRACE_END(t0, "delay", (int32_t)howLong * 1000);	/* arg: requested us */
+}
+
+/* Based on wiringPi code; comment by Gordon Henderson
+ * delayMicroseconds:
+ *	This is somewhat intersting. It seems that on the Pi, a single call
+ *	to nanosleep takes some 80 to 130 microseconds anyway, so while
+ *	obeying the standards (may take longer), it's not always what we
+ *	want!
+ *
+ *	So what I'll do now is if the delay is less than 100uS we'll do it
+ *	in a hard loop, watching a built-in counter on the ARM chip. This is
+ *	somewhat sub-optimal in that it uses 100% CPU, something not an issue
+ *	in a microcontroller, but under a multi-tasking, multi-user OS, it's
+ *	wastefull, however we've no real choice )-:
+ *
+ * Here the threshold is not fixed at 100uS but is the overshoot measured
+ * by delayInit(), and longer waits only spin for that final stretch.
+ *********************************************************************************
+ */
+
+void delayMicroseconds(unsigned int howLong)
+{
+    TRACE_BEGIN(t0);
+    waitUs(howLong);
+    TRACE_END(t0, "delayMicroseconds", (int32_t)howLong);
+}
@@ -0,0 +1,52 @@
+/**
+ * mmTime.h - Calibrated delay functions for the MasterMind game
+ * Hybrid spin/sleep delays, used by the LCD, LED and button code
+ * All time queries and sleeps go through a clock: the real one, or a virtual
+ * one whose sleeps advance it at once, so that a whole game on simulated
+ * hardware takes as long as its computation (see master-mind -V)
+ */
+
+#ifndef MM_TIME_H
+#define MM_TIME_H
+
+#include <stdint.h>   /* Integer types */
+
+/* Physical address of the BCM2836/7 system timer (RPi2/3) */
+#define SYSTIMER_BASE 0x3F003000
+
+/* Delays below this many microseconds are always done in a spin loop */
+#define DELAY_SPIN_MIN 20
+
+/* Start of the virtual clock: monotonic time (not 0, which means "none" to */
+/* some callers), and wall-clock time, 2025-01-01 00:00:00 UTC, in seconds  */
+#define VIRTUAL_START_NS 1000000000ULL
+#define VIRTUAL_EPOCH    1735689600ULL
+
+/* A clock: monotonic and wall-clock time, and sleeping without spinning */
+struct mmClock
+{
+    const char *name;
+    uint64_t (*now)(void);        /* monotonic time in ns */
+    uint64_t (*wall)(void);       /* ns since the epoch */
+    void (*sleep)(uint64_t ns);   /* for (at least) @ns@ */
+};
+
+extern const struct mmClock clockReal;     /* CLOCK_MONOTONIC_RAW, CLOCK_REALTIME and nanosleep */
+extern const struct mmClock clockVirtual;  /* from VIRTUAL_START_NS; a sleep only adds to it */
+
+/* Clock */
+void delaySetClock(const struct mmClock *clock);  /* Clock of all delays and time queries; before delayInit() */
+const struct mmClock *delayClock(void);  /* The clock in use; clockReal unless set */
+uint64_t delayWallNs(void);  /* Wall-clock time in ns since the epoch */
+void delaySleepNs(uint64_t ns);  /* Sleep, without spinning, for at least @ns@ */
+
+/* Calibration and time source */
+void delayInit(volatile uint32_t *sysTimer);  /* Calibrate sleep overshoot; sysTimer may be NULL; none on a virtual clock */
+uint64_t delayNowNs(void);  /* Monotonic (raw) time in nanoseconds, of the clock in use */
+unsigned int delaySlack(void);  /* Calibrated nanosleep overshoot in us */
+
+/* Delays */
+void delay(unsigned int howLong);  /* Delay in milliseconds */
+void delayMicroseconds(unsigned int howLong);  /* Delay in microseconds */
+
+#endif /* MM_TIME_H */
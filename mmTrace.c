@@ -0,0 +1,113 @@
+/* ***************************************************************************** */
+/* Hot-path event tracing, only compiled with -DMM_TRACE                         */
+/* Each thread writes to its own ring buffer, so recording an event takes no     */
+/* lock; rings are added to a global list with an atomic compare-and-swap, and   */
+/* all of them are written as Chrome trace JSON (chrome://tracing, Perfetto) at  */
+/* exit                                                                          */
+/* ***************************************************************************** */
+
+#ifdef MM_TRACE
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#include "mmTrace.h"
+
+struct traceRec
+{
+  const char *name ;	// a string literal
+  uint64_t ts, dur ;	// in ns
+  int32_t arg ;
+  char phase ;		// 'i' instant, 'X' complete
+} ;
+
+struct traceRing
+{
+  struct traceRing *next ;
+  int tid ;
+  uint64_t head ;	// number of events recorded; written by the owner only
+  struct traceRec recs [TRACE_RING_SIZE] ;
+} ;
+
+static struct traceRing *rings = NULL ;
+static int nextTid = 1 ;
+static uint64_t traceStart ;
+static __thread struct traceRing *myRing = NULL ;
+
+static void traceDump(void) ;
+
+static struct traceRing *newRing(void)
+{
+  struct traceRing *r = (struct traceRing *)calloc(1, sizeof(struct traceRing)) ;
+  struct traceRing *old ;
+
+  if (r == NULL)
+    return NULL ;
+  r->tid = __atomic_fetch_add(&nextTid, 1, __ATOMIC_RELAXED) ;
+
+  old = __atomic_load_n(&rings, __ATOMIC_ACQUIRE) ;
+  do {
+    r->next = old ;
+  } while (!__atomic_compare_exchange_n(&rings, &old, r, 0, __ATOMIC_RELEASE, __ATOMIC_ACQUIRE)) ;
+
+  if (r->tid == 1) {	// first ring: the process-wide set-up
+    traceStart = delayNowNs() ;
+    atexit(traceDump) ;
+  }
+  return r ;
+}
+
+void traceEvent(const char *name, char phase, uint64_t ts, uint64_t dur, int32_t arg)
+{
+  struct traceRec *rec ;
+
+  if (myRing == NULL && (myRing = newRing()) == NULL)
+    return ;
+
+  rec = &myRing->recs [myRing->head & (TRACE_RING_SIZE - 1)] ;
+  rec->name  = name ;
+  rec->phase = phase ;
+  rec->ts    = ts ;
+  rec->dur   = dur ;
+  rec->arg   = arg ;
+  __atomic_store_n(&myRing->head, myRing->head + 1, __ATOMIC_RELEASE) ;
+}
+
+static void traceDump(void)
+{
+  const char *file = getenv("MM_TRACE_FILE") ;
+  struct traceRing *r ;
+  uint64_t head, i, first ;
+  FILE *out ;
+  int sep = 0 ;
+
+  if (file == NULL)
+    file = TRACE_FILE ;
+  if ((out = fopen(file, "w")) == NULL) {
+    fprintf(stderr, "trace: cannot write %s\n", file) ;
+    return ;
+  }
+
+  fprintf(out, "{\"traceEvents\":[\n") ;
+  for (r = __atomic_load_n(&rings, __ATOMIC_ACQUIRE) ; r != NULL ; r = r->next) {
+    head = __atomic_load_n(&r->head, __ATOMIC_ACQUIRE) ;
+    first = (head > TRACE_RING_SIZE ? head - TRACE_RING_SIZE : 0) ;
+    for (i = first ; i < head ; i++) {
+      const struct traceRec *rec = &r->recs [i & (TRACE_RING_SIZE - 1)] ;
+
+      fprintf(out, "%s{\"name\":\"%s\",\"ph\":\"%c\",\"ts\":%.3f,", (sep ? ",\n" : ""),
+	      rec->name, rec->phase, (double)(int64_t)(rec->ts - traceStart) / 1000.0) ;
+      if (rec->phase == 'X')
+	fprintf(out, "\"dur\":%.3f,", rec->dur / 1000.0) ;
+      else
+	fprintf(out, "\"s\":\"t\",") ;
+      fprintf(out, "\"pid\":%d,\"tid\":%d,\"args\":{\"arg\":%d}}", (int)getpid(), r->tid, rec->arg) ;
+      sep = 1 ;
+    }
+  }
+  fprintf(out, "\n]}\n") ;
+  fclose(out) ;
+}
+
+#endif /* MM_TRACE */
@@ -0,0 +1,38 @@
+/**
+ * mmTrace.h - Hot-path event tracing for the MasterMind game
+ * Compiled out entirely unless MM_TRACE is defined (make trace); events go to a
+ * per-thread ring buffer and are written as Chrome trace JSON at exit
+ */
+
+#ifndef MM_TRACE_H
+#define MM_TRACE_H
+
+#include <stdint.h>   /* Integer types */
+
+/* Events per thread; older events are overwritten when the ring is full */
+#define TRACE_RING_SIZE (1 << 16)
+
+/* Output file, unless set in the environment variable MM_TRACE_FILE */
+#define TRACE_FILE "mm-trace.json"
+
+#ifdef MM_TRACE
+
+#include "mmTime.h"
+
+void traceEvent(const char *name, char phase, uint64_t ts, uint64_t dur, int32_t arg);  /* Record one event */
+
+/* an instantaneous event, e.g. a GPIO write or a button edge */
+#define TRACE_INSTANT(name, arg)   traceEvent((name), 'i', delayNowNs(), 0, (arg))
+/* an event with a duration: TRACE_BEGIN declares the start time @var@ */
+#define TRACE_BEGIN(var)           uint64_t var = delayNowNs()
+#define TRACE_END(var, name, arg)  traceEvent((name), 'X', (var), delayNowNs() - (var), (arg))
+
+#else
+
+#define TRACE_INSTANT(name, arg)   ((void)0)
+#define TRACE_BEGIN(var)
+#define TRACE_END(var, name, arg)  ((void)0)
+
+#endif /* MM_TRACE */
+
+#endif /* MM_TRACE_H */
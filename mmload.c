@@ -0,0 +1,199 @@
+/*
+  A load generator for the MasterMind server (master-mind -S <socket>)
+
+  Keeps a number of connections busy, each playing one game per session with
+  random guesses, and reports sessions and guesses per second, and the latency
+  from sending a guess to receiving its reply.
+
+$ ./master-mind -S /tmp/mm.sock &
+$ ./mmload -S /tmp/mm.sock -c 200 -n 100000
+
+For a server of games of another size (master-mind -l 4 -c 6 -S ...), give
+the same size with -g 4x6.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <errno.h>
+#include <signal.h>
+#include <unistd.h>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <fcntl.h>
+
+#include "mmMatch.h"
+#include "mmHist.h"
+
+#define DEFAULT_SOCKET "/tmp/mm.sock"
+#define MAX_EVENTS     256
+
+struct client
+{
+  int fd;
+  uint64_t sent;		// when the pending guess was sent; 0 if none
+  size_t inLen;
+  char in[128];
+} ;
+
+static struct sockaddr_un addr;
+static uint64_t rng = 88172645463325252ULL;
+static unsigned long started, finished, guesses, errors;
+
+static int connectClient(int ep, struct client *c)
+{
+  struct epoll_event ev;
+
+  c->fd = socket(AF_UNIX, SOCK_STREAM, 0);
+  if (c->fd < 0 || connect(c->fd, (struct sockaddr *)&addr, sizeof(addr)) < 0) {
+    fprintf(stderr, "Cannot connect to %s: %s\n", addr.sun_path, strerror(errno));
+    return -1;
+  }
+  fcntl(c->fd, F_SETFL, O_NONBLOCK);
+  c->inLen = 0;
+  c->sent = 0;
+  ev.events = EPOLLIN;
+  ev.data.ptr = c;
+  epoll_ctl(ep, EPOLL_CTL_ADD, c->fd, &ev);
+  started++;
+  return 0;
+}
+
+static int sendLine(struct client *c, const char *line, size_t len)
+{
+  // replies are read before the next line is sent, so the socket buffer never fills up
+  return write(c->fd, line, len) == (ssize_t)len ? 0 : -1;
+}
+
+static int sendGuess(struct client *c)
+{
+  char line[SEQL_MAX + 1];
+  int i;
+
+  for (i = 0; i < seqlen; i++) {
+    rng ^= rng << 13; rng ^= rng >> 7; rng ^= rng << 17;
+    line[i] = (char)pegChar((int)(rng % colors) + 1);
+  }
+  line[seqlen] = '\n';
+  c->sent = histNowNs();
+  return sendLine(c, line, (size_t)seqlen + 1);
+}
+
+int main(int argc, char **argv)
+{
+  struct epoll_event events[MAX_EVENTS];
+  struct client *clients, *c;
+  struct mmHist lat;
+  const char *path = DEFAULT_SOCKET;
+  int conc = 100, total = 10000, verbose = 0, opt, ep, i, n;
+  int opt_l = SEQL, opt_k = COLS;
+  uint64_t t0;
+  double secs;
+  char *nl;
+
+  while ((opt = getopt(argc, argv, "hvS:c:n:g:")) != -1) {
+    switch (opt) {
+    case 'v':
+      verbose = 1;
+      break;
+    case 'S':
+      path = optarg;
+      break;
+    case 'c':
+      conc = atoi(optarg);
+      break;
+    case 'n':
+      total = atoi(optarg);
+      break;
+    case 'g':
+      if (sscanf(optarg, "%dx%d", &opt_l, &opt_k) != 2)
+	opt_l = 0;
+      break;
+    default: /* '?' */
+      fprintf(stderr, "Usage: %s [-h] [-v] [-S <socket>] [-c <concurrent sessions>] [-n <sessions>] [-g <length>x<colours>]\n", argv[0]);
+      exit(opt == 'h' ? EXIT_SUCCESS : EXIT_FAILURE);
+    }
+  }
+  if (conc < 1 || total < 1 || strlen(path) >= sizeof(addr.sun_path) || !matchSetSize(opt_l, opt_k)) {
+    fprintf(stderr, "Bad arguments\n");
+    exit(EXIT_FAILURE);
+  }
+  if (conc > total)
+    conc = total;
+
+  signal(SIGPIPE, SIG_IGN);
+  memset(&addr, 0, sizeof(addr));
+  addr.sun_family = AF_UNIX;
+  strcpy(addr.sun_path, path);
+  histInit(&lat, "guess->reply");
+
+  clients = (struct client *)calloc(conc, sizeof(struct client));
+  ep = epoll_create1(0);
+  if (clients == NULL || ep < 0) {
+    fprintf(stderr, "Cannot set up %d clients\n", conc);
+    exit(EXIT_FAILURE);
+  }
+
+  t0 = histNowNs();
+  for (i = 0; i < conc; i++)
+    if (connectClient(ep, &clients[i]) < 0 || sendGuess(&clients[i]) < 0)
+      exit(EXIT_FAILURE);
+
+  while (finished < (unsigned long)total) {
+    n = epoll_wait(ep, events, MAX_EVENTS, 5000);
+    if (n == 0) {
+      fprintf(stderr, "No reply from the server for 5s\n");
+      exit(EXIT_FAILURE);
+    }
+    for (i = 0; i < n; i++) {
+      c = (struct client *)events[i].data.ptr;
+      ssize_t r = read(c->fd, c->in + c->inLen, sizeof(c->in) - c->inLen);
+      if (r < 0 && (errno == EAGAIN || errno == EINTR))
+	continue;
+      if (r <= 0) {
+	fprintf(stderr, "Server closed a connection\n");
+	exit(EXIT_FAILURE);
+      }
+      c->inLen += (size_t)r;
+
+      while ((nl = memchr(c->in, '\n', c->inLen)) != NULL) {
+	size_t len = (size_t)(nl - c->in) + 1;
+	int over = (memchr(c->in, 'W', len) != NULL || memchr(c->in, 'L', len) != NULL);
+
+	if (c->sent != 0) {
+	  histSince(&lat, c->sent);
+	  c->sent = 0;
+	  guesses++;
+	}
+	if (c->in[0] == 'E')
+	  errors++;
+	memmove(c->in, nl + 1, c->inLen - len);
+	c->inLen -= len;
+
+	if (!over) {
+	  if (sendGuess(c) < 0)
+	    exit(EXIT_FAILURE);
+	  continue;
+	}
+	// game over: end this session, and start another one if needed
+	sendLine(c, "Q\n", 2);
+	close(c->fd);
+	finished++;
+	if (started < (unsigned long)total &&
+	    (connectClient(ep, c) < 0 || sendGuess(c) < 0))
+	  exit(EXIT_FAILURE);
+	break;
+      }
+    }
+  }
+
+  secs = (histNowNs() - t0) / 1e9;
+  fprintf(stdout, "%lu sessions, %lu guesses in %.2f s: %.0f sessions/s, %.0f guesses/s (%d concurrent)\n",
+	  finished, guesses, secs, finished / secs, guesses / secs, conc);
+  histPrint(&lat, stdout);
+  if (errors > 0 || verbose)
+    fprintf(stdout, "%lu error replies\n", errors);
+  return errors > 0 ? EXIT_FAILURE : EXIT_SUCCESS;
+}
@@ -0,0 +1,91 @@
+/*
+  Summary of MasterMind game logs (see mmLog.h), as written by master-mind -L
+
+  Prints how many guesses games took, how often they were won, and how long
+  players took to enter their guesses. The logs are mapped, not read, so
+  millions of games take well under a second.
+
+$ ./mmlogsum games.log [more.log ...]
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "mmLog.h"
+
+int main(int argc, char **argv)
+{
+  struct mmLogReader r;
+  struct mmLogGame g;
+  unsigned long games = 0, won = 0, over = 0, damaged = 0;
+  unsigned long wonIn[MAX_ATTEMPTS + 1] = { 0 }, inputs[MAX_ATTEMPTS] = { 0 };
+  double inputMs[MAX_ATTEMPTS] = { 0 }, totalMs = 0;
+  unsigned long totalInputs = 0;
+  struct timespec t0, t1;
+  int verbose = 0, opt, i, res;
+
+  while ((opt = getopt(argc, argv, "hv")) != -1) {
+    switch (opt) {
+    case 'v':
+      verbose = 1;
+      break;
+    default: /* '?' */
+      fprintf(stderr, "Usage: %s [-h] [-v] <log file> ...\n", argv[0]);
+      exit(opt == 'h' ? EXIT_SUCCESS : EXIT_FAILURE);
+    }
+  }
+  if (optind >= argc) {
+    fprintf(stderr, "Usage: %s [-h] [-v] <log file> ...\n", argv[0]);
+    exit(EXIT_FAILURE);
+  }
+
+  clock_gettime(CLOCK_MONOTONIC, &t0);	// real time: the cost of reading the logs
+  for (; optind < argc; optind++) {
+    if (!logMap(&r, argv[optind])) {
+      fprintf(stderr, "%s: cannot read, or not a game log\n", argv[optind]);
+      continue;
+    }
+    while ((res = logNext(&r, &g)) > 0) {
+      games++;
+      if (g.flags & LOG_OVER)
+	over++;
+      if (g.flags & LOG_WON) {
+	won++;
+	wonIn[g.attempts]++;
+      }
+      for (i = 0; i < g.attempts; i++) {
+	inputs[i]++;
+	inputMs[i] += g.inputMs[i];
+      }
+    }
+    if (res < 0) {
+      fprintf(stderr, "%s: damaged record at offset %ld, skipping the rest\n",
+	      argv[optind], (long)(r.p - r.base));
+      damaged++;
+    }
+    logUnmap(&r);
+  }
+  clock_gettime(CLOCK_MONOTONIC, &t1);
+
+  fprintf(stdout, "%lu games: %lu won, %lu lost, %lu abandoned\n", games, won, over - won, games - over);
+  fprintf(stdout, "Guesses needed by the games won:\n");
+  for (i = 1; i <= MAX_ATTEMPTS; i++)
+    fprintf(stdout, "  %d: %9lu  %5.1f%%\n", i, wonIn[i], won ? 100.0 * wonIn[i] / won : 0.0);
+  fprintf(stdout, "Average time to enter a guess:\n");
+  for (i = 0; i < MAX_ATTEMPTS; i++) {
+    if (inputs[i] == 0)
+      continue;
+    fprintf(stdout, "  attempt %d: %8.0f ms (%lu guesses)\n", i + 1, inputMs[i] / inputs[i], inputs[i]);
+    totalMs += inputMs[i];
+    totalInputs += inputs[i];
+  }
+  if (totalInputs > 0)
+    fprintf(stdout, "  all:       %8.0f ms\n", totalMs / totalInputs);
+  if (verbose)
+    fprintf(stderr, "Read %lu games in %.3f s\n", games,
+	    (t1.tv_sec - t0.tv_sec) + (t1.tv_nsec - t0.tv_nsec) / 1e9);
+  return damaged ? EXIT_FAILURE : EXIT_SUCCESS;
+}
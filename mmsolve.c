@@ -0,0 +1,840 @@
+/*
+  Static MasterMind solver: finds a smallest set of guesses that are all asked
+  at once, before any feedback, such that the feedback to all of them together
+  tells every secret apart
+
+$ ./mmsolve -g 4x6
+
+  First a greedy set gives an upper bound: guesses are added one at a time,
+  each the one leaving the smallest largest class of codes not told apart,
+  until all are. The search then looks for a smaller set, within a time
+  budget (-b): if it runs out, the greedy size is reported as an upper bound.
+
+  Search: iterative deepening on the size k of the set, from the lower bound
+  given by the number of feedback values F, up to one less than the greedy set. Every code has a signature, a
+  64-bit hash of its feedback to the guesses so far; a set is a solution if
+  all signatures are distinct. Adding a guess updates the signatures and
+  counts them in a hash table; a branch is cut as soon as a class of equal
+  signatures has more than F^r codes, with r guesses left. Symmetries of
+  positions and colours are broken for the first two guesses: the first is
+  one of a few canonical codes (1111, 1112, 1122, ...), the second the least
+  of its orbit under the symmetries keeping the first. The rest of the set
+  is taken in increasing order; at each level all candidates are tried, and
+  the ones within the bound searched best first (smallest largest class).
+  The pairs of first and second guess are shared out between threads, which
+  stop once one finds a solution.
+
+  With -p, plays games instead against random secrets, each guess the next
+  one consistent with all results so far, from the constraint solver in
+  mmGuess.c; this works on any size, e.g. 12 pegs of 12 colours, and reports
+  the guesses per game and the time per move. With -E as well, the games
+  are against the adversarial host in mmEvil.c, which keeps every secret
+  alive that it can; it also reports the time the host takes per move.
+  -S picks how the guess is chosen: the first consistent one (first), or
+  the one leaving the fewest secrets expected, from the partition of the
+  secrets left (mmPart.c): scored over all of them (exact, for modest sizes)
+  or over an adaptive random sample (sampled, for any size)
+
+$ ./mmsolve -p 1000 -g 12x12
+$ ./mmsolve -p 1000 -E -g 4x6
+$ ./mmsolve -p 1000 -S sampled -g 4x6
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <unistd.h>
+#include <time.h>
+#include <pthread.h>
+
+#include "mmMatch.h"
+#include "mmGuess.h"
+#include "mmHist.h"
+#include "mmEvil.h"
+#include "mmPart.h"
+#include "mmScore.h"
+
+#define SOLVE_THREADS  64
+// largest set searched for
+#define SOLVE_MAX      16
+// time budget of the search for a set smaller than the greedy one, in s (-b; 0 for none)
+#define SOLVE_BUDGET   60
+// feedback of all pairs of codes is precomputed up to this many codes
+#define TABLE_CODES    4096
+// most codes searched (all are kept in memory)
+#define SOLVE_CODES    (1 << 20)
+// position permutations enumerated to break symmetries of the second guess
+#define PERM_MAX       40320
+
+static int ncodes, nfb;		// codes, and feedback values
+static int *codes;		// all codes, seqlen ints each
+static unsigned char *table;	// feedback of code i to guess j; NULL if too big
+static matchFn match;
+
+static int *firsts, nfirsts;	// canonical first guesses
+
+struct pair
+{
+  int g1, g2;			// g2 is -1 for g1 on its own
+  int largest, classes;		// after both
+} ;
+
+static struct pair *pairs;	// first and second guesses, for the threads, best first
+static int npairs;
+
+/* real time: the solver only times its own work, never on a virtual clock */
+static uint64_t nowNs(void)
+{
+  struct timespec ts;
+
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+static int feedback(int i, int j)
+{
+  int code;
+
+  if (table != NULL)
+    return table[(size_t)i * ncodes + j];
+  code = match(codes + (size_t)i * seqlen, codes + (size_t)j * seqlen);
+  return MATCH_EXACT(code) * (seqlen + 1) + MATCH_APPROX(code);
+}
+
+static int codeIndex(const int *seq)
+{
+  int i, idx = 0;
+
+  for (i = 0; i < seqlen; i++)
+    idx = idx * colors + seq[i] - 1;
+  return idx;
+}
+
+static void printCode(FILE *out, int idx)
+{
+  int i;
+
+  for (i = 0; i < seqlen; i++)
+    fputc(pegChar(codes[(size_t)idx * seqlen + i]), out);
+}
+
+// +++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+// Symmetries
+
+/* canonical first guesses: blocks of one colour each, of non-increasing */
+/* size, with colours 1, 2, ... (one per partition of seqlen)             */
+static void firstGuesses(int *seq, int pos, int colour, int maxBlock)
+{
+  int b, i;
+
+  if (pos == seqlen) {
+    firsts[nfirsts++] = codeIndex(seq);
+    return;
+  }
+  if (colour > colors)
+    return;
+  for (b = (maxBlock < seqlen - pos ? maxBlock : seqlen - pos); b >= 1; b--) {
+    for (i = 0; i < b; i++)
+      seq[pos + i] = colour;
+    firstGuesses(seq, pos + b, colour + 1, b);
+  }
+}
+
+/* the least image of @g2@ under the symmetries that keep @g1@: position  */
+/* permutations @perms@, with the colours of g1 renamed to match, and the */
+/* other colours renamed to the least ones free, in order of appearance   */
+static int leastImage(const int *g1, const int *g2, const int *perms, int nperms)
+{
+  int rename[COLS_MAX + 1], used[COLS_MAX + 1], img[SEQL_MAX];
+  int p, i, c, next, idx, best = ncodes;
+  const int *perm;
+
+  for (p = 0; p < nperms; p++) {
+    perm = perms + (size_t)p * seqlen;
+    memset(rename, 0, sizeof(rename));
+    memset(used, 0, sizeof(used));
+    for (i = 0; i < seqlen; i++) {	// colours of g1 at perm[i] must become g1[i]
+      c = g1[perm[i]];
+      if ((rename[c] != 0 && rename[c] != g1[i]) || (used[g1[i]] && rename[c] != g1[i]))
+	break;
+      rename[c] = g1[i];
+      used[g1[i]] = 1;
+    }
+    if (i < seqlen)
+      continue;
+    for (next = 1, i = 0; i < seqlen; i++) {
+      c = g2[perm[i]];
+      if (rename[c] == 0) {
+	while (used[next])
+	  next++;
+	rename[c] = next;
+	used[next] = 1;
+      }
+      img[i] = rename[c];
+    }
+    if ((idx = codeIndex(img)) < best)
+      best = idx;
+  }
+  return best;
+}
+
+/* all permutations of 0..seqlen-1, or NULL if there are too many */
+static int *positionPerms(int *nperms)
+{
+  int *perms, perm[SEQL_MAX], i, j, k, t, n;
+
+  for (n = 1, i = 2; i <= seqlen; i++)
+    if ((n *= i) > PERM_MAX)
+      return NULL;
+  if ((perms = (int *)malloc((size_t)n * seqlen * sizeof(int))) == NULL)
+    return NULL;
+  for (i = 0; i < seqlen; i++)
+    perm[i] = i;
+  for (*nperms = 0; ; ) {	// in lexicographic order
+    memcpy(perms + (size_t)(*nperms)++ * seqlen, perm, seqlen * sizeof(int));
+    for (i = seqlen - 2; i >= 0 && perm[i] > perm[i + 1]; i--)
+      ;
+    if (i < 0)
+      break;
+    for (j = seqlen - 1; perm[j] < perm[i]; j--)
+      ;
+    t = perm[i]; perm[i] = perm[j]; perm[j] = t;
+    for (j = i + 1, k = seqlen - 1; j < k; j++, k--) {
+      t = perm[j]; perm[j] = perm[k]; perm[k] = t;
+    }
+  }
+  return perms;
+}
+
+// +++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+// Search
+
+struct solver
+{
+  int k;			// size of the set searched for
+  uint64_t *limit;		// largest class allowed with r guesses left: F^r
+  uint64_t next;		// next pair of first guesses
+  int found;			// set once a solution is found
+  uint64_t deadline;		// end of the time budget (nowNs); 0 for none
+  int timeout;			// set once the budget is spent
+  int set[SOLVE_MAX];		// the solution
+  uint64_t nodes;
+  pthread_mutex_t lock;
+} ;
+
+struct candidate
+{
+  int largest, classes, g;
+} ;
+
+struct member
+{
+  uint64_t sig;
+  int code;
+} ;
+
+struct worker
+{
+  struct solver *s;
+  uint64_t *sig[SOLVE_MAX + 1];	// signatures after each guess
+  uint64_t *keys;		// hash table of signatures
+  uint32_t *stamp, gen;		// entries are empty unless stamped with gen
+  uint16_t *count;
+  uint32_t mask;
+  int classes;			// number of classes after the last addGuess
+  struct candidate *cand[SOLVE_MAX];	// candidates for each guess, best first
+  struct member *members;	// codes in classes of two or more, for the last guess
+  int *classEnd;
+  int set[SOLVE_MAX];
+  uint64_t nodes;
+} ;
+
+
+static uint64_t mix(uint64_t h, int fb)
+{
+  h ^= (uint64_t)(fb + 1) * 0x9E3779B97F4A7C15ULL;
+  h ^= h >> 31;
+  h *= 0xBF58476D1CE4E5B9ULL;
+  return h ^ (h >> 29);
+}
+
+/* add guess @g@ to the signatures of level @d@, giving level @d+1@; returns */
+/* the largest class, or 0 as soon as one has more than @limit@ codes        */
+static int addGuess(struct worker *w, int d, int g, uint64_t limit)
+{
+  const uint64_t *sig = w->sig[d];
+  uint64_t *out = w->sig[d + 1], h;
+  uint32_t slot;
+  int c, largest = 1;
+
+  w->nodes++;
+  w->classes = 0;
+  if (++w->gen == 0) {		// stamps wrapped around
+    memset(w->stamp, 0, (size_t)(w->mask + 1) * sizeof(uint32_t));
+    w->gen = 1;
+  }
+  for (c = 0; c < ncodes; c++) {
+    out[c] = h = mix(sig[c], feedback(c, g));
+    for (slot = (uint32_t)(h >> 32) & w->mask; w->stamp[slot] == w->gen && w->keys[slot] != h;
+	 slot = (slot + 1) & w->mask)
+      ;
+    if (w->stamp[slot] != w->gen) {
+      w->stamp[slot] = w->gen;
+      w->keys[slot] = h;
+      w->count[slot] = 1;
+      w->classes++;
+    } else if (++w->count[slot] > largest) {
+      if ((uint64_t)(largest = w->count[slot]) > limit)
+	return 0;
+    }
+  }
+  return largest;
+}
+
+/* stop searching: a solution found, or the time budget spent */
+static int stopped(struct solver *s)
+{
+  if (__atomic_load_n(&s->found, __ATOMIC_RELAXED) || __atomic_load_n(&s->timeout, __ATOMIC_RELAXED))
+    return 1;
+  if (s->deadline != 0 && nowNs() > s->deadline) {
+    __atomic_store_n(&s->timeout, 1, __ATOMIC_RELAXED);
+    return 1;
+  }
+  return 0;
+}
+
+static int solved(struct worker *w, int d)
+{
+  struct solver *s = w->s;
+
+  pthread_mutex_lock(&s->lock);
+  if (!s->found) {
+    s->found = d;
+    memcpy(s->set, w->set, d * sizeof(int));
+  }
+  pthread_mutex_unlock(&s->lock);
+  return 1;
+}
+
+/* best first: the smallest largest class, then the most classes */
+static int cmpCandidate(const void *a, const void *b)
+{
+  const struct candidate *x = (const struct candidate *)a, *y = (const struct candidate *)b;
+
+  if (x->largest != y->largest)
+    return x->largest - y->largest;
+  if (x->classes != y->classes)
+    return y->classes - x->classes;
+  return x->g - y->g;
+}
+
+static int cmpPair(const void *a, const void *b)
+{
+  const struct pair *x = (const struct pair *)a, *y = (const struct pair *)b;
+
+  if (x->largest != y->largest)
+    return x->largest - y->largest;
+  return y->classes - x->classes;
+}
+
+static int cmpMember(const void *a, const void *b)
+{
+  const struct member *x = (const struct member *)a, *y = (const struct member *)b;
+
+  return (x->sig > y->sig) - (x->sig < y->sig);
+}
+
+/* choose the last guess @d@, from @from@ up: codes alone in their class stay */
+/* apart, so only the others are checked, a class at a time, with a bit per   */
+/* feedback value                                                             */
+static int lastGuess(struct worker *w, int d, int from)
+{
+  struct member *m = w->members;
+  const uint64_t *sig = w->sig[d];
+  uint64_t seen[4], bit;
+  int *end = w->classEnd, c, i, j, n, nclasses, g, fb;
+
+  if (stopped(w->s))
+    return 0;
+  for (c = 0; c < ncodes; c++) {
+    m[c].sig = sig[c];
+    m[c].code = c;
+  }
+  qsort(m, ncodes, sizeof(m[0]), cmpMember);
+  for (n = 0, nclasses = 0, i = 0; i < ncodes; i = j) {
+    for (j = i + 1; j < ncodes && m[j].sig == m[i].sig; j++)
+      ;
+    if (j - i < 2)
+      continue;
+    memmove(m + n, m + i, (size_t)(j - i) * sizeof(m[0]));
+    n += j - i;
+    end[nclasses++] = n;
+  }
+
+  for (g = from; g < ncodes; g++) {
+    if (g == w->set[0] || g == w->set[1])
+      continue;
+    w->nodes++;
+    for (c = 0, i = 0; c < nclasses; c++) {
+      memset(seen, 0, sizeof(seen));
+      for (; i < end[c]; i++) {
+	fb = feedback(m[i].code, g);
+	bit = 1ULL << (fb & 63);
+	if (seen[fb >> 6] & bit)
+	  break;
+	seen[fb >> 6] |= bit;
+      }
+      if (i < end[c])
+	break;
+    }
+    if (c == nclasses) {
+      w->set[d] = g;
+      return solved(w, d + 1);
+    }
+  }
+  return 0;
+}
+
+/* choose guess @d@ (from 0) of the set, from @from@ up; all candidates are */
+/* tried first, and the ones within the bound are searched best first       */
+static int search(struct worker *w, int d, int from)
+{
+  struct solver *s = w->s;
+  struct candidate *cand = w->cand[d];
+  int g, i, n = 0, largest;
+
+  for (g = from; g < ncodes; g++) {
+    if (g == w->set[0] || g == w->set[1])
+      continue;
+    if ((largest = addGuess(w, d, g, s->limit[s->k - d - 1])) == 0)
+      continue;
+    w->set[d] = g;
+    if (largest == 1)
+      return solved(w, d + 1);
+    cand[n].largest = largest;
+    cand[n].classes = w->classes;
+    cand[n++].g = g;
+  }
+  if (d + 1 == s->k)
+    return 0;
+  qsort(cand, n, sizeof(cand[0]), cmpCandidate);
+  for (i = 0; i < n && !stopped(s); i++) {
+    w->set[d] = cand[i].g;
+    addGuess(w, d, cand[i].g, ncodes);	// its signatures again
+    if (d + 2 == s->k ? lastGuess(w, d + 1, cand[i].g + 1) : search(w, d + 1, cand[i].g + 1))
+      return 1;
+  }
+  return 0;
+}
+
+static void *solveThread(void *arg)
+{
+  struct worker *w = (struct worker *)arg;
+  struct solver *s = w->s;
+  uint64_t p;
+  int largest;
+
+  while (!stopped(s) &&
+	 (p = __atomic_fetch_add(&s->next, 1, __ATOMIC_RELAXED)) < (uint64_t)npairs) {
+    w->set[0] = pairs[p].g1;
+    w->set[1] = -1;
+    if ((largest = addGuess(w, 0, w->set[0], s->limit[s->k - 1])) == 0)
+      continue;
+    if (largest == 1) {
+      solved(w, 1);
+      break;
+    }
+    if (s->k < 2 || pairs[p].g2 < 0)
+      continue;
+    w->set[1] = pairs[p].g2;
+    if ((largest = addGuess(w, 1, w->set[1], s->limit[s->k - 2])) == 0)
+      continue;
+    if (largest == 1) {
+      solved(w, 2);
+      break;
+    }
+    if (s->k > 2 && (s->k == 3 ? lastGuess(w, 2, 0) : search(w, 2, 0)))
+      break;
+  }
+  return NULL;
+}
+
+/* a set by adding, one at a time, the guess with the smallest largest class */
+/* (then the most classes) until every code is alone; its size, 0 if there is */
+/* none of up to SOLVE_MAX guesses. Only the first two levels of signatures   */
+/* are used, swapped after each guess                                         */
+static int greedySet(struct worker *w, int *set)
+{
+  struct candidate best, c;
+  uint64_t *tmp;
+  int k, g, j;
+
+  for (k = 0, best.largest = ncodes + 1; k < SOLVE_MAX && best.largest > 1; k++) {
+    best.largest = ncodes + 1;
+    best.classes = best.g = 0;
+    for (g = 0; g < ncodes; g++) {
+      for (j = 0; j < k && set[j] != g; j++)
+	;
+      if (j < k)
+	continue;
+      c.largest = addGuess(w, 0, g, ncodes);
+      c.classes = w->classes;
+      c.g = g;
+      if (cmpCandidate(&c, &best) < 0)
+	best = c;
+    }
+    set[k] = best.g;
+    addGuess(w, 0, best.g, ncodes);
+    tmp = w->sig[0];
+    w->sig[0] = w->sig[1];
+    w->sig[1] = tmp;
+  }
+  memset(w->sig[0], 0, (size_t)ncodes * sizeof(uint64_t));	// as the search expects
+  return best.largest == 1 ? k : 0;
+}
+
+/* every code has a distinct feedback vector to @set@? (exact check, no hashes) */
+static int checkSet(const int *set, int k)
+{
+  unsigned char *vec = (unsigned char *)malloc((size_t)ncodes * k);
+  int i, j, ok = 1;
+
+  if (vec == NULL)
+    return 0;
+  for (i = 0; i < ncodes; i++)
+    for (j = 0; j < k; j++)
+      vec[(size_t)i * k + j] = (unsigned char)feedback(i, set[j]);
+  for (i = 0; i < ncodes && ok; i++)
+    for (j = i + 1; j < ncodes && ok; j++)
+      ok = (memcmp(vec + (size_t)i * k, vec + (size_t)j * k, k) != 0);
+  free(vec);
+  return ok;
+}
+
+// +++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+// Games with the constraint solver (option -p)
+
+// search nodes per move before giving up and guessing at random
+#define PLAY_NODES 2000000
+
+// how the next guess is chosen (-S)
+enum { PLAY_FIRST, PLAY_EXACT, PLAY_SAMPLED };
+static const char *strategies[] = { "first", "exact", "sampled", NULL };
+
+static int randomPeg(uint64_t *rng)
+{
+  *rng ^= *rng << 13;
+  *rng ^= *rng >> 7;
+  *rng ^= *rng << 17;
+  return (int)(*rng % colors) + 1;
+}
+
+static int play(int games, uint64_t seed, int evil, int strategy, int verbose)
+{
+  struct mmGuesser g;
+  struct mmEvil host = { 0 };
+  struct mmPart part = { 0 };
+  struct mmHist moves, partitions;
+  int secret[SEQL_MAX], seq[SEQL_MAX], i, n, res, code, most = 0, errors = 0;
+  unsigned long guesses = 0, blind = 0, nodes = 0, restarts = 0, pool = 0, samples = 0;
+  uint64_t rng = seed << 1 | 1, t0 = nowNs();
+
+  histInit(&moves, "move");
+  histInit(&partitions, "host partition");
+  for (n = 0; n < games; n++) {
+    for (i = 0; i < seqlen; i++)
+      secret[i] = randomPeg(&rng);
+    if (evil && !evilInit(&host, seqlen, colors)) {
+      fprintf(stderr, "Too many codes for -E (at most %d), or out of memory\n", EVIL_CODES);
+      return 1;
+    }
+    if (strategy != PLAY_FIRST && !partInit(&part, seqlen, colors, strategy == PLAY_EXACT)) {
+      fprintf(stderr, "Too many codes for exact scoring (at most %d), or out of memory\n", PART_CODES);
+      return 1;
+    }
+    guessInit(&g, seqlen, colors, rng);
+    do {
+      uint64_t t = histNowNs();
+
+      res = (strategy == PLAY_FIRST ? guessNext(&g, seq, PLAY_NODES) : partNext(&part, &g, seq));
+      histSince(&moves, t);
+      nodes += g.nodes;
+      restarts += g.restarts;
+      pool += part.pool;
+      samples += part.samples;
+      if (res == 0) {		// the secret itself is always consistent
+	fprintf(stderr, "** game %d: no consistent guess after %d guesses\n", n, g.n);
+	errors++;
+	break;
+      }
+      if (res < 0) {
+	for (i = 0; i < seqlen; i++)
+	  seq[i] = randomPeg(&rng);
+	blind++;
+      }
+      if (evil) {
+	code = evilAnswer(&host, seq, secret);
+	histRecord(&partitions, host.ns);
+      } else
+	code = match(secret, seq);
+      guessAdd(&g, seq, code);
+      partAdd(&part, seq, code);
+    } while (MATCH_EXACT(code) != seqlen && g.n < GUESS_MAX);
+    if (res != 0 && MATCH_EXACT(code) != seqlen) {
+      fprintf(stderr, "** game %d: not solved in %d guesses\n", n, GUESS_MAX);
+      errors++;
+    }
+    guesses += g.n;
+    if (g.n > most)
+      most = g.n;
+  }
+
+  fprintf(stdout, "%dx%d, %s: %d games, %.2f guesses per game (at most %d), %.2f s\n",
+	  seqlen, colors, strategies[strategy], games, (double)guesses / games, most, (nowNs() - t0) / 1e9);
+  histPrint(&moves, stdout);
+  if (evil)
+    histPrint(&partitions, stdout);
+  if (verbose || blind > 0)
+    fprintf(stdout, "%.0f nodes and %.2f restarts per move, %lu random guesses\n",
+	    (double)nodes / guesses, (double)restarts / guesses, blind);
+  if (verbose && strategy != PLAY_FIRST)
+    fprintf(stdout, "%.1f guesses scored against %.1f secrets per move\n",
+	    (double)pool / guesses, (double)samples / guesses);
+  evilFree(&host);
+  partFree(&part);
+  return errors ? 1 : 0;
+}
+
+// +++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+
+int main(int argc, char **argv)
+{
+  struct solver s;
+  struct worker workers[SOLVE_THREADS];
+  pthread_t tids[SOLVE_THREADS];
+  uint64_t limit[SOLVE_MAX + 1], t0, tk;
+  const struct scorer *scoring;
+  double opt_b = SOLVE_BUDGET;
+  int gset[SOLVE_MAX], greedy;
+  int opt_l = SEQL, opt_k = COLS, opt_t = (int)sysconf(_SC_NPROCESSORS_ONLN), opt_m = SOLVE_MAX;
+  int verbose = 0, opt_p = 0, opt_E = 0, opt_s = 1701, opt_S = PLAY_FIRST, opt, i, j, k, v, nperms = 0, seq[SEQL_MAX], *perms;
+  size_t n;
+
+  while ((opt = getopt(argc, argv, "hvg:t:m:b:p:s:ES:")) != -1) {
+    switch (opt) {
+    case 'v':
+      verbose = 1;
+      break;
+    case 'g':
+      if (sscanf(optarg, "%dx%d", &opt_l, &opt_k) != 2)
+	opt_l = 0;
+      break;
+    case 't':
+      opt_t = atoi(optarg);
+      break;
+    case 'm':
+      opt_m = atoi(optarg);
+      break;
+    case 'b':
+      opt_b = atof(optarg);
+      break;
+    case 'p':
+      opt_p = atoi(optarg);
+      break;
+    case 's':
+      opt_s = atoi(optarg);
+      break;
+    case 'E':
+      opt_E = 1;
+      break;
+    case 'S':
+      for (opt_S = 0; strategies[opt_S] != NULL && strcmp(strategies[opt_S], optarg) != 0; opt_S++)
+	;
+      break;
+    default: /* '?' */
+      fprintf(stderr, "Usage: %s [-h] [-v] [-g <length>x<colours>] [-t <threads>] [-m <largest set>] [-b <seconds>]\n", argv[0]);
+      fprintf(stderr, "       %s -p <games> [-E] [-S first|exact|sampled] [-v] [-g <length>x<colours>] [-s <seed>]\n", argv[0]);
+      exit(opt == 'h' ? EXIT_SUCCESS : EXIT_FAILURE);
+    }
+  }
+  if (!matchSetSize(opt_l, opt_k)) {
+    fprintf(stderr, "Size must be <length>x<colours>, at most %dx%d\n", SEQL_MAX, COLS_MAX);
+    exit(EXIT_FAILURE);
+  }
+  if (opt_t < 1)
+    opt_t = 1;
+  if (opt_t > SOLVE_THREADS)
+    opt_t = SOLVE_THREADS;
+  if (opt_m < 1 || opt_m > SOLVE_MAX)
+    opt_m = SOLVE_MAX;
+  if (strategies[opt_S] == NULL) {
+    fprintf(stderr, "-S must be first, exact or sampled\n");
+    exit(EXIT_FAILURE);
+  }
+  match = matcherBest()->fn;
+  scoring = scoreInit();
+  if (verbose || opt_E)
+    fprintf(stdout, "scoring: %s\n", scoring->name);
+
+  if (opt_p > 0)
+    exit(play(opt_p, (uint64_t)opt_s, opt_E, opt_S, verbose));
+
+  for (ncodes = 1, i = 0; i < seqlen; i++)
+    if ((ncodes *= colors) > SOLVE_CODES) {
+      fprintf(stderr, "More than %d codes; too many to search\n", SOLVE_CODES);
+      exit(EXIT_FAILURE);
+    }
+  // feedback values: exact and approximate matches adding up to at most
+  // seqlen, except seqlen-1 exact and 1 approximate
+  nfb = (seqlen + 1) * (seqlen + 2) / 2 - (seqlen > 1 ? 1 : 0);
+
+  // all codes, and the table of feedback
+  t0 = nowNs();
+  codes = (int *)malloc((size_t)ncodes * seqlen * sizeof(int));
+  firsts = (int *)malloc((size_t)ncodes * sizeof(int));
+  if (codes == NULL || firsts == NULL) {
+    fprintf(stderr, "Out of memory for %d codes\n", ncodes);
+    exit(EXIT_FAILURE);
+  }
+  for (i = 0; i < ncodes; i++)
+    for (v = i, j = seqlen - 1; j >= 0; j--, v /= colors)
+      codes[(size_t)i * seqlen + j] = v % colors + 1;
+  if (ncodes <= TABLE_CODES && (table = (unsigned char *)malloc((size_t)ncodes * ncodes)) != NULL)
+    for (i = 0; i < ncodes; i++)
+      for (j = 0; j < ncodes; j++) {
+	v = match(codes + (size_t)i * seqlen, codes + (size_t)j * seqlen);
+	table[(size_t)i * ncodes + j] = (unsigned char)(MATCH_EXACT(v) * (seqlen + 1) + MATCH_APPROX(v));
+      }
+
+  // first guesses, and the second ones that are the least of their orbit
+  firstGuesses(seq, 0, 1, seqlen);
+  perms = positionPerms(&nperms);
+  pairs = (struct pair *)malloc((size_t)nfirsts * ncodes * sizeof(pairs[0]));
+  if (pairs == NULL) {
+    fprintf(stderr, "Out of memory for the first guesses\n");
+    exit(EXIT_FAILURE);
+  }
+  for (i = 0; i < nfirsts; i++) {
+    const int *g1 = codes + (size_t)firsts[i] * seqlen;
+
+    pairs[npairs].g1 = firsts[i];	// the first guess on its own
+    pairs[npairs++].g2 = -1;
+    for (j = 0; j < ncodes; j++)
+      if (j != firsts[i] &&
+	  (perms == NULL || leastImage(g1, codes + (size_t)j * seqlen, perms, nperms) == j)) {
+	pairs[npairs].g1 = firsts[i];
+	pairs[npairs++].g2 = j;
+      }
+  }
+  if (verbose)
+    fprintf(stderr, "%d codes, %d feedback values, %d first guesses, %d pairs of first guesses, %.2f s set-up\n",
+	    ncodes, nfb, nfirsts, npairs - nfirsts, (nowNs() - t0) / 1e9);
+
+  // per thread: signatures for each level, and a hash table of twice the codes
+  for (n = 1; n < 2 * (size_t)ncodes; n *= 2)
+    ;
+  for (i = 0; i < opt_t; i++) {
+    memset(&workers[i], 0, sizeof(workers[i]));
+    workers[i].s = &s;
+    workers[i].mask = (uint32_t)(n - 1);
+    workers[i].keys = (uint64_t *)malloc(n * sizeof(uint64_t));
+    workers[i].stamp = (uint32_t *)calloc(n, sizeof(uint32_t));
+    workers[i].count = (uint16_t *)malloc(n * sizeof(uint16_t));
+    workers[i].members = (struct member *)malloc((size_t)ncodes * sizeof(struct member));
+    workers[i].classEnd = (int *)malloc((size_t)ncodes * sizeof(int));
+    for (j = 0; j <= opt_m; j++)
+      if ((workers[i].sig[j] = (uint64_t *)calloc((size_t)ncodes, sizeof(uint64_t))) == NULL ||
+	  (j < opt_m && (workers[i].cand[j] = (struct candidate *)malloc((size_t)ncodes * sizeof(struct candidate))) == NULL))
+	break;
+    if (j <= opt_m || workers[i].keys == NULL || workers[i].stamp == NULL || workers[i].count == NULL ||
+	workers[i].members == NULL || workers[i].classEnd == NULL) {
+      fprintf(stderr, "Out of memory for thread %d\n", i);
+      exit(EXIT_FAILURE);
+    }
+  }
+
+  // pairs best first, as the threads take them in order
+  for (i = 0; i < npairs; i++) {
+    pairs[i].largest = addGuess(&workers[0], 0, pairs[i].g1, ncodes);
+    pairs[i].classes = workers[0].classes;
+    if (pairs[i].g2 >= 0) {
+      pairs[i].largest = addGuess(&workers[0], 1, pairs[i].g2, ncodes);
+      pairs[i].classes = workers[0].classes;
+    }
+  }
+  qsort(pairs, npairs, sizeof(pairs[0]), cmpPair);
+  workers[0].nodes = 0;
+
+  // an upper bound: the greedy set
+  t0 = nowNs();
+  if ((greedy = greedySet(&workers[0], gset)) == 0 || !checkSet(gset, greedy)) {
+    fprintf(stdout, "%dx%d: no greedy set of up to %d guesses\n", seqlen, colors, SOLVE_MAX);
+    exit(EXIT_FAILURE);
+  }
+  fprintf(stdout, "%dx%d: %d guesses (greedy):", seqlen, colors, greedy);
+  for (i = 0; i < greedy; i++) {
+    fputc(' ', stdout);
+    printCode(stdout, gset[i]);
+  }
+  fprintf(stdout, " (%.2f s)\n", (nowNs() - t0) / 1e9);
+  workers[0].nodes = 0;
+
+  // iterative deepening, from the least k with F^k >= codes, for a smaller set
+  for (limit[0] = 1, i = 1; i <= SOLVE_MAX; i++)
+    limit[i] = (limit[i - 1] > (uint64_t)ncodes ? limit[i - 1] : limit[i - 1] * nfb);
+  for (k = 1; k < opt_m && limit[k] < (uint64_t)ncodes; k++)
+    ;
+  if (opt_m > greedy - 1)
+    opt_m = greedy - 1;
+  memset(&s, 0, sizeof(s));
+  s.limit = limit;
+  pthread_mutex_init(&s.lock, NULL);
+  t0 = nowNs();
+  s.deadline = (opt_b > 0 ? t0 + (uint64_t)(opt_b * 1e9) : 0);
+  for (; k <= opt_m && !s.found && !s.timeout; k++) {
+    tk = nowNs();
+    s.k = k;
+    s.next = 0;
+    for (i = 0; i < opt_t; i++)
+      if (pthread_create(&tids[i], NULL, solveThread, &workers[i]) != 0) {
+	fprintf(stderr, "Cannot create thread %d\n", i);
+	exit(EXIT_FAILURE);
+      }
+    for (s.nodes = 0, i = 0; i < opt_t; i++) {
+      pthread_join(tids[i], NULL);
+      s.nodes += workers[i].nodes;
+      workers[i].nodes = 0;
+    }
+    if (verbose)
+      fprintf(stderr, "%d guesses: %s, %llu nodes, %.2f s\n", k,
+	      (s.found ? "found" : s.timeout ? "out of time" : "none"), (unsigned long long)s.nodes, (nowNs() - tk) / 1e9);
+  }
+
+  if (s.timeout) {
+    fprintf(stdout, "%dx%d: at most %d guesses; none of up to %d, the search for %d ran out of its %.0f s\n",
+	    seqlen, colors, greedy, k - 2, k - 1, opt_b);
+    exit(EXIT_SUCCESS);
+  }
+  if (!s.found) {
+    if (opt_m == greedy - 1)
+      fprintf(stdout, "%dx%d: %d guesses is the least: none of up to %d (%.2f s, %d threads)\n",
+	      seqlen, colors, greedy, opt_m, (nowNs() - t0) / 1e9, opt_t);
+    else
+      fprintf(stdout, "%dx%d: at most %d guesses; none of up to %d (%.2f s, %d threads)\n",
+	      seqlen, colors, greedy, opt_m, (nowNs() - t0) / 1e9, opt_t);
+    exit(EXIT_SUCCESS);
+  }
+  fprintf(stdout, "%dx%d: %d guesses:", seqlen, colors, s.found);
+  for (i = 0; i < s.found; i++) {
+    fputc(' ', stdout);
+    printCode(stdout, s.set[i]);
+  }
+  fprintf(stdout, " (%.2f s, %d threads)\n", (nowNs() - t0) / 1e9, opt_t);
+  if (!checkSet(s.set, s.found)) {	// a collision of the hashes
+    fprintf(stdout, "** the set does NOT tell all codes apart\n");
+    exit(EXIT_FAILURE);
+  }
+  pthread_mutex_destroy(&s.lock);
+  return 0;
+}
@@ -115,6 +115,30 @@ EOS
 )
 check
 
+# the same cases, and more, checked in one run from a file of test cases
+cmd="./${cw} -u -"
+out="`$cmd <<EOS
+# secret guess exact approx
+123 321 1 2
+121 313 0 1
+132 321 0 3
+123 112 1 1
+112 233 0 1
+111 333 0 0
+331 223 0 1
+331 232 1 0
+232 331 1 0
+312 312 3 0
+111 111 3 0
+123 231 0 3
+122 221 1 2
+EOS`"
+exp=$(cat <<EOS
+13 of 13 cases are OK
+EOS
+)
+check
+
 # return status code (0 for ok, 1 for not)
 echo "$ok of $n tests are OK"
 exit $ret
@@ -3,8 +3,23 @@
 
 $ as  -o mm-matches.o mm-matches.s
 $ gcc -c -o testm.o testm.c
-$ gcc -o testm testm.o matches.o
+$ gcc -c -o mmMatch.o mmMatch.c
+$ gcc -o testm testm.o mmMatch.o mm-matches.o -lm
 $ ./testm
+
+and to benchmark all matchers, with CSV output:
+$ ./testm -b -c
+
+and to check all matchers on every pair of sequences, on all cores:
+$ ./testm -e
+
+Both work on other sizes of the game, e.g. 4 pegs of 6 colours, with -g 4x6;
+only the matchers handling that size are run.
+
+and to benchmark the batch scorers (scalar, and SSE2, AVX2, AVX-512 on
+x86-64) scoring one guess against many codes, checking them against the C
+matcher first:
+$ ./testm -k -g 4x6
 */
 
 #include <stdio.h>
@@ -12,65 +27,528 @@ $ ./testm
 #include <stdint.h>
 #include <string.h>
 #include <unistd.h>
+#include <time.h>
+#include <math.h>
+#include <pthread.h>
+
+#include "mmMatch.h"
+#include "mmScore.h"
+
+// +++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+// Benchmark of all matchers (option -b)
+// Every matcher runs over the same pre-generated pairs, after warm-up rounds;
+// each repeat times all pairs with CLOCK_MONOTONIC_RAW and yields ns per call.
+// Inputs:
+//   same   ... one pair over and over: cache-hot, perfectly predictable branches
+//   hot    ... HOT_PAIRS random pairs, cycled: cache-hot, hard to predict
+//   random ... all pairs random, read in order: unpredictable branches
+//   cold   ... random pairs, one per cache line, read in random order from a
+//              buffer much larger than the caches: cache and TLB misses
+
+#define BENCH_PAIRS   (1 << 20)
+#define BENCH_REPEATS 11
+#define BENCH_WARMUP  2
+#define HOT_PAIRS     256
+// ints per pair in the cold buffer: one 64-byte cache line
+#define COLD_STRIDE   16
+
+static const char *benchInputs[] = { "same", "hot", "random", "cold", NULL };
+
+static uint64_t nowNs(void)
+{
+  struct timespec ts;
+
+  clock_gettime(CLOCK_MONOTONIC_RAW, &ts);
+  return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+/* the loop overhead on its own: reads the pair, but does no matching */
+static int noMatch(int *seq1, int *seq2)
+{
+  return seq1[0] + seq2[0];
+}
+
+static void randomPair(int *pair)
+{
+  int j;
+
+  for (j = 0; j < 2 * seqlen; j++)
+    pair[j] = rand() % colors + 1;
+}
+
+/* fill @ptrs@ with @n@ pointers to pairs (secret followed by guess) for the given input kind */
+static int *benchData(const char *kind, int **ptrs, int n)
+{
+  int *buf, i, j, k;
+
+  if (strcmp(kind, "cold") == 0) {
+    buf = (int*)malloc((size_t)n * COLD_STRIDE * sizeof(int));
+    if (buf == NULL)
+      return NULL;
+    for (i = 0; i < n; i++) {
+      randomPair(buf + (size_t)i * COLD_STRIDE);
+      ptrs[i] = buf + (size_t)i * COLD_STRIDE;
+    }
+    for (i = n - 1; i > 0; i--) {	// shuffle the visiting order
+      j = rand() % (i + 1);
+      int *tmp = ptrs[i]; ptrs[i] = ptrs[j]; ptrs[j] = tmp;
+    }
+    return buf;
+  }
+
+  k = (strcmp(kind, "same") == 0 ? 1 : strcmp(kind, "hot") == 0 ? HOT_PAIRS : n);
+  buf = (int*)malloc((size_t)k * 2 * seqlen * sizeof(int));
+  if (buf == NULL)
+    return NULL;
+  for (i = 0; i < k; i++)
+    randomPair(buf + (size_t)i * 2 * seqlen);
+  for (i = 0; i < n; i++)
+    ptrs[i] = buf + (size_t)(i % k) * 2 * seqlen;
+  return buf;
+}
+
+/* one pass over all pairs; returns the sum of the results, to check them and */
+/* to keep the compiler from dropping the calls                               */
+static long benchPass(matchFn fn, int **ptrs, int n)
+{
+  long sum = 0;
+  int i;
+
+  for (i = 0; i < n; i++)
+    sum += fn(ptrs[i], ptrs[i] + seqlen);
+  return sum;
+}
+
+static int cmpDouble(const void *a, const void *b)
+{
+  double x = *(const double *)a, y = *(const double *)b;
+
+  return (x > y) - (x < y);
+}
+
+static int benchmark(int n, int repeats, int warmup, const char *only, int csv)
+{
+  struct matcher baseline = { "baseline", noMatch, 0, 0 };
+  const struct matcher *m;
+  const char **kind;
+  double t[repeats], median, mean, var;
+  long ref, sum;
+  int **ptrs, *buf, i, r, errors = 0;
+  uint64_t t0;
+
+  ptrs = (int**)malloc((size_t)n * sizeof(int*));
+  if (ptrs == NULL) {
+    fprintf(stderr, "Out of memory for %d pairs\n", n);
+    return 1;
+  }
+
+  if (csv)
+    fprintf(stdout, "matcher,size,input,pairs,repeats,median_ns,min_ns,stddev_ns\n");
+  else
+    fprintf(stdout, "%-10s %-6s %-7s %12s %10s %10s\n", "matcher", "size", "input", "median ns", "min ns", "stddev");
+
+  for (kind = benchInputs; *kind != NULL; kind++) {
+    if (only != NULL && strcmp(only, *kind) != 0)
+      continue;
+    if ((buf = benchData(*kind, ptrs, n)) == NULL) {
+      fprintf(stderr, "Out of memory for %s input\n", *kind);
+      free(ptrs);
+      return 1;
+    }
+    ref = benchPass(countMatches, ptrs, n);
+
+    for (i = -1; (m = (i < 0 ? &baseline : &matchers[i]))->name != NULL; i++) {
+      if (!matcherFits(m))
+	continue;
+      for (r = 0; r < warmup; r++)
+	sum = benchPass(m->fn, ptrs, n);
+      for (r = 0; r < repeats; r++) {
+	t0 = nowNs();
+	sum = benchPass(m->fn, ptrs, n);
+	t[r] = (double)(nowNs() - t0) / n;
+      }
+      if (m != &baseline && sum != ref) {
+	fprintf(stderr, "** %s gives different results than c on %s input\n", m->name, *kind);
+	errors++;
+      }
+
+      for (mean = 0, r = 0; r < repeats; r++)
+	mean += t[r] / repeats;
+      for (var = 0, r = 0; r < repeats; r++)
+	var += (t[r] - mean) * (t[r] - mean) / repeats;
+      qsort(t, repeats, sizeof(double), cmpDouble);
+      median = (repeats % 2 ? t[repeats / 2] : (t[repeats / 2 - 1] + t[repeats / 2]) / 2);
+
+      if (csv)
+	fprintf(stdout, "%s,%dx%d,%s,%d,%d,%.3f,%.3f,%.3f\n", m->name, seqlen, colors, *kind, n, repeats, median, t[0], sqrt(var));
+      else
+	fprintf(stdout, "%-10s %2dx%-3d %-7s %12.2f %10.2f %10.2f\n", m->name, seqlen, colors, *kind, median, t[0], sqrt(var));
+    }
+    free(buf);
+  }
+
+  free(ptrs);
+  return errors ? 1 : 0;
+}
+
+// +++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+// Benchmark of the batch scorers (option -k)
+// All scorers available on this CPU score the same KERNEL_GUESSES guesses
+// against the same random codes, stored by peg (see mmScore.h); the results
+// are checked against countMatches first. Times are ns per code scored.
+
+#define KERNEL_CODES   (1 << 16)
+#define KERNEL_GUESSES 64
+
+static int kernels(int n, int repeats, int warmup, int csv)
+{
+  const struct scorer *sc;
+  double t[repeats], median, scalar = 0;
+  int *codes, guesses[KERNEL_GUESSES][SEQL_MAX], i, j, g, r, errors = 0;
+  uint8_t *pegs;
+  uint16_t *out;
+  uint64_t t0;
+
+  codes = (int*)malloc((size_t)n * seqlen * sizeof(int));
+  pegs = (uint8_t*)malloc((size_t)n * seqlen);
+  out = (uint16_t*)malloc((size_t)n * sizeof(uint16_t));
+  if (codes == NULL || pegs == NULL || out == NULL) {
+    fprintf(stderr, "Out of memory for %d codes\n", n);
+    return 1;
+  }
+  for (i = 0; i < n; i++)
+    for (j = 0; j < seqlen; j++)
+      pegs[(size_t)j * n + i] = (uint8_t)(codes[(size_t)i * seqlen + j] = rand() % colors + 1);
+  for (g = 0; g < KERNEL_GUESSES; g++)
+    for (j = 0; j < seqlen; j++)
+      guesses[g][j] = rand() % colors + 1;
+
+  if (csv)
+    fprintf(stdout, "scorer,size,codes,guesses,repeats,median_ns,min_ns,speedup\n");
+  else
+    fprintf(stdout, "%-10s %-6s %12s %10s %8s   (selected: %s)\n", "scorer", "size", "median ns", "min ns", "speedup", scoreInit()->name);
+
+  for (sc = scorers; sc->name != NULL; sc++) {
+    if (!scoreAvailable(sc)) {
+      if (!csv)
+	fprintf(stdout, "%-10s %2dx%-3d    not available on this CPU\n", sc->name, seqlen, colors);
+      continue;
+    }
+    for (g = 0; g < KERNEL_GUESSES; g++) {
+      sc->fn(pegs, n, n, guesses[g], out);
+      for (i = 0; i < n; i++)
+	if (out[i] != countMatches(codes + (size_t)i * seqlen, guesses[g])) {
+	  fprintf(stderr, "** %s gives different results than c, code %d guess %d\n", sc->name, i, g);
+	  errors++;
+	  break;
+	}
+    }
+    for (r = -warmup; r < repeats; r++) {
+      t0 = nowNs();
+      for (g = 0; g < KERNEL_GUESSES; g++)
+	sc->fn(pegs, n, n, guesses[g], out);
+      if (r >= 0)
+	t[r] = (double)(nowNs() - t0) / ((double)n * KERNEL_GUESSES);
+    }
+    qsort(t, repeats, sizeof(double), cmpDouble);
+    median = (repeats % 2 ? t[repeats / 2] : (t[repeats / 2 - 1] + t[repeats / 2]) / 2);
+    if (sc == scorers)
+      scalar = median;
+
+    if (csv)
+      fprintf(stdout, "%s,%dx%d,%d,%d,%d,%.4f,%.4f,%.2f\n", sc->name, seqlen, colors, n, KERNEL_GUESSES, repeats, median, t[0], scalar / median);
+    else
+      fprintf(stdout, "%-10s %2dx%-3d %12.3f %10.3f %7.1fx\n", sc->name, seqlen, colors, median, t[0], scalar / median);
+  }
 
-#define LENGTH 3
-#define COLORS 3
+  free(codes);
+  free(pegs);
+  free(out);
+  return errors ? 1 : 0;
+}
+
+// +++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+// Differential verifier (option -e)
+// Checks every matcher against a reference implementation, on all pairs of
+// secret and guess (or on random pairs, if there are more than VERIFY_MAX or
+// if -n is given). The reference is worked out once per pair, and all matchers
+// fitting the size are checked against it in the same pass. Secrets are handed
+// out to the threads one at a time; the mismatch reported for a matcher is its
+// first one in enumeration order.
+// Matching only compares colours, so relabelling the colours of both sequences
+// keeps the result. All pairs are therefore covered by the canonical secrets,
+// whose colours first occur in the order 1, 2, 3, ..., against all guesses: a
+// secret of k distinct colours stands for colors!/(colors-k)! secrets. For 6x6
+// that is 203 secrets instead of 46656. Random pairs (-n) use any secret.
 
-#define NAN1 8
-#define NAN2 9
+#define VERIFY_MAX     (1ULL << 33)
+#define VERIFY_THREADS 64
+// all sequences are kept in memory: at most this many
+#define VERIFY_SEQS    (1 << 24)
+// most matchers checked in one pass
+#define VERIFY_MATCHERS 16
 
-const int seqlen = LENGTH;
-const int seqmax = COLORS;
+struct verifyJob
+{
+  int nm;			// matchers checked
+  const struct matcher *m[VERIFY_MATCHERS];
+  int nseq;			// number of sequences, colors^seqlen
+  int *seqs;			// all sequences, seqlen ints each
+  int nsec;			// number of canonical secrets
+  int *secrets;			// their sequence numbers
+  uint64_t samples;		// 0 for exhaustive
+  uint64_t next;		// next secret (exhaustive) or block of samples
+  uint64_t first[VERIFY_MATCHERS];	// per matcher: index of its first mismatch; ~0 if none
+  int got[VERIFY_MATCHERS];
+  pthread_mutex_t lock;
+} ;
 
-/* ********************************** */
-/* take these fcts from master-mind.c */
-/* ********************************** */
+#define SAMPLE_BLOCK 65536
 
-/* Show given sequence */
-void showSeq(int *seq);
+/* a secret, by colour: where each colour occurs in it */
+struct secretPegs
+{
+  const int *seq;
+  int n[COLS_MAX + 1];
+  int pos[COLS_MAX + 1][SEQL_MAX];
+};
 
-/* Parse an integer value as a list of digits of base MAX */
-void readSeq(int *seq, int val);
+static void secretPegs(struct secretPegs *sp, const int *seq)
+{
+  int i;
 
-/* display the sequence on the terminal window, using the format from the sample run in the spec */
-void showSeq(int *seq) ;
+  sp->seq = seq;
+  for (i = 1; i <= colors; i++)
+    sp->n[i] = 0;
+  for (i = 0; i < seqlen; i++)
+    sp->pos[seq[i]][sp->n[seq[i]]++] = i;
+}
 
+/* the reference: a different algorithm from the matchers counting colours */
+/* (matchCounts): mark the exact pegs of the secret, then mark, for each    */
+/* other peg of the guess, the first unmarked peg of its colour             */
+static int refMatches(const struct secretPegs *sp, const int *b)
+{
+  int marked[SEQL_MAX], i, k, c, exact = 0, approx = 0;
 
-#define NAN1 8
-#define NAN2 9
+  for (i = 0; i < seqlen; i++)
+    exact += (marked[i] = (sp->seq[i] == b[i]));
+  for (i = 0; i < seqlen; i++) {
+    if (sp->seq[i] == b[i])
+      continue;
+    for (c = b[i], k = 0; k < sp->n[c]; k++)
+      if (!marked[sp->pos[c][k]]) {
+	marked[sp->pos[c][k]] = 1;
+	approx++;
+	break;
+      }
+  }
+  return MATCH_CODE(exact, approx);
+}
 
-/* counts how many entries in seq2 match entries in seq1 */
-/* returns exact and approximate matches, either both encoded in one value, */
-/* or as a pointer to a pair of values */
-int /* or int* */ countMatches(int *seq1, int *seq2) ;
+/* the matchers still to check from @index@ on: those without an earlier mismatch */
+static unsigned liveMatchers(struct verifyJob *job, uint64_t index)
+{
+  unsigned live = 0;
+  int k;
 
-/* show the results from calling countMatches on seq1 and seq1 */
-void showMatches(int /* or int* */ code, /* only for debugging */ int *seq1, int *seq2, /* optional, to control layout */ int lcd_format);
+  for (k = 0; k < job->nm; k++)
+    if (__atomic_load_n(&job->first[k], __ATOMIC_RELAXED) > index)
+      live |= 1u << k;
+  return live;
+}
 
-/* parse an integer value as a list of digits, and put them into @seq@ */
-/* needed for processing command-line with options -s or -u            */
-void readSeq(int *seq, int val) ;
+/* check one pair against the @live@ matchers; returns those still live */
+static unsigned verifyPair(struct verifyJob *job, const struct secretPegs *sp, int g, uint64_t index, unsigned live)
+{
+  int *a = (int *)sp->seq, *b = job->seqs + (size_t)g * seqlen;
+  int expected = refMatches(sp, b), got, k;
 
-/* read a guess sequence fron stdin and store the values in arr */
-/* only needed for testing the game logic, without button input */
-int readNum(int max); 
+  for (k = 0; k < job->nm; k++) {
+    if (!(live & (1u << k)) || (got = job->m[k]->fn(a, b)) == expected)
+      continue;
+    pthread_mutex_lock(&job->lock);
+    if (index < job->first[k]) {
+      job->first[k] = index;
+      job->got[k] = got;
+    }
+    pthread_mutex_unlock(&job->lock);
+    live &= ~(1u << k);
+  }
+  return live;
+}
 
-// The ARM assembler version of the matching fct
-extern int /* or int* */ matches(int *val1, int *val2);
+static void *verifyThread(void *arg)
+{
+  struct verifyJob *job = (struct verifyJob *)arg;
+  struct secretPegs sp;
+  uint64_t blocks = (job->samples + SAMPLE_BLOCK - 1) / SAMPLE_BLOCK;
+  uint64_t b, rnd, i;
+  unsigned live;
+  int s, g;
+
+  for (;;) {
+    b = __atomic_fetch_add(&job->next, 1, __ATOMIC_RELAXED);
+    if (job->samples == 0) {	// exhaustive: all guesses for canonical secret b
+      if (b >= (uint64_t)job->nsec || (live = liveMatchers(job, b * job->nseq)) == 0)
+	break;
+      secretPegs(&sp, job->seqs + (size_t)job->secrets[b] * seqlen);
+      for (g = 0; g < job->nseq && live != 0; g++)
+	live = verifyPair(job, &sp, g, b * job->nseq + g, live);
+    } else {			// sampled: a block of random pairs, seeded by block number
+      if (b >= blocks || (live = liveMatchers(job, b * SAMPLE_BLOCK)) == 0)
+	break;
+      rnd = (b + 1) * 0x9E3779B97F4A7C15ULL;
+      for (i = b * SAMPLE_BLOCK; i < (b + 1) * SAMPLE_BLOCK && i < job->samples && live != 0; i++) {
+	rnd ^= rnd << 13; rnd ^= rnd >> 7; rnd ^= rnd << 17;	// xorshift64
+	s = (int)((rnd >> 32) % job->nseq);
+	g = (int)((rnd & 0xFFFFFFFF) % job->nseq);
+	secretPegs(&sp, job->seqs + (size_t)s * seqlen);
+	live = verifyPair(job, &sp, g, i, live);
+      }
+    }
+  }
+  return NULL;
+}
+
+static void printSeq(FILE *out, const int *seq)
+{
+  int i;
+
+  for (i = 0; i < seqlen; i++)
+    fputc(pegChar(seq[i]), out);
+}
+
+static int verify(int nthreads, uint64_t samples, int verbose)
+{
+  struct verifyJob job;
+  struct secretPegs sp;
+  pthread_t tids[VERIFY_THREADS];
+  const struct matcher *m;
+  uint64_t covered, orbit, t0;
+  int i, j, k, v, s, g, seen, expected, errors = 0;
+
+  for (job.nseq = 1, i = 0; i < seqlen; i++) {
+    if ((uint64_t)job.nseq * colors > VERIFY_SEQS) {
+      fprintf(stderr, "More than %d sequences of length %d; too many to verify\n", VERIFY_SEQS, seqlen);
+      return 1;
+    }
+    job.nseq *= colors;
+  }
+  if (nthreads < 1)
+    nthreads = 1;
+  if (nthreads > VERIFY_THREADS)
+    nthreads = VERIFY_THREADS;
+
+  job.seqs = (int*)malloc((size_t)job.nseq * seqlen * sizeof(int));
+  job.secrets = (int*)malloc((size_t)job.nseq * sizeof(int));
+  if (job.seqs == NULL || job.secrets == NULL) {
+    fprintf(stderr, "Out of memory for %d sequences\n", job.nseq);
+    return 1;
+  }
+  for (i = 0; i < job.nseq; i++)	// sequence i: the digits of i in base colors, plus 1
+    for (v = i, j = seqlen - 1; j >= 0; j--, v /= colors)
+      job.seqs[(size_t)i * seqlen + j] = v % colors + 1;
+
+  /* the canonical secrets, and the pairs they stand for */
+  for (job.nsec = 0, covered = 0, i = 0; i < job.nseq; i++) {
+    for (seen = 0, j = 0; j < seqlen && job.seqs[(size_t)i * seqlen + j] <= seen + 1; j++)
+      if (job.seqs[(size_t)i * seqlen + j] == seen + 1)
+	seen++;
+    if (j < seqlen)
+      continue;
+    for (orbit = 1, k = 0; k < seen; k++)
+      orbit *= (uint64_t)(colors - k);
+    covered += orbit * job.nseq;
+    job.secrets[job.nsec++] = i;
+  }
+  if (samples == 0 && (uint64_t)job.nsec * job.nseq > VERIFY_MAX)
+    samples = VERIFY_MAX;
+  pthread_mutex_init(&job.lock, NULL);
+
+  for (job.nm = 0, m = matchers; m->name != NULL && job.nm < VERIFY_MATCHERS; m++)
+    if (matcherFits(m)) {
+      job.first[job.nm] = ~0ULL;
+      job.m[job.nm++] = m;
+    }
+  job.samples = samples;
+  job.next = 0;
+  t0 = nowNs();
+  for (i = 0; i < nthreads; i++)
+    if (pthread_create(&tids[i], NULL, verifyThread, &job) != 0) {
+      fprintf(stderr, "Cannot create thread %d\n", i);
+      exit(EXIT_FAILURE);
+    }
+  for (i = 0; i < nthreads; i++)
+    pthread_join(tids[i], NULL);
+
+  for (k = 0; k < job.nm; k++) {
+    if (job.first[k] != ~0ULL) {
+      if (samples == 0) {
+	s = job.secrets[job.first[k] / job.nseq];
+	g = (int)(job.first[k] % job.nseq);
+      } else {	// replay the random numbers up to the failing sample
+	uint64_t rnd = (job.first[k] / SAMPLE_BLOCK + 1) * 0x9E3779B97F4A7C15ULL, r;
+
+	for (r = 0; r <= job.first[k] % SAMPLE_BLOCK; r++) {
+	  rnd ^= rnd << 13; rnd ^= rnd >> 7; rnd ^= rnd << 17;
+	}
+	s = (int)((rnd >> 32) % job.nseq);
+	g = (int)((rnd & 0xFFFFFFFF) % job.nseq);
+      }
+      secretPegs(&sp, job.seqs + (size_t)s * seqlen);
+      expected = refMatches(&sp, job.seqs + (size_t)g * seqlen);
+      fprintf(stdout, "** %s WRONG: secret ", job.m[k]->name);
+      printSeq(stdout, job.seqs + (size_t)s * seqlen);
+      fprintf(stdout, " guess ");
+      printSeq(stdout, job.seqs + (size_t)g * seqlen);
+      fprintf(stdout, ": result %d exact %d approximate, expected %d exact %d approximate\n",
+	      MATCH_EXACT(job.got[k]), MATCH_APPROX(job.got[k]), MATCH_EXACT(expected), MATCH_APPROX(expected));
+      errors++;
+    } else if (samples) {
+      fprintf(stdout, "__ %s OK on %llu random pairs (%d colours, length %d)\n",
+	      job.m[k]->name, (unsigned long long)samples, colors, seqlen);
+    } else {
+      fprintf(stdout, "__ %s OK on %llu (all) pairs (%d colours, length %d), by %d secrets up to relabelling\n",
+	      job.m[k]->name, (unsigned long long)covered, colors, seqlen, job.nsec);
+    }
+  }
+  if (verbose)
+    fprintf(stdout, "__ %d matchers in one pass over %llu pairs, %d threads, %.2f s\n", job.nm,
+	    (unsigned long long)(samples ? samples : (uint64_t)job.nsec * job.nseq), nthreads, (nowNs() - t0) / 1e9);
+
+  pthread_mutex_destroy(&job.lock);
+  free(job.seqs);
+  free(job.secrets);
+  return errors ? 1 : 0;
+}
 
 // +++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
 
+/* the Assembler version is only built on the Raspberry Pi; on other machines */
+/* the tests below compare the C version with the generic matcher instead     */
+#if defined(__arm__)
+#define OTHER_NAME "Asm"
+#define otherMatches matches
+#else
+#define OTHER_NAME "generic"
+#define otherMatches (matcherFind("generic")->fn)
+#endif
+
 int main (int argc, char **argv) {
-  int res, res_c, t, t_c, m, n;
+  int res, res_c, t, t_c;
   int *seq1, *seq2, *cpy1, *cpy2;
-  struct timeval t1, t2 ;
-  char str_in[20], str[20] = "some text";
+  uint64_t t1, t2 ;
   int verbose = 0, debug = 0, help = 0, opt_s = 0, opt_n = 0;
+  int bench = 0, kernel = 0, csv = 0, opt_r = BENCH_REPEATS, opt_w = BENCH_WARMUP;
+  int exhaustive = 0, opt_t = (int)sysconf(_SC_NPROCESSORS_ONLN);
+  int opt_l = SEQL, opt_k = COLS;
+  char *opt_i = NULL;
   
   // see: man 3 getopt for docu and an example of command line parsing
   { // see the CW spec for the intended meaning of these options
     int opt;
-    while ((opt = getopt(argc, argv, "hvs:n:")) != -1) {
+    while ((opt = getopt(argc, argv, "hvdbkces:n:r:w:i:t:g:")) != -1) {
       switch (opt) {
       case 'v':
 	verbose = 1;
@@ -87,24 +565,79 @@ int main (int argc, char **argv) {
       case 'n':
 	opt_n = atoi(optarg); 
 	break;
+      case 'b':
+	bench = 1;
+	break;
+      case 'k':
+	kernel = 1;
+	break;
+      case 'c':
+	csv = 1;
+	break;
+      case 'r':
+	opt_r = atoi(optarg);
+	break;
+      case 'w':
+	opt_w = atoi(optarg);
+	break;
+      case 'i':
+	opt_i = optarg;
+	break;
+      case 'e':
+	exhaustive = 1;
+	break;
+      case 't':
+	opt_t = atoi(optarg);
+	break;
+      case 'g':
+	if (sscanf(optarg, "%dx%d", &opt_l, &opt_k) != 2)
+	  opt_l = 0;
+	break;
       default: /* '?' */
 	fprintf(stderr, "Usage: %s [-h] [-v] [-s <seed>] [-n <no. of iterations>]  \n", argv[0]);
+	fprintf(stderr, "       %s -b [-c] [-g <length>x<colours>] [-s <seed>] [-n <pairs>] [-r <repeats>] [-w <warm-up rounds>] [-i same|hot|random|cold]\n", argv[0]);
+	fprintf(stderr, "       %s -k [-c] [-g <length>x<colours>] [-s <seed>] [-n <codes>] [-r <repeats>] [-w <warm-up rounds>]\n", argv[0]);
+	fprintf(stderr, "       %s -e [-v] [-g <length>x<colours>] [-t <threads>] [-n <random pairs, instead of all>]\n", argv[0]);
 	exit(EXIT_FAILURE);
       }
     }
   }
 
+  if (!matchSetSize(opt_l, opt_k)) {
+    fprintf(stderr, "Size must be <length>x<colours>, at most %dx%d\n", SEQL_MAX, COLS_MAX);
+    exit(EXIT_FAILURE);
+  }
+
+  if (bench) {
+    srand(opt_s != 0 ? opt_s : 1701);
+    if (opt_r < 1)
+      opt_r = 1;
+    exit(benchmark(opt_n > 0 ? opt_n : BENCH_PAIRS, opt_r, opt_w, opt_i, csv));
+  }
+
+  if (kernel) {
+    srand(opt_s != 0 ? opt_s : 1701);
+    if (opt_r < 1)
+      opt_r = 1;
+    exit(kernels(opt_n > 0 ? opt_n : KERNEL_CODES, opt_r, opt_w, csv));
+  }
+
+  if (exhaustive)
+    exit(verify(opt_t, opt_n > 0 ? (uint64_t)opt_n : 0, verbose));
+
+  // the tests below compare with the Assembler version, which only handles length 3
+  if (seqlen != 3) {
+    fprintf(stderr, "Other sizes (-g) are only for -b and -e\n");
+    exit(EXIT_FAILURE);
+  }
+
   seq1 = (int*)malloc(seqlen*sizeof(int));
   seq2 = (int*)malloc(seqlen*sizeof(int));
   cpy1 = (int*)malloc(seqlen*sizeof(int));
   cpy2 = (int*)malloc(seqlen*sizeof(int));
   
   if (argc > optind+1) {
-    strcpy(str_in, argv[optind]);
-    m = atoi(str_in);
-    strcpy(str_in, argv[optind+1]);
-    n = atoi(str_in);
-    fprintf(stderr, "Testing matches function with sequences %d and %d\n", m, n);
+    fprintf(stderr, "Testing matches function with sequences %s and %s\n", argv[optind], argv[optind+1]);
   } else {
     int i, j, n = 10, res, res_c, oks = 0, tot = 0; // number of test cases
     fprintf(stderr, "Running tests of matches function with %d pairs of random input sequences ...\n", n);
@@ -116,8 +649,8 @@ int main (int argc, char **argv) {
       srand(1701);
     for (i=0; i<n; i++) {
       for (j=0; j<seqlen; j++) {
-	seq1[j] = (rand() % seqlen + 1);
-	seq2[j] = (rand() % seqlen + 1);
+	seq1[j] = (rand() % colors + 1);
+	seq2[j] = (rand() % colors + 1);
       }
       memcpy(cpy1, seq1, seqlen*sizeof(int));
       memcpy(cpy2, seq2, seqlen*sizeof(int));
@@ -126,7 +659,7 @@ int main (int argc, char **argv) {
 	showSeq(seq1);
 	showSeq(seq2);
       }
-      res = matches(seq1, seq2);         // extern; code in matches.s
+      res = otherMatches(seq1, seq2);    // extern; code in matches.s
       memcpy(seq1, cpy1, seqlen*sizeof(int));
       memcpy(seq2, cpy2, seqlen*sizeof(int));
       res_c = countMatches(seq1, seq2);  // local C function
@@ -136,7 +669,7 @@ int main (int argc, char **argv) {
 	showSeq(seq2);
       }
       fprintf(stdout, "Matches (encoded) (in C):   %d\n", res_c);
-      fprintf(stdout, "Matches (encoded) (in Asm): %d\n", res);
+      fprintf(stdout, "Matches (encoded) (in " OTHER_NAME "): %d\n", res);
       memcpy(seq1, cpy1, seqlen*sizeof(int));
       memcpy(seq2, cpy2, seqlen*sizeof(int));
       showMatches(res_c, seq1, seq2, 0);
@@ -153,22 +686,19 @@ int main (int argc, char **argv) {
     exit(oks==tot ? 0 : 1);
   }    
 
-  readSeq(seq1, m);
-  readSeq(seq2, n);
+  readSeq(seq1, argv[optind]);
+  readSeq(seq2, argv[optind+1]);
 
   memcpy(cpy1, seq1, seqlen*sizeof(int));
   memcpy(cpy2, seq2, seqlen*sizeof(int));
   memcpy(seq1, cpy1, seqlen*sizeof(int));
   memcpy(seq2, cpy2, seqlen*sizeof(int));
     
-  gettimeofday (&t1, NULL) ;
+  // a single call is too short to time reliably; use -b for a benchmark
+  t1 = nowNs() ;
   res_c = countMatches(seq1, seq2);         // local C function
-  gettimeofday (&t2, NULL) ;
-  // d = difftime(t1,t2);
-  if (t2.tv_usec < t1.tv_usec)	// Counter wrapped
-    t_c = (1000000 + t2.tv_usec) - t1.tv_usec;
-  else
-    t_c = t2.tv_usec - t1.tv_usec ;
+  t2 = nowNs() ;
+  t_c = (int)(t2 - t1) ;
 
   if (debug) {
     fprintf(stdout, "DBG: sequences after matching:\n");	
@@ -178,14 +708,10 @@ int main (int argc, char **argv) {
   memcpy(seq1, cpy1, seqlen*sizeof(int));
   memcpy(seq2, cpy2, seqlen*sizeof(int));
   
-  gettimeofday (&t1, NULL) ;
-  res = matches(seq1, seq2);         // extern; code in hamming4.s
-  gettimeofday (&t2, NULL) ;
-  // d = difftime(t1,t2);
-  if (t2.tv_usec < t1.tv_usec)	// Counter wrapped
-    t = (1000000 + t2.tv_usec) - t1.tv_usec;
-  else
-    t = t2.tv_usec - t1.tv_usec ;
+  t1 = nowNs() ;
+  res = otherMatches(seq1, seq2);    // extern; code in mm-matches.s
+  t2 = nowNs() ;
+  t = (int)(t2 - t1) ;
 
   if (debug) {
     fprintf(stdout, "DBG: sequences after matching:\n");	
@@ -203,8 +729,8 @@ int main (int argc, char **argv) {
   } else {
     fprintf(stdout, "** result WRONG\n");
   }
-  fprintf(stderr, "C   version:\t\tresult=%d (elapsed time: %dms)\n", res_c, t_c);
-  fprintf(stderr, "Asm version:\t\tresult=%d (elapsed time: %dms)\n", res, t);
+  fprintf(stderr, "C   version:\t\tresult=%d (elapsed time: %dns)\n", res_c, t_c);
+  fprintf(stderr, OTHER_NAME " version:\t\tresult=%d (elapsed time: %dns)\n", res, t);
 
 
   return 0;